@@ -22,6 +22,9 @@
 
 namespace DirectX
 {
+    struct VertexPositionColorTexture;
+
+
     enum SpriteSortMode
     {
         SpriteSortMode_Deferred,
@@ -67,6 +70,14 @@ namespace DirectX
         void Draw(_In_ ID3D11ShaderResourceView* texture, RECT const& destinationRectangle, FXMVECTOR color = Colors::White);
         void Draw(_In_ ID3D11ShaderResourceView* texture, RECT const& destinationRectangle, _In_opt_ RECT const* sourceRectangle, FXMVECTOR color = Colors::White, float rotation = 0, XMFLOAT2 const& origin = Float2Zero, SpriteEffects effects = SpriteEffects_None, float layerDepth = 0);
 
+        // Fast path for callers that generate their own sprite vertices, skipping the sprite queue and sort.
+        // Any queued sprites are drawn first. The vertex buffer is then mapped in batches, and writeVertices
+        // fills in four vertices for each sprite: top left, top right, bottom left, bottom right, with the
+        // position in pixels and the texture coordinate normalized. Most efficient with SpriteSortMode_Immediate.
+        typedef std::function<void(_Out_ VertexPositionColorTexture* vertices, size_t firstSprite, size_t spriteCount)> VertexWriter;
+
+        void DrawVertices(_In_ ID3D11ShaderResourceView* texture, size_t spriteCount, VertexWriter const& writeVertices);
+
     private:
         // Private implementation.
         class Impl;
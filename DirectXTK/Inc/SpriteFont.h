@@ -15,18 +15,36 @@
 
 #include "SpriteBatch.h"
 
+#include <vector>
+
 
 namespace DirectX
 {
+    struct SpriteFontView;
+
+    // Creates the texture of a font that was parsed by ParseSpriteFont (see SpriteFontParser.h), for
+    // code that lays out and draws the font's glyphs itself rather than through a SpriteFont.
+    HRESULT CreateSpriteFontTexture(_In_ ID3D11Device* device, SpriteFontView const& view, _Outptr_ ID3D11ShaderResourceView** texture);
+
     class SpriteFont
     {
     public:
         struct Glyph;
+        class PreparedString;
+
+    private:
+        // Private implementation.
+        class Impl;
 
+    public:
         SpriteFont(_In_ ID3D11Device* device, _In_z_ wchar_t const* fileName);
         SpriteFont(_In_ ID3D11Device* device, _In_reads_bytes_(dataSize) uint8_t const* dataBlob, _In_ size_t dataSize);
         SpriteFont(_In_ ID3D11ShaderResourceView* texture, _In_reads_(glyphCount) Glyph const* glyphs, _In_ size_t glyphCount, _In_ float lineSpacing);
 
+        // Creates the texture for a font that was already parsed by ParseSpriteFont (see SpriteFontParser.h).
+        // Lets the file be read and parsed on another thread, leaving only the D3D work for the caller.
+        SpriteFont(_In_ ID3D11Device* device, SpriteFontView const& view);
+
         SpriteFont(SpriteFont&& moveFrom);
         SpriteFont& operator= (SpriteFont&& moveFrom);
         virtual ~SpriteFont();
@@ -38,6 +56,15 @@ namespace DirectX
 
         XMVECTOR MeasureString(_In_z_ wchar_t const* text) const;
 
+        // Lays out a string once so it can be drawn repeatedly without looking up its glyphs again.
+        // The result reuses its storage, so preparing into the same object each frame does not allocate.
+        // InputLagTimer now writes its timer's vertices directly with TimerTextRenderer, which prepares
+        // the string the same way. This stays as the SpriteFont path that TimerTextBenchmark measures it against.
+        void PrepareString(_In_z_ wchar_t const* text, _Out_ PreparedString* result) const;
+
+        // Draws a prepared string at each of the given positions, unrotated and unscaled.
+        void DrawPreparedString(_In_ SpriteBatch* spriteBatch, PreparedString const& text, _In_reads_(positionCount) XMFLOAT2 const* positions, _In_ size_t positionCount, FXMVECTOR color = Colors::White) const;
+
         float GetLineSpacing() const;
         void SetLineSpacing(float spacing);
 
@@ -58,10 +85,33 @@ namespace DirectX
         };
 
 
-    private:
-        // Private implementation.
-        class Impl;
+        // A string laid out by PrepareString. Only valid for the font that prepared it.
+        class PreparedString
+        {
+        public:
+            PreparedString();
+
+            // Same as MeasureString for the text that was prepared.
+            XMVECTOR GetSize() const;
+
+            size_t GetGlyphCount() const;
+
+        private:
+            friend class SpriteFont;
 
+            struct Entry
+            {
+                Glyph const* glyph;
+                XMFLOAT2 origin;
+            };
+
+            std::vector<Entry> entries;
+            XMFLOAT2 size;
+            Impl const* font;
+        };
+
+
+    private:
         std::unique_ptr<Impl> pImpl;
 
         static const XMFLOAT2 Float2Zero;
@@ -32,14 +32,6 @@ BinaryReader::BinaryReader(_In_z_ wchar_t const* fileName)
 }
 
 
-// Constructor reads from an existing memory buffer.
-BinaryReader::BinaryReader(_In_reads_bytes_(dataSize) uint8_t const* dataBlob, size_t dataSize)
-{
-    mPos = dataBlob;
-    mEnd = dataBlob + dataSize;
-}
-
-
 // Reads from the filesystem into memory.
 HRESULT BinaryReader::ReadEntireFile(_In_z_ wchar_t const* fileName, _Inout_ std::unique_ptr<uint8_t[]>& data, _Out_ size_t* dataSize)
 {
@@ -13,21 +13,48 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
 #include <memory>
 #include <exception>
+#include <stdexcept>
 #include <type_traits>
 
+#if defined(_WIN32)
 #include "PlatformHelpers.h"
+#else
+#include "PosixHelpers.h"
+#endif
+
+#include "FileMapping.h"
 
 
 namespace DirectX
 {
-    // Helper for reading binary data, either from the filesystem a memory buffer.
+    // Helper for reading binary data, either from the filesystem, a shared file mapping or a memory buffer.
+    // Reading from a mapping or memory buffer does not depend on Windows, so tools can use it on other platforms.
     class BinaryReader
     {
     public:
+#if defined(_WIN32)
         explicit BinaryReader(_In_z_ wchar_t const* fileName);
-        BinaryReader(_In_reads_bytes_(dataSize) uint8_t const* dataBlob, size_t dataSize);
+#endif
+
+        // Constructor reads from an existing memory buffer.
+        BinaryReader(_In_reads_bytes_(dataSize) uint8_t const* dataBlob, size_t dataSize)
+          : mPos(dataBlob),
+            mEnd(dataBlob + dataSize)
+        {
+        }
+
+        // Constructor reads straight from a file mapping, which is kept alive for as long as the reader.
+        // ReadArray returns pointers into the mapping, so nothing is copied.
+        explicit BinaryReader(std::shared_ptr<FileMapping> const& mapping)
+          : mPos(mapping->Data()),
+            mEnd(mapping->Data() + mapping->Size()),
+            mMapping(mapping)
+        {
+        }
 
         
         // Reads a single value.
@@ -45,7 +72,7 @@ namespace DirectX
             uint8_t const* newPos = mPos + sizeof(T) * elementCount;
 
             if (newPos > mEnd)
-                throw std::exception("End of file");
+                throw std::runtime_error("End of file");
 
             T const* result = reinterpret_cast<T const*>(mPos);
 
@@ -55,8 +82,10 @@ namespace DirectX
         }
 
 
+#if defined(_WIN32)
         // Lower level helper reads directly from the filesystem into memory.
         static HRESULT ReadEntireFile(_In_z_ wchar_t const* fileName, _Inout_ std::unique_ptr<uint8_t[]>& data, _Out_ size_t* dataSize);
+#endif
 
 
     private:
@@ -65,6 +94,7 @@ namespace DirectX
         uint8_t const* mEnd;
 
         std::unique_ptr<uint8_t[]> mOwnedData;
+        std::shared_ptr<FileMapping> mMapping;
 
 
         // Prevent copying.
@@ -0,0 +1,170 @@
+//--------------------------------------------------------------------------------------
+// File: FileMapping.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#if defined(_WIN32)
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+// PlatformHelpers.h, which BinaryReader.h and SharedResourcePool.h include on Windows, uses D3D types.
+#include <d3d11.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <stdexcept>
+
+#include "FileMapping.h"
+#include "BinaryReader.h"
+#include "SharedResourcePool.h"
+
+using namespace DirectX;
+
+
+// Store and Phone apps only have the desktop file mapping API from Windows 8.1 onwards.
+#if defined(_WIN32) && defined(WINAPI_FAMILY) && (WINAPI_FAMILY != WINAPI_FAMILY_DESKTOP_APP)
+#define FILE_MAPPING_READS_INSTEAD
+#endif
+
+
+static SharedResourcePool<FileMapping::PathString, FileMapping> mappingPool;
+
+
+std::shared_ptr<FileMapping> FileMapping::Open(PathString const& fileName)
+{
+    return mappingPool.DemandCreate(fileName);
+}
+
+
+#if defined(_WIN32)
+
+FileMapping::FileMapping(PathString const& fileName)
+  : mData(nullptr),
+    mSize(0),
+    mFile(INVALID_HANDLE_VALUE),
+    mMapping(nullptr)
+{
+#if defined(FILE_MAPPING_READS_INSTEAD)
+    ThrowIfFailed(
+        BinaryReader::ReadEntireFile(fileName.c_str(), mOwnedData, &mSize)
+    );
+
+    mData = mOwnedData.get();
+#else
+    mFile = CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (mFile == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to open file");
+
+    LARGE_INTEGER fileSize = { 0 };
+
+    // Files larger than the address space can only be mapped a view at a time.
+    if (!GetFileSizeEx(mFile, &fileSize) || static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX)
+    {
+        CloseHandle(mFile);
+        throw std::runtime_error("Failed to map file");
+    }
+
+    mSize = static_cast<size_t>(fileSize.QuadPart);
+
+    // Mapping an empty file fails, but there is nothing to read anyway.
+    if (mSize == 0)
+        return;
+
+    mMapping = CreateFileMappingW(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mMapping)
+    {
+        mData = static_cast<uint8_t const*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    }
+
+    if (!mData)
+    {
+        if (mMapping)
+            CloseHandle(mMapping);
+
+        CloseHandle(mFile);
+        throw std::runtime_error("Failed to map file");
+    }
+#endif
+}
+
+
+FileMapping::~FileMapping()
+{
+    if (mMapping)
+    {
+        UnmapViewOfFile(mData);
+        CloseHandle(mMapping);
+    }
+
+    if (mFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(mFile);
+    }
+}
+
+#else
+
+FileMapping::FileMapping(PathString const& fileName)
+  : mData(nullptr),
+    mSize(0)
+{
+    int descriptor = open(fileName.c_str(), O_RDONLY);
+
+    if (descriptor < 0)
+        throw std::runtime_error("Failed to open file");
+
+    struct stat status;
+
+    if (fstat(descriptor, &status) != 0)
+    {
+        close(descriptor);
+        throw std::runtime_error("Failed to map file");
+    }
+
+    mSize = (size_t)status.st_size;
+
+    // Mapping an empty file fails, but there is nothing to read anyway.
+    if (mSize > 0)
+    {
+        void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+        if (data == MAP_FAILED)
+        {
+            close(descriptor);
+            throw std::runtime_error("Failed to map file");
+        }
+
+        mData = static_cast<uint8_t const*>(data);
+    }
+
+    // The mapping keeps its own reference to the file.
+    close(descriptor);
+}
+
+
+FileMapping::~FileMapping()
+{
+    if (mData)
+    {
+        munmap(const_cast<uint8_t*>(mData), mSize);
+    }
+}
+
+#endif
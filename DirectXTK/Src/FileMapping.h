@@ -0,0 +1,67 @@
+//--------------------------------------------------------------------------------------
+// File: FileMapping.h
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <string>
+
+#if !defined(_WIN32)
+#include "PosixHelpers.h"
+#endif
+
+
+namespace DirectX
+{
+    // A read-only view of a whole file, mapped into memory with file mapping on Windows
+    // desktop and mmap elsewhere. Everyone who opens the same path while the mapping is
+    // alive shares it, and it is unmapped when the last reference goes away.
+    // Windows Store and Phone apps cannot map files, so there the file is read into memory once instead.
+    class FileMapping
+    {
+    public:
+#if defined(_WIN32)
+        typedef std::wstring PathString;
+#else
+        typedef std::string PathString;
+#endif
+
+        // Returns the existing mapping of the path, or maps it. Paths are compared exactly as given.
+        static std::shared_ptr<FileMapping> Open(PathString const& fileName);
+
+        // Maps the file. Use Open to share mappings.
+        explicit FileMapping(PathString const& fileName);
+        ~FileMapping();
+
+        uint8_t const* Data() const { return mData; }
+        size_t Size() const { return mSize; }
+
+
+    private:
+        uint8_t const* mData;
+        size_t mSize;
+
+#if defined(_WIN32)
+        void* mFile;
+        void* mMapping;
+        std::unique_ptr<uint8_t[]> mOwnedData;
+#endif
+
+
+        // Prevent copying.
+        FileMapping(FileMapping const&);
+        FileMapping& operator= (FileMapping const&);
+    };
+}
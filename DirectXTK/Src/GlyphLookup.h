@@ -0,0 +1,89 @@
+//--------------------------------------------------------------------------------------
+// File: GlyphLookup.h
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+
+
+namespace DirectX
+{
+    // Finds glyphs by codepoint in a glyph array sorted by Character. Characters in the
+    // dense low range are looked up in a flat table, and the rest by binary search.
+    // Has no D3D dependencies so it can be shared with tools that build off Windows.
+    template<typename TGlyph>
+    class GlyphLookup
+    {
+    public:
+        // Covers ASCII and Latin-1, which is everything the timer and HUD draw.
+        static const uint32_t DirectCount = 256;
+
+        GlyphLookup()
+        {
+            Reset(nullptr, nullptr);
+        }
+
+
+        // Indexes a sorted glyph array. The array must outlive the lookup.
+        void Reset(TGlyph const* begin, TGlyph const* end)
+        {
+            mBegin = begin;
+            mEnd = end;
+
+            std::fill(mDirect, mDirect + DirectCount, static_cast<TGlyph const*>(nullptr));
+
+            for (TGlyph const* glyph = begin; glyph != end; glyph++)
+            {
+                if (glyph->Character < DirectCount)
+                {
+                    mDirect[glyph->Character] = glyph;
+                }
+            }
+        }
+
+
+        // Returns nullptr if the character is not in the array.
+        TGlyph const* Find(uint32_t character) const
+        {
+            if (character < DirectCount)
+            {
+                return mDirect[character];
+            }
+
+            TGlyph const* glyph = std::lower_bound(mBegin, mEnd, character, CharacterLess());
+
+            if (glyph != mEnd && glyph->Character == character)
+            {
+                return glyph;
+            }
+
+            return nullptr;
+        }
+
+
+    private:
+        struct CharacterLess
+        {
+            bool operator() (TGlyph const& left, uint32_t right) const
+            {
+                return left.Character < right;
+            }
+        };
+
+        TGlyph const* mDirect[DirectCount];
+        TGlyph const* mBegin;
+        TGlyph const* mEnd;
+    };
+}
@@ -0,0 +1,21 @@
+//--------------------------------------------------------------------------------------
+// File: PosixHelpers.h
+//
+// Stand-ins for the Windows SDK pieces used by the DirectXTK sources that are also
+// built by the command line tools on other platforms.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#if !defined(_WIN32)
+
+// SAL annotations are only checked by the Microsoft compiler.
+#define _In_
+#define _In_z_
+#define _In_opt_
+#define _Out_
+#define _Inout_
+#define _In_reads_(count)
+#define _In_reads_bytes_(size)
+
+#endif
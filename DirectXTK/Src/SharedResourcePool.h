@@ -16,7 +16,11 @@
 #include <map>
 #include <memory>
 
+#if defined(_WIN32)
 #include "PlatformHelpers.h"
+#else
+#include <mutex>
+#endif
 
 
 namespace DirectX
@@ -76,9 +80,9 @@ namespace DirectX
         struct WrappedData : public TData
         {
             WrappedData(TKey key, std::shared_ptr<ResourceMap> const& resourceMap)
-              : mKey(key),
-                mResourceMap(resourceMap),
-                TData(key)
+              : TData(key),
+                mKey(key),
+                mResourceMap(resourceMap)
             { }
 
             ~WrappedData()
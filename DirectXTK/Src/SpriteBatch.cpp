@@ -38,6 +38,7 @@ public:
     void End();
 
     void Draw(_In_ ID3D11ShaderResourceView* texture, FXMVECTOR destination, _In_opt_ RECT const* sourceRectangle, FXMVECTOR color, FXMVECTOR originRotationDepth, int flags);
+    void DrawVertices(_In_ ID3D11ShaderResourceView* texture, size_t spriteCount, VertexWriter const& writeVertices);
 
 
     // Info about a single sprite that is waiting to be drawn.
@@ -68,6 +69,7 @@ private:
     void GrowSortedSprites();
 
     void RenderBatch(_In_ ID3D11ShaderResourceView* texture, _In_reads_(count) SpriteInfo const* const* sprites, size_t count);
+    void WriteBatches(size_t spriteCount, VertexWriter const& writeVertices);
 
     static void RenderSprite(_In_ SpriteInfo const* sprite, _Out_cap_c_(VerticesPerSprite) VertexPositionColorTexture* vertices, FXMVECTOR textureSize, FXMVECTOR inverseTextureSize);
 
@@ -463,6 +465,32 @@ void SpriteBatch::Impl::Draw(_In_ ID3D11ShaderResourceView* texture, FXMVECTOR d
 }
 
 
+// Draws sprites whose vertices are written by the caller, straight into the vertex buffer.
+void SpriteBatch::Impl::DrawVertices(_In_ ID3D11ShaderResourceView* texture, size_t spriteCount, VertexWriter const& writeVertices)
+{
+    if (!texture)
+        throw std::exception("Texture cannot be null");
+
+    if (!mInBeginEndPair)
+        throw std::exception("Begin must be called before DrawVertices");
+
+    if (!spriteCount)
+        return;
+
+    if (mSortMode != SpriteSortMode_Immediate)
+    {
+        // Keep the draw order: anything already queued goes first.
+        // That needs device state, which the other modes only set at End.
+        PrepareForRendering();
+        FlushBatch();
+    }
+
+    mContextResources->deviceContext->PSSetShaderResources(0, 1, &texture);
+
+    WriteBatches(spriteCount, writeVertices);
+}
+
+
 // Dynamically expands the array used to store pending sprite information.
 void SpriteBatch::Impl::GrowSpriteQueue()
 {
@@ -651,7 +679,30 @@ void SpriteBatch::Impl::RenderBatch(_In_ ID3D11ShaderResourceView* texture, _In_
 
     XMVECTOR textureSize = GetTextureSize(texture);
     XMVECTOR inverseTextureSize = XMVectorReciprocal(textureSize);
-            
+
+    WriteBatches(count, [&](VertexPositionColorTexture* vertices, size_t firstSprite, size_t batchSize)
+    {
+        // Generate sprite vertex data.
+        for (size_t i = 0; i < batchSize; i++)
+        {
+            assert(firstSprite + i < count);
+            _Analysis_assume_(firstSprite + i < count);
+            RenderSprite(sprites[firstSprite + i], vertices, textureSize, inverseTextureSize);
+
+            vertices += VerticesPerSprite;
+        }
+    });
+}
+
+
+// Maps the vertex buffer in as many batches as the sprites need, and draws each batch once it is written.
+void SpriteBatch::Impl::WriteBatches(size_t spriteCount, VertexWriter const& writeVertices)
+{
+    auto deviceContext = mContextResources->deviceContext.Get();
+
+    size_t firstSprite = 0;
+    size_t count = spriteCount;
+
     while (count > 0)
     {
         // How many sprites do we want to draw?
@@ -688,14 +739,7 @@ void SpriteBatch::Impl::RenderBatch(_In_ ID3D11ShaderResourceView* texture, _In_
         VertexPositionColorTexture* vertices = (VertexPositionColorTexture*)mappedBuffer.pData + mContextResources->vertexBufferPosition * VerticesPerSprite;
 
         // Generate sprite vertex data.
-        for (size_t i = 0; i < batchSize; i++)
-        {
-            assert(i < count);
-            _Analysis_assume_(i < count);
-            RenderSprite(sprites[i], vertices, textureSize, inverseTextureSize);
-
-            vertices += VerticesPerSprite;
-        }
+        writeVertices(vertices, firstSprite, batchSize);
 
         deviceContext->Unmap(mContextResources->vertexBuffer.Get(), 0);
 
@@ -708,7 +752,7 @@ void SpriteBatch::Impl::RenderBatch(_In_ ID3D11ShaderResourceView* texture, _In_
         // Advance the buffer position.
         mContextResources->vertexBufferPosition += batchSize;
 
-        sprites += batchSize;
+        firstSprite += batchSize;
         count -= batchSize;
     }
 }
@@ -996,3 +1040,9 @@ void SpriteBatch::Draw(_In_ ID3D11ShaderResourceView* texture, RECT const& desti
     
     pImpl->Draw(texture, destination, sourceRectangle, color, originRotationDepth, effects | Impl::SpriteInfo::DestSizeInPixels);
 }
+
+
+void SpriteBatch::DrawVertices(_In_ ID3D11ShaderResourceView* texture, size_t spriteCount, VertexWriter const& writeVertices)
+{
+    pImpl->DrawVertices(texture, spriteCount, writeVertices);
+}
@@ -19,6 +19,8 @@
 
 #include "SpriteFont.h"
 #include "BinaryReader.h"
+#include "GlyphLookup.h"
+#include "SpriteFontParser.h"
 
 using namespace DirectX;
 using namespace Microsoft::WRL;
@@ -28,7 +30,7 @@ using namespace Microsoft::WRL;
 class SpriteFont::Impl
 {
 public:
-    Impl(_In_ ID3D11Device* device, _In_ BinaryReader* reader);
+    Impl(_In_ ID3D11Device* device, SpriteFontView const& view);
     Impl(_In_ ID3D11ShaderResourceView* texture, _In_reads_(glyphCount) Glyph const* glyphs, _In_ size_t glyphCount, _In_ float lineSpacing);
 
     Glyph const* FindGlyph(wchar_t character) const;
@@ -42,6 +44,7 @@ public:
     // Fields.
     ComPtr<ID3D11ShaderResourceView> texture;
     std::vector<Glyph> glyphs;
+    GlyphLookup<Glyph> glyphLookup;
     Glyph const* defaultGlyph;
     float lineSpacing;
 };
@@ -50,7 +53,7 @@ public:
 // Constants.
 const XMFLOAT2 SpriteFont::Float2Zero(0, 0);
 
-static const char spriteFontMagic[] = "DXTKfont";
+static_assert(sizeof(SpriteFont::Glyph) == sizeof(SpriteFontView::Glyph), "SpriteFontView::Glyph must match SpriteFont::Glyph");
 
 
 // Comparison operators make our sorted glyph vector work with std::binary_search and lower_bound.
@@ -74,52 +77,58 @@ namespace DirectX
 
 
 // Reads a SpriteFont from the binary format created by the MakeSpriteFont utility.
-SpriteFont::Impl::Impl(_In_ ID3D11Device* device, _In_ BinaryReader* reader)
+SpriteFont::Impl::Impl(_In_ ID3D11Device* device, SpriteFontView const& view)
 {
-    // Validate the header.
-    for (char const* magic = spriteFontMagic; *magic; magic++)
-    {
-        if (reader->Read<uint8_t>() != *magic)
-        {
-            throw std::exception("Not a MakeSpriteFont output binary");
-        }
-    }
-
-    // Read the glyph data.
-    auto glyphCount = reader->Read<uint32_t>();
-    auto glyphData = reader->ReadArray<Glyph>(glyphCount);
+    // Copy the glyph data.
+    auto glyphData = reinterpret_cast<Glyph const*>(view.glyphs);
 
-    glyphs.assign(glyphData, glyphData + glyphCount);
+    glyphs.assign(glyphData, glyphData + view.glyphCount);
 
-    // Read font properties.
-    lineSpacing = reader->Read<float>();
+    glyphLookup.Reset(glyphs.data(), glyphs.data() + glyphs.size());
 
-    SetDefaultCharacter((wchar_t)reader->Read<uint32_t>());
+    // Font properties.
+    lineSpacing = view.lineSpacing;
 
-    // Read the texture data.
-    auto textureWidth = reader->Read<uint32_t>();
-    auto textureHeight = reader->Read<uint32_t>();
-    auto textureFormat = reader->Read<DXGI_FORMAT>();
-    auto textureStride = reader->Read<uint32_t>();
-    auto textureRows = reader->Read<uint32_t>();
-    auto textureData = reader->ReadArray<uint8_t>(textureStride * textureRows);
+    SetDefaultCharacter((wchar_t)view.defaultCharacter);
 
     // Create the D3D texture.
-    CD3D11_TEXTURE2D_DESC textureDesc(textureFormat, textureWidth, textureHeight, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
+    ThrowIfFailed(
+        CreateSpriteFontTexture(device, view, &texture)
+    );
+}
+
+
+// Creates the texture that a parsed font's glyphs are drawn from.
+HRESULT DirectX::CreateSpriteFontTexture(_In_ ID3D11Device* device, SpriteFontView const& view, _Outptr_ ID3D11ShaderResourceView** texture)
+{
+    if (!device || !texture)
+        return E_INVALIDARG;
+
+    *texture = nullptr;
+
+    auto textureFormat = (DXGI_FORMAT)view.textureFormat;
+
+    CD3D11_TEXTURE2D_DESC textureDesc(textureFormat, view.textureWidth, view.textureHeight, 1, 1, D3D11_BIND_SHADER_RESOURCE, D3D11_USAGE_IMMUTABLE);
     CD3D11_SHADER_RESOURCE_VIEW_DESC viewDesc(D3D11_SRV_DIMENSION_TEXTURE2D, textureFormat);
-    D3D11_SUBRESOURCE_DATA initData = { textureData, textureStride };
+    D3D11_SUBRESOURCE_DATA initData = { view.textureData, view.textureStride };
     ComPtr<ID3D11Texture2D> texture2D;
 
-    ThrowIfFailed(
-        device->CreateTexture2D(&textureDesc, &initData, &texture2D)
-    );
+    HRESULT hr = device->CreateTexture2D(&textureDesc, &initData, &texture2D);
+    if (FAILED(hr))
+        return hr;
 
-    ThrowIfFailed(
-        device->CreateShaderResourceView(texture2D.Get(), &viewDesc, &texture)
-    );
+    ComPtr<ID3D11ShaderResourceView> textureView;
 
-    SetDebugObjectName(texture.Get(),   "DirectXTK:SpriteFont");
-    SetDebugObjectName(texture2D.Get(), "DirectXTK:SpriteFont");
+    hr = device->CreateShaderResourceView(texture2D.Get(), &viewDesc, &textureView);
+    if (FAILED(hr))
+        return hr;
+
+    SetDebugObjectName(textureView.Get(), "DirectXTK:SpriteFont");
+    SetDebugObjectName(texture2D.Get(),   "DirectXTK:SpriteFont");
+
+    *texture = textureView.Detach();
+
+    return S_OK;
 }
 
 
@@ -134,17 +143,19 @@ SpriteFont::Impl::Impl(_In_ ID3D11ShaderResourceView* texture, _In_reads_(glyphC
     {
         throw std::exception("Glyphs must be in ascending codepoint order");
     }
+
+    glyphLookup.Reset(this->glyphs.data(), this->glyphs.data() + this->glyphs.size());
 }
 
 
 // Looks up the requested glyph, falling back to the default character if it is not in the font.
 SpriteFont::Glyph const* SpriteFont::Impl::FindGlyph(wchar_t character) const
 {
-    auto glyph = std::lower_bound(glyphs.begin(), glyphs.end(), character);
+    auto glyph = glyphLookup.Find(character);
 
-    if (glyph != glyphs.end() && glyph->Character == character)
+    if (glyph)
     {
-        return &*glyph;
+        return glyph;
     }
 
     if (defaultGlyph)
@@ -215,18 +226,31 @@ void SpriteFont::Impl::ForEachGlyph(_In_z_ wchar_t const* text, TAction action)
 // Construct from a binary file created by the MakeSpriteFont utility.
 SpriteFont::SpriteFont(_In_ ID3D11Device* device, _In_z_ wchar_t const* fileName)
 {
-    BinaryReader reader(fileName);
+    // Map the file rather than reading it into a heap copy. Fonts loaded at the same time share the mapping.
+    BinaryReader reader(FileMapping::Open(fileName));
+    SpriteFontView view;
+
+    ParseSpriteFont(&reader, &view);
 
-    pImpl.reset(new Impl(device, &reader));
+    pImpl.reset(new Impl(device, view));
 }
 
 
 // Construct from a binary blob created by the MakeSpriteFont utility and already loaded into memory.
 SpriteFont::SpriteFont(_In_ ID3D11Device* device, _In_reads_bytes_(dataSize) uint8_t const* dataBlob, _In_ size_t dataSize)
 {
-    BinaryReader reader(dataBlob, dataSize);
+    SpriteFontView view;
 
-    pImpl.reset(new Impl(device, &reader));
+    ParseSpriteFont(dataBlob, dataSize, &view);
+
+    pImpl.reset(new Impl(device, view));
+}
+
+
+// Construct from a font that was parsed earlier, possibly on another thread.
+SpriteFont::SpriteFont(_In_ ID3D11Device* device, SpriteFontView const& view)
+  : pImpl(new Impl(device, view))
+{
 }
 
 
@@ -346,6 +370,54 @@ XMVECTOR SpriteFont::MeasureString(_In_z_ wchar_t const* text) const
 }
 
 
+void SpriteFont::PrepareString(_In_z_ wchar_t const* text, _Out_ PreparedString* result) const
+{
+    XMVECTOR size = XMVectorZero();
+
+    result->entries.clear();
+    result->font = pImpl.get();
+
+    pImpl->ForEachGlyph(text, [&](Glyph const* glyph, float x, float y)
+    {
+        // Store the origin that DrawString would pass to SpriteBatch for this glyph.
+        PreparedString::Entry entry = { glyph, XMFLOAT2(-x, -(y + glyph->YOffset)) };
+
+        result->entries.push_back(entry);
+
+        float w = (float)(glyph->Subrect.right - glyph->Subrect.left);
+        float h = (float)(glyph->Subrect.bottom - glyph->Subrect.top) + glyph->YOffset;
+
+        h = std::max(h, pImpl->lineSpacing);
+
+        size = XMVectorMax(size, XMVectorSet(x + w, y + h, 0, 0));
+    });
+
+    XMStoreFloat2(&result->size, size);
+}
+
+
+void SpriteFont::DrawPreparedString(_In_ SpriteBatch* spriteBatch, PreparedString const& text, _In_reads_(positionCount) XMFLOAT2 const* positions, _In_ size_t positionCount, FXMVECTOR color) const
+{
+    if (text.entries.empty())
+        return;
+
+    if (text.font != pImpl.get())
+    {
+        throw std::exception("PreparedString was prepared by a different SpriteFont");
+    }
+
+    ID3D11ShaderResourceView* texture = pImpl->texture.Get();
+
+    for (size_t i = 0; i < positionCount; i++)
+    {
+        for (auto entry = text.entries.begin(); entry != text.entries.end(); ++entry)
+        {
+            spriteBatch->Draw(texture, positions[i], &entry->glyph->Subrect, color, 0, entry->origin);
+        }
+    }
+}
+
+
 float SpriteFont::GetLineSpacing() const
 {
     return pImpl->lineSpacing;
@@ -372,5 +444,24 @@ void SpriteFont::SetDefaultCharacter(wchar_t character)
 
 bool SpriteFont::ContainsCharacter(wchar_t character) const
 {
-    return std::binary_search(pImpl->glyphs.begin(), pImpl->glyphs.end(), character);
+    return pImpl->glyphLookup.Find(character) != nullptr;
+}
+
+
+SpriteFont::PreparedString::PreparedString()
+  : size(0, 0),
+    font(nullptr)
+{
+}
+
+
+XMVECTOR SpriteFont::PreparedString::GetSize() const
+{
+    return XMLoadFloat2(&size);
+}
+
+
+size_t SpriteFont::PreparedString::GetGlyphCount() const
+{
+    return entries.size();
 }
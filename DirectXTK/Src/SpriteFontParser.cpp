@@ -0,0 +1,170 @@
+//--------------------------------------------------------------------------------------
+// File: SpriteFontParser.cpp
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#if defined(_WIN32)
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#endif
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#endif
+// PlatformHelpers.h, which BinaryReader.h includes on Windows, uses D3D types.
+#include <d3d11.h>
+#endif
+
+#include "SpriteFontParser.h"
+
+#include <stdio.h>
+
+using namespace DirectX;
+
+
+static const char spriteFontMagic[] = "DXTKfont";
+
+static_assert(sizeof(SpriteFontView::Glyph) == 32, "SpriteFontView::Glyph must match the file layout");
+
+
+// Reads a SpriteFont from the binary format created by the MakeSpriteFont utility.
+void DirectX::ParseSpriteFont(_In_ BinaryReader* reader, _Out_ SpriteFontView* result)
+{
+    // Validate the header.
+    for (char const* magic = spriteFontMagic; *magic; magic++)
+    {
+        if (reader->Read<uint8_t>() != *magic)
+        {
+            throw std::runtime_error("Not a MakeSpriteFont output binary");
+        }
+    }
+
+    // Read the glyph data.
+    result->glyphCount = reader->Read<uint32_t>();
+    result->glyphs = reader->ReadArray<SpriteFontView::Glyph>(result->glyphCount);
+
+    // Read font properties.
+    result->lineSpacing = reader->Read<float>();
+    result->defaultCharacter = reader->Read<uint32_t>();
+
+    // Read the texture data.
+    result->textureWidth = reader->Read<uint32_t>();
+    result->textureHeight = reader->Read<uint32_t>();
+    result->textureFormat = reader->Read<uint32_t>();
+    result->textureStride = reader->Read<uint32_t>();
+    result->textureRows = reader->Read<uint32_t>();
+    result->textureData = reader->ReadArray<uint8_t>((size_t)result->textureStride * result->textureRows);
+}
+
+
+void DirectX::ParseSpriteFont(_In_reads_bytes_(dataSize) uint8_t const* data, size_t dataSize, _Out_ SpriteFontView* result)
+{
+    BinaryReader reader(data, dataSize);
+
+    ParseSpriteFont(&reader, result);
+}
+
+
+// Appends a formatted problem description.
+static void AddProblem(std::vector<std::string>* problems, char const* format, uint32_t a, uint32_t b = 0)
+{
+    char buffer[160];
+
+#if defined(_MSC_VER)
+    _snprintf_s(buffer, sizeof(buffer), _TRUNCATE, format, a, b);
+#else
+    snprintf(buffer, sizeof(buffer), format, a, b);
+#endif
+
+    problems->push_back(buffer);
+}
+
+
+bool DirectX::ValidateSpriteFont(SpriteFontView const& font, _Inout_ std::vector<std::string>* problems)
+{
+    size_t initialCount = problems->size();
+
+    if (font.glyphCount == 0)
+    {
+        problems->push_back("The font has no glyphs");
+    }
+
+    bool hasDefault = (font.defaultCharacter == 0);
+
+    for (uint32_t i = 0; i < font.glyphCount; i++)
+    {
+        SpriteFontView::Glyph const& glyph = font.glyphs[i];
+
+        // FindGlyph binary searches above the direct lookup range.
+        if (i > 0 && glyph.Character <= font.glyphs[i - 1].Character)
+        {
+            AddProblem(problems, "Glyph U+%04X is out of codepoint order", glyph.Character);
+        }
+
+        if (glyph.Subrect.left < 0 || glyph.Subrect.top < 0 ||
+            glyph.Subrect.right < glyph.Subrect.left || glyph.Subrect.bottom < glyph.Subrect.top ||
+            (uint32_t)glyph.Subrect.right > font.textureWidth || (uint32_t)glyph.Subrect.bottom > font.textureHeight)
+        {
+            AddProblem(problems, "Glyph U+%04X is not inside the %u pixel wide texture", glyph.Character, font.textureWidth);
+        }
+
+        if (glyph.Character == font.defaultCharacter)
+        {
+            hasDefault = true;
+        }
+    }
+
+    if (!hasDefault)
+    {
+        AddProblem(problems, "The default character U+%04X is not in the font", font.defaultCharacter);
+    }
+
+    if (!(font.lineSpacing > 0))
+    {
+        problems->push_back("The line spacing is not positive");
+    }
+
+    // The stride and rows that MakeSpriteFont writes for each format.
+    uint64_t minimumStride = 0;
+    uint32_t expectedRows = font.textureHeight;
+
+    switch (font.textureFormat)
+    {
+        case SpriteFontView::FormatR8G8B8A8:
+            minimumStride = (uint64_t)font.textureWidth * 4;
+            break;
+
+        case SpriteFontView::FormatB4G4R4A4:
+            minimumStride = (uint64_t)font.textureWidth * 2;
+            break;
+
+        case SpriteFontView::FormatBC2:
+            // 16 bytes per 4x4 block.
+            minimumStride = (uint64_t)(font.textureWidth + 3) / 4 * 16;
+            expectedRows = (font.textureHeight + 3) / 4;
+            break;
+
+        default:
+            AddProblem(problems, "Texture format %u is not one that MakeSpriteFont writes", font.textureFormat);
+            break;
+    }
+
+    if (minimumStride && font.textureStride < minimumStride)
+    {
+        AddProblem(problems, "The texture stride of %u bytes is too small for its width of %u", font.textureStride, font.textureWidth);
+    }
+
+    if (minimumStride && font.textureRows != expectedRows)
+    {
+        AddProblem(problems, "The texture has %u rows where %u were expected", font.textureRows, expectedRows);
+    }
+
+    return problems->size() == initialCount;
+}
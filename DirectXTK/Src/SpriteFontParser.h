@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------------------------
+// File: SpriteFontParser.h
+//
+// THIS CODE AND INFORMATION IS PROVIDED "AS IS" WITHOUT WARRANTY OF
+// ANY KIND, EITHER EXPRESSED OR IMPLIED, INCLUDING BUT NOT LIMITED TO
+// THE IMPLIED WARRANTIES OF MERCHANTABILITY AND/OR FITNESS FOR A
+// PARTICULAR PURPOSE.
+//
+// Copyright (c) Microsoft Corporation. All rights reserved.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "BinaryReader.h"
+
+
+namespace DirectX
+{
+    // The contents of a binary file created by the MakeSpriteFont utility, without any D3D objects.
+    // Every pointer refers into the data that was parsed, so the view is only valid while that data is.
+    struct SpriteFontView
+    {
+        // Same layout as SpriteFont::Glyph, with RECT spelled out so it builds off Windows.
+        struct Glyph
+        {
+            uint32_t Character;
+            struct
+            {
+                int32_t left;
+                int32_t top;
+                int32_t right;
+                int32_t bottom;
+            } Subrect;
+            float XOffset;
+            float YOffset;
+            float XAdvance;
+        };
+
+        // DXGI_FORMAT values written by MakeSpriteFont.
+        static const uint32_t FormatR8G8B8A8 = 28;
+        static const uint32_t FormatBC2 = 74;
+        static const uint32_t FormatB4G4R4A4 = 115;
+
+        Glyph const* glyphs;
+        uint32_t glyphCount;
+        float lineSpacing;
+        uint32_t defaultCharacter;
+
+        uint32_t textureWidth;
+        uint32_t textureHeight;
+        uint32_t textureFormat;
+        uint32_t textureStride;
+        uint32_t textureRows;
+        uint8_t const* textureData;
+    };
+
+
+    // Reads the header, glyphs and texture description. Throws if the data is not a MakeSpriteFont
+    // output or is cut short, but does not check that the contents make sense.
+    void ParseSpriteFont(_In_ BinaryReader* reader, _Out_ SpriteFontView* result);
+    void ParseSpriteFont(_In_reads_bytes_(dataSize) uint8_t const* data, size_t dataSize, _Out_ SpriteFontView* result);
+
+    // Checks what SpriteFont relies on but does not verify at load time: glyph order,
+    // subrects inside the texture, the default character and the texture size.
+    // Returns true if there were no problems; otherwise each problem is appended to problems.
+    bool ValidateSpriteFont(SpriteFontView const& font, _Inout_ std::vector<std::string>* problems);
+}
@@ -0,0 +1,340 @@
+/*
+ * Drives InputLagTimer's frame loop for a number of virtual outputs, with the real models and
+ * OutputRenderer drawing through NullRenderBackend, and reports the CPU time, device calls and heap
+ * allocations per frame. Fails if a loop allocates once the loop has settled, or if a frame shows the error screen.
+ * With a trace file, the measured loops' trace zones are written to it as a Chrome trace.
+ * This file builds on Windows and Linux, so it only uses the parts of DirectXTK that have no D3D dependency.
+ * Usage: FrameLoopBenchmark [outputs] [frames] [font directory] [trace file]
+ */
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+#include "FileMapping.h"
+#include "SpriteFontParser.h"
+#include "AllocationTracker.h"
+#include "Clock.h"
+#include "Config.h"
+#include "FontFace.h"
+#include "FrameLoop.h"
+#include "NullRenderBackend.h"
+#include "OutputRenderer.h"
+#include "TimerTextRenderer.h"
+#include "TimingSession.h"
+#include "TraceZones.h"
+
+static const int DEFAULT_OUTPUTS = 2;
+static const int DEFAULT_FRAMES = 20000;
+static const char* DEFAULT_FONT_DIRECTORY = "../InputLagTimer/res/fonts/";
+static const unsigned int OUTPUT_WIDTH = 3840;
+static const unsigned int OUTPUT_HEIGHT = 2160;
+static const unsigned int REFRESH_NUMERATOR = 60;
+static const unsigned int REFRESH_DENOMINATOR = 1;
+/* The failsafes, in seconds, for the benchmark's loops: high enough that a loop that is preempted does not show the error screen */
+static const double FAILSAFE_SECONDS = 1.0;
+
+/**
+ * A mapped and parsed font. The texture handle is the font's texture data, which NullRenderBackend never reads.
+ */
+struct Font
+{
+  std::shared_ptr<DirectX::FileMapping> data;
+  DirectX::SpriteFontView view;
+  std::unique_ptr<FontFace> face;
+};
+
+/**
+ * Maps and parses a font, the same way FontLoader does.
+ * @return NULL with a message on stderr if the file can't be loaded.
+ */
+static Font* loadFont(const std::string& path)
+{
+  std::unique_ptr<Font> font(new Font());
+  try
+  {
+#if defined(_WIN32)
+    font->data = DirectX::FileMapping::Open(std::wstring(path.begin(), path.end()));
+#else
+    font->data = DirectX::FileMapping::Open(path);
+#endif
+    DirectX::BinaryReader reader(font->data);
+    DirectX::ParseSpriteFont(&reader, &font->view);
+  }
+  catch(const std::exception& e)
+  {
+    fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+    return NULL;
+  }
+  font->face.reset(new FontFace(font->view, font->view.textureData));
+  return font.release();
+}
+
+/**
+ * @return the paths of the .spritefont files in directory, sorted by name as FontLoader sorts them.
+ */
+static std::vector<std::string> listFonts(const std::string& directory)
+{
+  std::vector<std::string> names;
+#if defined(_WIN32)
+  WIN32_FIND_DATAA findData;
+  HANDLE find = FindFirstFileA((directory + "*.spritefont").c_str(), &findData);
+  if(find != INVALID_HANDLE_VALUE)
+  {
+    do
+    {
+      names.push_back(findData.cFileName);
+    }
+    while(FindNextFileA(find, &findData) != 0);
+    FindClose(find);
+  }
+#else
+  DIR* dir = opendir(directory.c_str());
+  if(dir != NULL)
+  {
+    for(dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir))
+    {
+      std::string name = entry->d_name;
+      if(name.size() > 11 && name.compare(name.size() - 11, 11, ".spritefont") == 0)
+      {
+        names.push_back(name);
+      }
+    }
+    closedir(dir);
+  }
+#endif
+
+  std::sort(names.begin(), names.end());
+  for(auto iter = names.begin(); iter != names.end(); ++iter)
+  {
+    *iter = directory + *iter;
+  }
+  return names;
+}
+
+/**
+ * A virtual output: what a Window holds for the frame loop, with a null backend in place of its swap chain.
+ */
+struct VirtualOutput
+{
+  /** Owned by the session */
+  Model* model;
+  NullRenderBackend* backend;
+  OutputRenderer* renderer;
+  OutputRenderer::Output output;
+};
+
+/**
+ * The virtual outputs, rendered one after another as WindowManager renders its windows without a frame scheduler.
+ */
+class VirtualOutputs : public FrameLoop::Outputs
+{
+public:
+  explicit VirtualOutputs(const std::vector<VirtualOutput>& outputs)
+    :mOutputs(outputs)
+  {
+  }
+
+  virtual int processCommands()
+  {
+    return 0;
+  }
+
+  virtual void renderOutputs()
+  {
+    for(auto iter = mOutputs.begin(); iter != mOutputs.end(); ++iter)
+    {
+      iter->renderer->renderFrame(iter->model, iter->output);
+    }
+  }
+
+private:
+  const std::vector<VirtualOutput>& mOutputs;
+};
+
+int main(int argc, char* argv[])
+{
+  int outputCount = argc > 1 ? atoi(argv[1]) : DEFAULT_OUTPUTS;
+  int frames = argc > 2 ? atoi(argv[2]) : DEFAULT_FRAMES;
+  if(outputCount <= 0 || frames <= 0)
+  {
+    fprintf(stderr, "Usage: FrameLoopBenchmark [outputs] [frames] [font directory] [trace file]\n");
+    return 1;
+  }
+  std::string fontDirectory = argc > 3 ? argv[3] : DEFAULT_FONT_DIRECTORY;
+  std::string tracePath = argc > 4 ? argv[4] : "";
+  if(fontDirectory[fontDirectory.size() - 1] != '/' && fontDirectory[fontDirectory.size() - 1] != '\\')
+  {
+    fontDirectory += '/';
+  }
+
+  std::vector<Font*> timerFonts;
+  std::vector<TimerTextRenderer*> timerTexts;
+  std::vector<std::string> paths = listFonts(fontDirectory + "timer/");
+  for(auto iter = paths.begin(); iter != paths.end(); ++iter)
+  {
+    Font* font = loadFont(*iter);
+    if(font)
+    {
+      timerFonts.push_back(font);
+      timerTexts.push_back(new TimerTextRenderer(font->face.get()));
+    }
+  }
+  std::unique_ptr<Font> normalFont(loadFont(fontDirectory + "normal.spritefont"));
+  if(timerFonts.empty() || !normalFont)
+  {
+    fprintf(stderr, "No fonts in %s\n", fontDirectory.c_str());
+    return 1;
+  }
+
+  /* The failsafes are there to catch a display that is not keeping up, and would only catch the tool being preempted.
+     Set from the start, since an error raised by the first loops, which lay everything out, would last into the measured ones. */
+  Config::applyBaseline(0.0, 0.0);
+  Config::longestFrameTime = FAILSAFE_SECONDS;
+  Config::highestRenderVariance = FAILSAFE_SECONDS;
+
+  TraceZones::registerThread("main");
+  Clock* clock = Clock::getSystemClock();
+  /* One writer, since every output renders on this thread */
+  std::vector<TimingSession::OutputSetting> settings;
+  for(int i = 0; i < outputCount; ++i)
+  {
+    TimingSession::OutputSetting setting;
+    setting.refreshNumerator = REFRESH_NUMERATOR;
+    setting.refreshDenominator = REFRESH_DENOMINATOR;
+    setting.writer = 0;
+    settings.push_back(setting);
+  }
+  TimingSession session(clock, clock->getCount(), settings);
+  std::vector<VirtualOutput> outputs;
+  for(int i = 0; i < outputCount; ++i)
+  {
+    VirtualOutput output;
+    output.model = session.getModel(i);
+    output.backend = new NullRenderBackend();
+    output.renderer = new OutputRenderer(output.backend, timerTexts, normalFont->face.get());
+    output.output.number = i + 1;
+    output.output.count = outputCount;
+    output.output.width = OUTPUT_WIDTH;
+    output.output.height = OUTPUT_HEIGHT;
+    output.output.refreshNumerator = REFRESH_NUMERATOR;
+    output.output.refreshDenominator = REFRESH_DENOMINATOR;
+    output.output.layoutWidth = OUTPUT_WIDTH;
+    output.output.layoutHeight = OUTPUT_HEIGHT;
+    outputs.push_back(output);
+  }
+
+  /* WindowManager::render's loop, without a frame scheduler. The warmup loops lay the columns out and are not measured,
+     and every measured loop is a steady state one, since nothing changes between them. */
+  VirtualOutputs virtualOutputs(outputs);
+  FrameLoop frameLoop(&session, &virtualOutputs);
+  for(uint64_t i = 0; i < FrameLoop::WARMUP_LOOPS; ++i)
+  {
+    frameLoop.run();
+  }
+  for(auto iter = outputs.begin(); iter != outputs.end(); ++iter)
+  {
+    iter->backend->resetCounters();
+  }
+  if(!tracePath.empty())
+  {
+    TraceZones::start();
+  }
+
+  AllocationTracker::Counts allocations[AllocationTracker::SUBSYSTEM_COUNT];
+  memset(allocations, 0, sizeof(allocations));
+  uint64_t start = clock->getCount();
+  for(int frame = 0; frame < frames; ++frame)
+  {
+    frameLoop.run();
+    for(int i = 0; i < AllocationTracker::SUBSYSTEM_COUNT; ++i)
+    {
+      AllocationTracker::Counts counts = AllocationTracker::getFrameCounts(static_cast<AllocationTracker::Subsystem>(i));
+      allocations[i].allocations += counts.allocations;
+      allocations[i].bytes += counts.bytes;
+    }
+  }
+  double seconds = static_cast<double>(clock->getCount() - start) / clock->getFrequency();
+  if(!tracePath.empty())
+  {
+    TraceZones::stop();
+  }
+
+  NullRenderBackend::Counters total;
+  memset(&total, 0, sizeof(total));
+  for(auto iter = outputs.begin(); iter != outputs.end(); ++iter)
+  {
+    const NullRenderBackend::Counters& counters = iter->backend->getCounters();
+    total.stateChanges += counters.stateChanges;
+    total.drawCalls += counters.drawCalls;
+    total.clears += counters.clears;
+    total.maps += counters.maps;
+    total.bytesMapped += counters.bytesMapped;
+    total.allocations += counters.allocations;
+    total.presents += counters.presents;
+  }
+
+  /* Per output frame, which is what a Window renders; a loop renders one for every output */
+  double outputFrames = static_cast<double>(frames) * outputCount;
+  printf("%d outputs of %ux%u, %d timer fonts, %d loops\n", outputCount, OUTPUT_WIDTH, OUTPUT_HEIGHT, static_cast<int>(timerFonts.size()), frames);
+  printf("%12.0f ns/loop\n", seconds * 1000000000.0 / frames);
+  printf("%12.0f ns/frame\n", seconds * 1000000000.0 / outputFrames);
+  printf("per frame:\n");
+  printf("%12.2f state changes\n", total.stateChanges / outputFrames);
+  printf("%12.2f draw calls\n", total.drawCalls / outputFrames);
+  printf("%12.2f clears\n", total.clears / outputFrames);
+  printf("%12.2f maps\n", total.maps / outputFrames);
+  printf("%12.0f bytes mapped\n", total.bytesMapped / outputFrames);
+  printf("%12.2f buffer allocations\n", total.allocations / outputFrames);
+  printf("%12.2f presents\n", total.presents / outputFrames);
+  /* A frame with an error clears again for the error screen */
+  uint64_t errorFrames = total.clears - total.presents;
+  printf("%12llu frames showed the error screen\n", static_cast<unsigned long long>(errorFrames));
+
+  /* Per loop, since the loop is what is held to being allocation free */
+  printf("heap allocations per loop:\n");
+  for(int i = AllocationTracker::SUBSYSTEM_FRAME_LOOP; i < AllocationTracker::SUBSYSTEM_COUNT; ++i)
+  {
+    printf("%12.2f (%.0f bytes) %s\n", static_cast<double>(allocations[i].allocations) / frames,
+      static_cast<double>(allocations[i].bytes) / frames, AllocationTracker::getSubsystemName(static_cast<AllocationTracker::Subsystem>(i)));
+  }
+  uint64_t allocatingLoops = AllocationTracker::getSteadyStateAllocatingFrameCount();
+  printf("%12llu loops allocated\n", static_cast<unsigned long long>(allocatingLoops));
+
+  if(!tracePath.empty())
+  {
+    if(!TraceZones::exportChromeTrace(tracePath))
+    {
+      fprintf(stderr, "Could not write %s\n", tracePath.c_str());
+      return 1;
+    }
+    printf("trace written to %s, %llu zones dropped\n", tracePath.c_str(), static_cast<unsigned long long>(TraceZones::getDroppedCount()));
+  }
+
+  for(auto iter = outputs.begin(); iter != outputs.end(); ++iter)
+  {
+    delete iter->renderer;
+    delete iter->backend;
+  }
+  for(size_t i = 0; i < timerFonts.size(); ++i)
+  {
+    delete timerTexts[i];
+    delete timerFonts[i];
+  }
+  if(errorFrames > 0)
+  {
+    return 3;
+  }
+  return allocatingLoops > 0 ? 2 : 0;
+}
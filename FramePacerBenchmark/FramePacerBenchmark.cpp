@@ -0,0 +1,104 @@
+/*
+ * Measures how precisely FramePacer starts frames at the rates InputLagTimer can be paced to.
+ * Usage: FramePacerBenchmark [seconds per rate] [rate in Hz]...
+ * Without rates, 1000, 2000, 4000 and 8000Hz are measured, for 2 seconds each.
+ * Exits with 1 if the pacer spun for more of its waiting than its spin margin calls for at any rate.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "Clock.h"
+#include "FramePacer.h"
+#include "Histogram.h"
+
+static const int DEFAULT_SECONDS = 2;
+static const int DEFAULT_RATES[] = { 1000, 2000, 4000, 8000 };
+static const int CALIBRATION_SLEEPS = 20;
+/* The share of waiting that may be spent spinning, at rates slow enough for the widest spin margin to leave time to sleep */
+static const double MAX_SPIN_FRACTION = 0.5;
+
+/**
+ * Paces empty frames at rate for the given time, the same way InputLagTimer's render loop does,
+ * and prints the distribution of how late each wait woke.
+ * @return false if the spin margin grew past its cap, or the pacer spun for more of the waiting than it allowed for.
+ */
+static bool benchmarkRate(Clock* clock, int rate, int seconds)
+{
+  FramePacer pacer(clock);
+  pacer.calibrate(CALIBRATION_SLEEPS);
+
+  uint64_t frequency = clock->getFrequency();
+  uint64_t frameInterval = frequency / rate;
+  uint64_t start = clock->getCount();
+  uint64_t end = start + frequency * seconds;
+  uint64_t nextFrameCount = start;
+  uint64_t frameCount = 0;
+  uint64_t now = start;
+  while(static_cast<int64_t>(end - now) > 0)
+  {
+    now = pacer.waitUntil(nextFrameCount);
+    nextFrameCount += frameInterval;
+    ++frameCount;
+  }
+
+  Percentiles wakeErrors;
+  wakeErrors.fromNanoseconds(pacer.getWakeErrors());
+  double elapsed = static_cast<double>(now - start) / frequency;
+  printf("%6dHz %8llu frames %9.1fHz %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f %5.0f%%\n",
+    rate, (unsigned long long)frameCount, frameCount / elapsed,
+    wakeErrors.p50 * 1000000.0, wakeErrors.p90 * 1000000.0, wakeErrors.p99 * 1000000.0,
+    wakeErrors.p999 * 1000000.0, wakeErrors.max * 1000000.0,
+    pacer.getSpinMargin() * 1000000.0 / frequency, pacer.getSpinFraction() * 100.0);
+
+  /* Each wait spins for at most the margin and whatever the sleep was rounded down by, so a pacer
+     that spins for more than that share of the interval has stopped sleeping when it could have */
+  double spinBound = static_cast<double>(pacer.getMaxSpinMargin() + pacer.getSleepGranularity()) / frameInterval;
+  spinBound = spinBound > MAX_SPIN_FRACTION ? spinBound : MAX_SPIN_FRACTION;
+  if(pacer.getSpinMargin() > pacer.getMaxSpinMargin())
+  {
+    printf("  FAILED: the spin margin grew past its cap of %.1fus\n", pacer.getMaxSpinMargin() * 1000000.0 / frequency);
+    return false;
+  }
+  if(pacer.getSpinFraction() > spinBound)
+  {
+    printf("  FAILED: more than %.0f%% of waiting was spent spinning\n", spinBound * 100.0);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  int seconds = argc > 1 ? atoi(argv[1]) : DEFAULT_SECONDS;
+  if(seconds <= 0)
+  {
+    fprintf(stderr, "Usage: FramePacerBenchmark [seconds per rate] [rate in Hz]...\n");
+    return 1;
+  }
+
+  std::vector<int> rates;
+  for(int i = 2; i < argc; ++i)
+  {
+    int rate = atoi(argv[i]);
+    if(rate <= 0)
+    {
+      fprintf(stderr, "Rates must be positive: %s\n", argv[i]);
+      return 1;
+    }
+    rates.push_back(rate);
+  }
+  if(rates.empty())
+  {
+    rates.assign(DEFAULT_RATES, DEFAULT_RATES + sizeof(DEFAULT_RATES) / sizeof(DEFAULT_RATES[0]));
+  }
+
+  Clock* clock = Clock::getSystemClock();
+  printf("Wake-up error in microseconds, %d seconds per rate\n", seconds);
+  printf("%8s %15s %11s %8s %8s %8s %8s %8s %8s %6s\n", "target", "", "achieved", "p50", "p90", "p99", "p99.9", "max", "margin", "spin");
+  bool passed = true;
+  for(auto iter = rates.begin(); iter != rates.end(); ++iter)
+  {
+    passed = benchmarkRate(clock, *iter, seconds) && passed;
+  }
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,171 @@
+/*
+ * Measures the spread of the timer samples between outputs, with the outputs rendered one after
+ * another as WindowManager does by default, and released together by FrameScheduler.
+ * The devices are mocks that spin on the counter for as long as an output takes to render and present.
+ * Usage: FrameSchedulerBenchmark [frames] [outputs] [render time per output in us]
+ * Returns 1 if the scheduled outputs' samples differed, or if the lanes did not start together.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+#include "Clock.h"
+#include "FrameScheduler.h"
+#include "Histogram.h"
+
+static const int DEFAULT_FRAMES = 2000;
+static const int DEFAULT_OUTPUTS = 4;
+static const int DEFAULT_RENDER_US = 200;
+/* The lanes have started together if half of the frames released them closer than this fraction of one output's render time */
+static const double MAX_RELEASE_SPREAD = 0.5;
+
+/**
+ * Stands in for one device with one output: takes the timer sample it is given, and then spins
+ * for as long as the output takes to render and present.
+ */
+class MockDevice
+{
+public:
+  MockDevice(Clock* clock, uint64_t renderCounts)
+    :mClock(clock),
+    mRenderCounts(renderCounts),
+    mSample(0)
+  {
+  }
+
+  void render(uint64_t sample)
+  {
+    mSample = sample;
+    uint64_t start = mClock->getCount();
+    while(mClock->getCount() - start < mRenderCounts)
+    {
+    }
+  }
+
+  uint64_t getSample() const
+  {
+    return mSample;
+  }
+
+private:
+  Clock* mClock;
+  uint64_t mRenderCounts;
+  uint64_t mSample;
+};
+
+/**
+ * Records the spread between the earliest and latest of the devices' samples for the last frame.
+ */
+static void recordSampleSpread(const std::vector<MockDevice*>& devices, uint64_t frequency, Histogram* spreads)
+{
+  uint64_t earliest = devices[0]->getSample();
+  uint64_t latest = earliest;
+  for(auto iter = devices.begin(); iter != devices.end(); ++iter)
+  {
+    earliest = (*iter)->getSample() < earliest ? (*iter)->getSample() : earliest;
+    latest = (*iter)->getSample() > latest ? (*iter)->getSample() : latest;
+  }
+  spreads->record(static_cast<uint64_t>((latest - earliest) * 1000000000.0 / frequency + 0.5));
+}
+
+static void printSpreads(const char* name, const Histogram& spreads, double seconds, int frames)
+{
+  Percentiles percentiles;
+  percentiles.fromNanoseconds(spreads);
+  printf("%-22s %9.1f %9.1f %9.1f %9.1f %10.1f\n", name,
+    percentiles.p50 * 1000000.0, percentiles.p99 * 1000000.0, percentiles.max * 1000000.0,
+    seconds * 1000000.0 / frames, frames / seconds);
+}
+
+int main(int argc, char* argv[])
+{
+  int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+  int outputs = argc > 2 ? atoi(argv[2]) : DEFAULT_OUTPUTS;
+  int renderUs = argc > 3 ? atoi(argv[3]) : DEFAULT_RENDER_US;
+  if(frames <= 0 || outputs <= 0 || renderUs < 0)
+  {
+    fprintf(stderr, "Usage: FrameSchedulerBenchmark [frames] [outputs] [render time per output in us]\n");
+    return 1;
+  }
+
+  Clock* clock = Clock::getSystemClock();
+  uint64_t frequency = clock->getFrequency();
+  uint64_t renderCounts = frequency * renderUs / 1000000;
+  std::vector<MockDevice*> devices;
+  for(int i = 0; i < outputs; ++i)
+  {
+    devices.push_back(new MockDevice(clock, renderCounts));
+  }
+
+  printf("%d frames, %d outputs, %dus to render each\n", frames, outputs, renderUs);
+  printf("%-22s %9s %9s %9s %9s %10s\n", "spread in us", "p50", "p99", "max", "frame us", "frames/s");
+
+  /* Each output samples the counter when it starts rendering, after the outputs before it have rendered */
+  Histogram serialSpreads;
+  uint64_t start = clock->getCount();
+  for(int frame = 0; frame < frames; ++frame)
+  {
+    for(auto iter = devices.begin(); iter != devices.end(); ++iter)
+    {
+      (*iter)->render(clock->getCount());
+    }
+    recordSampleSpread(devices, frequency, &serialSpreads);
+  }
+  printSpreads("serial samples", serialSpreads, static_cast<double>(clock->getCount() - start) / frequency, frames);
+
+  /* One lane per device, all released on the scheduler's shared sample */
+  std::vector<FrameScheduler::Lane> lanes;
+  for(auto iter = devices.begin(); iter != devices.end(); ++iter)
+  {
+    MockDevice* device = *iter;
+    lanes.push_back([device](uint64_t sharedCount)
+    {
+      device->render(sharedCount);
+    });
+  }
+  Histogram scheduledSpreads;
+  Histogram releaseSpreads;
+  double scheduledSeconds = 0.0;
+  {
+    FrameScheduler scheduler(clock, lanes);
+    start = clock->getCount();
+    for(int frame = 0; frame < frames; ++frame)
+    {
+      scheduler.runFrame();
+      recordSampleSpread(devices, frequency, &scheduledSpreads);
+      releaseSpreads.record(static_cast<uint64_t>(scheduler.getLastReleaseSpread() * 1000000000.0 + 0.5));
+    }
+    scheduledSeconds = static_cast<double>(clock->getCount() - start) / frequency;
+  }
+  printSpreads("scheduled samples", scheduledSpreads, scheduledSeconds, frames);
+  printSpreads("scheduled lane starts", releaseSpreads, scheduledSeconds, frames);
+
+  bool passed = true;
+  if(scheduledSpreads.getMax() != 0)
+  {
+    printf("FAILED: the scheduled outputs were given different samples\n");
+    passed = false;
+  }
+
+  /* Lanes can only start together if each has a core of its own, alongside the thread releasing them */
+  unsigned int cores = std::thread::hardware_concurrency();
+  if(cores > static_cast<unsigned int>(outputs))
+  {
+    double maxReleaseSpreadNs = renderUs * 1000.0 * MAX_RELEASE_SPREAD;
+    if(static_cast<double>(releaseSpreads.getValueAtPercentile(50.0)) > maxReleaseSpreadNs)
+    {
+      printf("FAILED: the lanes started more than %.1fus apart in half of the frames\n", maxReleaseSpreadNs / 1000.0);
+      passed = false;
+    }
+  }
+  else
+  {
+    printf("The lane starts were not checked: %u cores cannot run %d lanes at once\n", cores, outputs);
+  }
+
+  for(auto iter = devices.begin(); iter != devices.end(); ++iter)
+  {
+    delete *iter;
+  }
+  return passed ? 0 : 1;
+}
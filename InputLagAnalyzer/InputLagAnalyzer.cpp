@@ -0,0 +1,150 @@
+/*
+ * Summarises a timing log written by InputLagTimer when [TELEMETRY] is enabled.
+ * Usage: InputLagAnalyzer [-j threads] timing.bin
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "Clock.h"
+#include "FileMapping.h"
+#include "TimingAnalysis.h"
+
+static void printUsage()
+{
+  fprintf(stderr, "Usage: InputLagAnalyzer [-j threads] timing.bin\n");
+}
+
+static void printRow(const char* name, const Histogram& histogram)
+{
+  Percentiles percentiles;
+  percentiles.fromNanoseconds(histogram);
+  printf("  %-16s %10.3f %10.3f %10.3f %10.3f %10.3f\n", name,
+         percentiles.p50 * 1000.0, percentiles.p90 * 1000.0, percentiles.p99 * 1000.0,
+         percentiles.p999 * 1000.0, percentiles.max * 1000.0);
+}
+
+static void printReport(const TimingAnalysis& analysis)
+{
+  const TelemetryFileHeader& header = analysis.getHeader();
+  printf("%llu records from %u outputs, counter at %llu Hz\n",
+         static_cast<unsigned long long>(analysis.getRecordCount()), header.outputCount,
+         static_cast<unsigned long long>(header.frequency));
+  if(analysis.getInvalidRecordCount() > 0)
+  {
+    printf("%llu records had an invalid output index and were skipped\n",
+           static_cast<unsigned long long>(analysis.getInvalidRecordCount()));
+  }
+  if(analysis.isTruncated())
+  {
+    printf("The log ends part way through a record\n");
+  }
+
+  const std::vector<OutputStatistics>& outputs = analysis.getOutputs();
+  for(size_t i = 0; i < outputs.size(); ++i)
+  {
+    const OutputStatistics& output = outputs[i];
+    printf("\nOutput %u: refresh period %.3fms, %llu frames, %llu missing, %llu with errors, %llu allocated\n",
+           static_cast<unsigned int>(i), analysis.toNanoseconds(output.countsPerRefresh) / 1.0e6,
+           static_cast<unsigned long long>(output.recordCount),
+           static_cast<unsigned long long>(output.missingFrameCount),
+           static_cast<unsigned long long>(output.errorFrameCount),
+           static_cast<unsigned long long>(output.allocatingFrameCount));
+    printf("  %-16s %10s %10s %10s %10s %10s\n", "(ms)", "p50", "p90", "p99", "p99.9", "max");
+    printRow("frame time", output.frameTime);
+    printRow("render time", output.renderTime);
+    if(output.columnIntervalCount > 0)
+    {
+      printRow("column jitter", output.columnJitter);
+    }
+    if(i > 0 && output.skew.getTotalCount() > 0)
+    {
+      printRow("skew vs output 0", output.skew);
+    }
+    if(output.columnIntervalCount > 0)
+    {
+      printf("  column switches average %+.4fms from the refresh period over %llu intervals\n",
+             output.columnJitterSum / output.columnIntervalCount / 1.0e6,
+             static_cast<unsigned long long>(output.columnIntervalCount));
+    }
+    if(i > 0 && output.skewFit.n > 0)
+    {
+      printf("  starts %+.4fms from output 0 on average, drifting %+.3fus per second\n",
+             output.skewFit.getMeanY() * 1000.0, output.skewFit.getSlope() * 1.0e6);
+    }
+  }
+
+  if(outputs.size() > 1)
+  {
+    printf("\nAcross outputs: %llu frames matched, %llu missing a record from some output\n",
+           static_cast<unsigned long long>(analysis.getMatchedFrameCount()),
+           static_cast<unsigned long long>(analysis.getUnmatchedFrameCount()));
+    printf("  %-16s %10s %10s %10s %10s %10s\n", "(ms)", "p50", "p90", "p99", "p99.9", "max");
+    printRow("render variance", analysis.getRenderVariance());
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  unsigned int threadCount = std::thread::hardware_concurrency();
+  const char* path = NULL;
+  for(int i = 1; i < argc; ++i)
+  {
+    if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+    {
+      threadCount = static_cast<unsigned int>(atoi(argv[++i]));
+    }
+    else if(path == NULL && argv[i][0] != '-')
+    {
+      path = argv[i];
+    }
+    else
+    {
+      printUsage();
+      return 2;
+    }
+  }
+  if(path == NULL)
+  {
+    printUsage();
+    return 2;
+  }
+  if(threadCount < 1)
+  {
+    threadCount = 1;
+  }
+
+  std::shared_ptr<DirectX::FileMapping> file;
+  try
+  {
+#if defined(_WIN32)
+    std::string pathString(path);
+    file = DirectX::FileMapping::Open(std::wstring(pathString.begin(), pathString.end()));
+#else
+    file = DirectX::FileMapping::Open(path);
+#endif
+  }
+  catch(const std::exception& e)
+  {
+    fprintf(stderr, "Could not map %s: %s\n", path, e.what());
+    return 1;
+  }
+
+  Clock* clock = Clock::getSystemClock();
+  uint64_t startCount = clock->getCount();
+
+  TimingAnalysis analysis;
+  if(!analysis.run(file->Data(), file->Size(), threadCount))
+  {
+    fprintf(stderr, "%s: %s\n", path, analysis.getError().c_str());
+    return 1;
+  }
+
+  double seconds = static_cast<double>(clock->getCount() - startCount) / clock->getFrequency();
+  printReport(analysis);
+  printf("\nAnalyzed %.1fMB in %.3fs on %u threads\n", file->Size() / 1.0e6, seconds, threadCount);
+  return 0;
+}
@@ -0,0 +1,436 @@
+#include "TimingAnalysis.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <unordered_map>
+
+LinearFit::LinearFit(void)
+  :n(0),
+  sumX(0),
+  sumY(0),
+  sumXX(0),
+  sumXY(0)
+{
+}
+
+void LinearFit::add(double x, double y)
+{
+  n += 1;
+  sumX += x;
+  sumY += y;
+  sumXX += x * x;
+  sumXY += x * y;
+}
+
+void LinearFit::add(const LinearFit& other)
+{
+  n += other.n;
+  sumX += other.sumX;
+  sumY += other.sumY;
+  sumXX += other.sumXX;
+  sumXY += other.sumXY;
+}
+
+double LinearFit::getMeanY() const
+{
+  return n > 0 ? sumY / n : 0;
+}
+
+double LinearFit::getSlope() const
+{
+  double denominator = n * sumXX - sumX * sumX;
+  if(n < 2 || denominator <= 0)
+  {
+    return 0;
+  }
+  return (n * sumXY - sumX * sumY) / denominator;
+}
+
+OutputStatistics::OutputStatistics(void)
+  :countsPerRefresh(0),
+  recordCount(0),
+  missingFrameCount(0),
+  errorFrameCount(0),
+  allocatingFrameCount(0),
+  columnIntervalCount(0),
+  columnJitterSum(0)
+{
+}
+
+TimingAnalysis::TimingAnalysis(void)
+  :mAllOutputsMask(0),
+  mNanosecondsPerTick(0),
+  mSecondsPerTick(0),
+  mRecordCount(0),
+  mInvalidRecordCount(0),
+  mTruncated(false),
+  mMatchedFrameCount(0),
+  mUnmatchedFrameCount(0)
+{
+  memset(&mHeader, 0, sizeof(mHeader));
+}
+
+bool TimingAnalysis::run(const uint8_t* data, uint64_t size, unsigned int threadCount)
+{
+  if(size < sizeof(TelemetryFileHeader))
+  {
+    mError = "The file is too small to be a timing log.";
+    return false;
+  }
+  memcpy(&mHeader, data, sizeof(mHeader));
+  if(memcmp(mHeader.magic, TELEMETRY_MAGIC, sizeof(mHeader.magic)) != 0)
+  {
+    mError = "The file is not a timing log.";
+    return false;
+  }
+  if(mHeader.version != TELEMETRY_VERSION || mHeader.recordSize != sizeof(TelemetryRecord))
+  {
+    mError = "The timing log was written by a different version of InputLagTimer.";
+    return false;
+  }
+  if(mHeader.outputCount == 0 || mHeader.outputCount > MAX_OUTPUTS)
+  {
+    mError = "The timing log has an unsupported number of outputs.";
+    return false;
+  }
+  if(mHeader.headerSize < sizeof(TelemetryFileHeader) + mHeader.outputCount * sizeof(TelemetryOutputInfo)
+     || mHeader.headerSize > size || mHeader.frequency == 0)
+  {
+    mError = "The timing log header is corrupt.";
+    return false;
+  }
+
+  mAllOutputsMask = mHeader.outputCount == MAX_OUTPUTS ? 0xffffffffu : (1u << mHeader.outputCount) - 1;
+  mNanosecondsPerTick = 1.0e9 / mHeader.frequency;
+  mSecondsPerTick = 1.0 / mHeader.frequency;
+
+  mOutputs.assign(mHeader.outputCount, OutputStatistics());
+  const uint8_t* infos = data + sizeof(TelemetryFileHeader);
+  for(uint32_t i = 0; i < mHeader.outputCount; ++i)
+  {
+    TelemetryOutputInfo info;
+    memcpy(&info, infos + i * sizeof(TelemetryOutputInfo), sizeof(info));
+    mOutputs[i].countsPerRefresh = info.countsPerRefresh;
+  }
+
+  uint64_t recordBytes = size - mHeader.headerSize;
+  mRecordCount = recordBytes / sizeof(TelemetryRecord);
+  mTruncated = (recordBytes % sizeof(TelemetryRecord)) != 0;
+  const TelemetryRecord* records = reinterpret_cast<const TelemetryRecord*>(data + mHeader.headerSize);
+
+  if(threadCount < 1)
+  {
+    threadCount = 1;
+  }
+  if(threadCount > mRecordCount)
+  {
+    threadCount = mRecordCount > 0 ? static_cast<unsigned int>(mRecordCount) : 1;
+  }
+
+  std::vector<Span> spans(threadCount);
+  for(unsigned int i = 0; i < threadCount; ++i)
+  {
+    Span& span = spans[i];
+    span.begin = records + mRecordCount * i / threadCount;
+    span.end = records + mRecordCount * (i + 1) / threadCount;
+    SpanOutput empty;
+    memset(&empty, 0, sizeof(empty));
+    span.spanOutputs.assign(mHeader.outputCount, empty);
+    /* Copies the refresh periods */
+    span.outputs = mOutputs;
+    span.matchedFrameCount = 0;
+    span.invalidRecordCount = 0;
+  }
+
+  /* The calling thread takes the first span */
+  std::vector<std::thread> threads;
+  for(unsigned int i = 1; i < threadCount; ++i)
+  {
+    Span* span = &spans[i];
+    threads.push_back(std::thread([this, span]() { analyzeSpan(span); }));
+  }
+  analyzeSpan(&spans[0]);
+  for(auto iter = threads.begin(); iter != threads.end(); ++iter)
+  {
+    iter->join();
+  }
+
+  stitchSpans(spans);
+  return true;
+}
+
+void TimingAnalysis::analyzeSpan(Span* span) const
+{
+  /* A single output has nothing to be matched against */
+  bool matchFrames = mHeader.outputCount > 1;
+  std::unordered_map<uint32_t, PendingFrame> pending;
+
+  for(const TelemetryRecord* record = span->begin; record != span->end; ++record)
+  {
+    uint16_t outputIndex = record->outputIndex;
+    if(outputIndex >= mHeader.outputCount)
+    {
+      ++span->invalidRecordCount;
+      continue;
+    }
+
+    OutputStatistics& output = span->outputs[outputIndex];
+    SpanOutput& spanOutput = span->spanOutputs[outputIndex];
+
+    ++output.recordCount;
+    if(record->error != 0)
+    {
+      ++output.errorFrameCount;
+    }
+    if(record->allocations != 0)
+    {
+      ++output.allocatingFrameCount;
+    }
+    output.renderTime.record(toNanoseconds(record->renderCompleteCount - record->startCount));
+
+    if(spanOutput.hasRecords)
+    {
+      recordFramePair(&output, spanOutput.last, *record);
+      if(record->column != spanOutput.last.column)
+      {
+        if(spanOutput.hasSwitch)
+        {
+          recordColumnSwitch(&output, spanOutput.lastSwitchCount, record->startCount);
+        }
+        else
+        {
+          spanOutput.hasSwitch = true;
+          spanOutput.firstSwitchCount = record->startCount;
+        }
+        spanOutput.lastSwitchCount = record->startCount;
+      }
+    }
+    else
+    {
+      spanOutput.hasRecords = true;
+      spanOutput.first = *record;
+    }
+    spanOutput.last = *record;
+
+    if(matchFrames)
+    {
+      /* A new entry is value-initialised, so its mask starts at zero */
+      PendingFrame& frame = pending[record->frameIndex];
+      frame.frameIndex = record->frameIndex;
+      frame.outputMask |= 1u << outputIndex;
+      frame.startCount[outputIndex] = record->startCount;
+      frame.renderCompleteCount[outputIndex] = record->renderCompleteCount;
+      if(frame.outputMask == mAllOutputsMask)
+      {
+        recordMatchedFrame(frame, span->outputs, &span->renderVariance);
+        ++span->matchedFrameCount;
+        pending.erase(record->frameIndex);
+      }
+    }
+  }
+
+  span->pendingFrames.reserve(pending.size());
+  for(auto iter = pending.begin(); iter != pending.end(); ++iter)
+  {
+    span->pendingFrames.push_back(iter->second);
+  }
+}
+
+void TimingAnalysis::stitchSpans(std::vector<Span>& spans)
+{
+  /* Per output, the last record and column switch seen in the spans stitched so far */
+  std::vector<SpanOutput> stitched(mHeader.outputCount);
+  for(auto iter = stitched.begin(); iter != stitched.end(); ++iter)
+  {
+    memset(&*iter, 0, sizeof(SpanOutput));
+  }
+
+  std::map<uint32_t, PendingFrame> pending;
+
+  for(auto span = spans.begin(); span != spans.end(); ++span)
+  {
+    mInvalidRecordCount += span->invalidRecordCount;
+    mMatchedFrameCount += span->matchedFrameCount;
+    mRenderVariance.add(span->renderVariance);
+
+    for(uint32_t i = 0; i < mHeader.outputCount; ++i)
+    {
+      OutputStatistics& output = mOutputs[i];
+      const OutputStatistics& spanStatistics = span->outputs[i];
+      output.recordCount += spanStatistics.recordCount;
+      output.missingFrameCount += spanStatistics.missingFrameCount;
+      output.errorFrameCount += spanStatistics.errorFrameCount;
+      output.allocatingFrameCount += spanStatistics.allocatingFrameCount;
+      output.frameTime.add(spanStatistics.frameTime);
+      output.renderTime.add(spanStatistics.renderTime);
+      output.columnJitter.add(spanStatistics.columnJitter);
+      output.columnIntervalCount += spanStatistics.columnIntervalCount;
+      output.columnJitterSum += spanStatistics.columnJitterSum;
+      output.skew.add(spanStatistics.skew);
+      output.skewFit.add(spanStatistics.skewFit);
+
+      /* Pick up the pairs that straddle the boundary with the previous span */
+      const SpanOutput& spanOutput = span->spanOutputs[i];
+      SpanOutput& previous = stitched[i];
+      if(!spanOutput.hasRecords)
+      {
+        continue;
+      }
+      if(previous.hasRecords)
+      {
+        recordFramePair(&output, previous.last, spanOutput.first);
+        if(spanOutput.first.column != previous.last.column)
+        {
+          if(previous.hasSwitch)
+          {
+            recordColumnSwitch(&output, previous.lastSwitchCount, spanOutput.first.startCount);
+          }
+          previous.hasSwitch = true;
+          previous.lastSwitchCount = spanOutput.first.startCount;
+        }
+      }
+      if(spanOutput.hasSwitch)
+      {
+        if(previous.hasSwitch)
+        {
+          recordColumnSwitch(&output, previous.lastSwitchCount, spanOutput.firstSwitchCount);
+        }
+        previous.hasSwitch = true;
+        previous.lastSwitchCount = spanOutput.lastSwitchCount;
+      }
+      previous.hasRecords = true;
+      previous.last = spanOutput.last;
+    }
+
+    /* Frames that were split across spans */
+    for(auto frame = span->pendingFrames.begin(); frame != span->pendingFrames.end(); ++frame)
+    {
+      auto found = pending.find(frame->frameIndex);
+      if(found == pending.end())
+      {
+        pending.insert(std::make_pair(frame->frameIndex, *frame));
+        continue;
+      }
+      PendingFrame& merged = found->second;
+      for(uint32_t i = 0; i < mHeader.outputCount; ++i)
+      {
+        if(frame->outputMask & (1u << i))
+        {
+          merged.startCount[i] = frame->startCount[i];
+          merged.renderCompleteCount[i] = frame->renderCompleteCount[i];
+        }
+      }
+      merged.outputMask |= frame->outputMask;
+    }
+    span->pendingFrames.clear();
+  }
+
+  for(auto iter = pending.begin(); iter != pending.end(); ++iter)
+  {
+    if(iter->second.outputMask == mAllOutputsMask)
+    {
+      recordMatchedFrame(iter->second, mOutputs, &mRenderVariance);
+      ++mMatchedFrameCount;
+    }
+    else
+    {
+      ++mUnmatchedFrameCount;
+    }
+  }
+}
+
+void TimingAnalysis::recordFramePair(OutputStatistics* output, const TelemetryRecord& previous, const TelemetryRecord& current) const
+{
+  if(current.startCount >= previous.startCount)
+  {
+    output->frameTime.record(toNanoseconds(current.startCount - previous.startCount));
+  }
+  if(current.frameIndex > previous.frameIndex + 1)
+  {
+    output->missingFrameCount += current.frameIndex - previous.frameIndex - 1;
+  }
+}
+
+void TimingAnalysis::recordColumnSwitch(OutputStatistics* output, uint64_t previousSwitchCount, uint64_t switchCount) const
+{
+  /* The model carries the remainder over, so a late switch is followed by an early one */
+  double error = static_cast<double>(switchCount - previousSwitchCount) - static_cast<double>(output->countsPerRefresh);
+  output->columnJitter.record(static_cast<uint64_t>(fabs(error) * mNanosecondsPerTick + 0.5));
+  output->columnJitterSum += error * mNanosecondsPerTick;
+  ++output->columnIntervalCount;
+}
+
+void TimingAnalysis::recordMatchedFrame(const PendingFrame& frame, std::vector<OutputStatistics>& outputs, Histogram* renderVariance) const
+{
+  uint64_t shortestRender = UINT64_MAX;
+  uint64_t longestRender = 0;
+  for(uint32_t i = 0; i < mHeader.outputCount; ++i)
+  {
+    uint64_t render = frame.renderCompleteCount[i] - frame.startCount[i];
+    shortestRender = std::min(shortestRender, render);
+    longestRender = std::max(longestRender, render);
+  }
+  renderVariance->record(toNanoseconds(longestRender - shortestRender));
+
+  /* Skew is measured against output 0 */
+  double secondsSinceStart = static_cast<double>(frame.startCount[0] - mHeader.startingCount) * mSecondsPerTick;
+  for(uint32_t i = 1; i < mHeader.outputCount; ++i)
+  {
+    int64_t skew = static_cast<int64_t>(frame.startCount[i] - frame.startCount[0]);
+    outputs[i].skew.record(toNanoseconds(static_cast<uint64_t>(skew < 0 ? -skew : skew)));
+    outputs[i].skewFit.add(secondsSinceStart, skew * mSecondsPerTick);
+  }
+}
+
+uint64_t TimingAnalysis::toNanoseconds(uint64_t ticks) const
+{
+  return static_cast<uint64_t>(ticks * mNanosecondsPerTick + 0.5);
+}
+
+const std::string& TimingAnalysis::getError() const
+{
+  return mError;
+}
+
+const TelemetryFileHeader& TimingAnalysis::getHeader() const
+{
+  return mHeader;
+}
+
+uint64_t TimingAnalysis::getRecordCount() const
+{
+  return mRecordCount;
+}
+
+uint64_t TimingAnalysis::getInvalidRecordCount() const
+{
+  return mInvalidRecordCount;
+}
+
+bool TimingAnalysis::isTruncated() const
+{
+  return mTruncated;
+}
+
+const std::vector<OutputStatistics>& TimingAnalysis::getOutputs() const
+{
+  return mOutputs;
+}
+
+uint64_t TimingAnalysis::getMatchedFrameCount() const
+{
+  return mMatchedFrameCount;
+}
+
+uint64_t TimingAnalysis::getUnmatchedFrameCount() const
+{
+  return mUnmatchedFrameCount;
+}
+
+const Histogram& TimingAnalysis::getRenderVariance() const
+{
+  return mRenderVariance;
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Histogram.h"
+#include "TelemetryFormat.h"
+
+/**
+ * A least squares line fitted incrementally, so partial fits from separate
+ * threads can be added together.
+ */
+struct LinearFit
+{
+  double n;
+  double sumX;
+  double sumY;
+  double sumXX;
+  double sumXY;
+
+  LinearFit(void);
+  void add(double x, double y);
+  void add(const LinearFit& other);
+  double getMeanY() const;
+  /** @return the change in y per unit of x, or 0 with fewer than two distinct x values */
+  double getSlope() const;
+};
+
+/**
+ * What the analyzer learned about one output. Times are in nanoseconds.
+ */
+struct OutputStatistics
+{
+  uint64_t countsPerRefresh;
+  uint64_t recordCount;
+  /** Frames whose index was skipped, because records were dropped or the log was cut short */
+  uint64_t missingFrameCount;
+  uint64_t errorFrameCount;
+  /** Frames whose rendering allocated from the heap */
+  uint64_t allocatingFrameCount;
+
+  /** Time between the starts of consecutive frames */
+  Histogram frameTime;
+  /** Time from the timer value being sampled to Present returning */
+  Histogram renderTime;
+
+  /** How far each interval between column switches was from the refresh period */
+  Histogram columnJitter;
+  uint64_t columnIntervalCount;
+  /** Sum of signed (interval - refresh period), for the mean */
+  double columnJitterSum;
+
+  /** How far this output's frame start was from output 0's for the same frame */
+  Histogram skew;
+  /** Skew in seconds against seconds since the timer started; the slope is the drift */
+  LinearFit skewFit;
+
+  OutputStatistics(void);
+};
+
+/**
+ * Reads a timing log written by TelemetryRecorder and computes distributions
+ * that are too expensive to keep on the HUD: frame time and render time per
+ * output, render time variance across outputs, column switch jitter against
+ * each output's refresh cadence, and drift between outputs.
+ *
+ * The records are split into one contiguous span per thread. Each thread
+ * keeps the first and last record of every output it saw, and whatever frames
+ * it could not match across outputs, so the spans can be stitched together
+ * in order afterwards with a result identical to a single pass.
+ */
+class TimingAnalysis
+{
+public:
+  /** A frame's records are matched across outputs with a bit mask */
+  static const int MAX_OUTPUTS = 32;
+
+  TimingAnalysis(void);
+
+  /**
+   * Validates the header and analyzes every record.
+   * @param data the whole log file.
+   * @param threadCount how many threads to split the records across, at least 1.
+   * @return false with getError() set if the log is not one this analyzer understands.
+   */
+  bool run(const uint8_t* data, uint64_t size, unsigned int threadCount);
+
+  const std::string& getError() const;
+
+  const TelemetryFileHeader& getHeader() const;
+  uint64_t getRecordCount() const;
+  /** @return records whose output index was out of range */
+  uint64_t getInvalidRecordCount() const;
+  /** @return true if the file ended part way through a record */
+  bool isTruncated() const;
+
+  const std::vector<OutputStatistics>& getOutputs() const;
+  /** @return frames that had records from every output */
+  uint64_t getMatchedFrameCount() const;
+  /** @return frames that were missing a record from at least one output */
+  uint64_t getUnmatchedFrameCount() const;
+  /** The spread between the fastest and slowest output's render time in each matched frame */
+  const Histogram& getRenderVariance() const;
+
+  /**
+   * @return ticks converted to nanoseconds, rounded to nearest.
+   */
+  uint64_t toNanoseconds(uint64_t ticks) const;
+
+protected:
+  struct PendingFrame
+  {
+    uint32_t frameIndex;
+    uint32_t outputMask;
+    uint64_t startCount[MAX_OUTPUTS];
+    uint64_t renderCompleteCount[MAX_OUTPUTS];
+  };
+
+  /** An output's view of one span */
+  struct SpanOutput
+  {
+    bool hasRecords;
+    TelemetryRecord first;
+    TelemetryRecord last;
+    /** Switches found between records inside the span */
+    bool hasSwitch;
+    uint64_t firstSwitchCount;
+    uint64_t lastSwitchCount;
+  };
+
+  struct Span
+  {
+    const TelemetryRecord* begin;
+    const TelemetryRecord* end;
+    std::vector<SpanOutput> spanOutputs;
+    std::vector<OutputStatistics> outputs;
+    Histogram renderVariance;
+    uint64_t matchedFrameCount;
+    uint64_t invalidRecordCount;
+    /** Frames this span saw only part of */
+    std::vector<PendingFrame> pendingFrames;
+  };
+
+  void analyzeSpan(Span* span) const;
+  void stitchSpans(std::vector<Span>& spans);
+
+  void recordFramePair(OutputStatistics* output, const TelemetryRecord& previous, const TelemetryRecord& current) const;
+  void recordColumnSwitch(OutputStatistics* output, uint64_t previousSwitchCount, uint64_t switchCount) const;
+  void recordMatchedFrame(const PendingFrame& frame, std::vector<OutputStatistics>& outputs, Histogram* renderVariance) const;
+
+  std::string mError;
+  TelemetryFileHeader mHeader;
+  uint32_t mAllOutputsMask;
+  double mNanosecondsPerTick;
+  double mSecondsPerTick;
+  uint64_t mRecordCount;
+  uint64_t mInvalidRecordCount;
+  bool mTruncated;
+  std::vector<OutputStatistics> mOutputs;
+  uint64_t mMatchedFrameCount;
+  uint64_t mUnmatchedFrameCount;
+  Histogram mRenderVariance;
+};
@@ -0,0 +1,173 @@
+#include "AllocationTracker.h"
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+namespace
+{
+  /* Zero before any constructor runs, so allocations made during static initialization are counted too */
+  std::atomic<uint64_t> allocationCounts[AllocationTracker::SUBSYSTEM_COUNT];
+  std::atomic<uint64_t> allocationBytes[AllocationTracker::SUBSYSTEM_COUNT];
+
+  THREAD_LOCAL int threadSubsystem = AllocationTracker::SUBSYSTEM_OTHER;
+  THREAD_LOCAL uint64_t threadAllocationCount = 0;
+
+  /* Only used by the thread that runs the frame loop */
+  AllocationTracker::Counts frameStartCounts[AllocationTracker::SUBSYSTEM_COUNT];
+  AllocationTracker::Counts frameCounts[AllocationTracker::SUBSYSTEM_COUNT];
+  uint64_t allocatingFrameCount = 0;
+  uint64_t steadyStateAllocatingFrameCount = 0;
+
+  const char* subsystemNames[AllocationTracker::SUBSYSTEM_COUNT] =
+  {
+    "other",
+    "frame loop",
+    "model",
+    "drawing",
+    "present"
+  };
+}
+
+AllocationTracker::Scope::Scope(Subsystem subsystem)
+  :mPrevious(static_cast<Subsystem>(threadSubsystem))
+{
+  threadSubsystem = subsystem;
+}
+
+AllocationTracker::Scope::~Scope(void)
+{
+  threadSubsystem = mPrevious;
+}
+
+void AllocationTracker::recordAllocation(size_t bytes)
+{
+  allocationCounts[threadSubsystem].fetch_add(1, std::memory_order_relaxed);
+  allocationBytes[threadSubsystem].fetch_add(bytes, std::memory_order_relaxed);
+  ++threadAllocationCount;
+}
+
+uint64_t AllocationTracker::getThreadAllocationCount()
+{
+  return threadAllocationCount;
+}
+
+void AllocationTracker::frameStarted()
+{
+  for(int i = 0; i < SUBSYSTEM_COUNT; ++i)
+  {
+    frameStartCounts[i] = getTotalCounts(static_cast<Subsystem>(i));
+  }
+}
+
+bool AllocationTracker::frameComplete(bool steadyState)
+{
+  bool allocated = false;
+  for(int i = 0; i < SUBSYSTEM_COUNT; ++i)
+  {
+    Counts total = getTotalCounts(static_cast<Subsystem>(i));
+    frameCounts[i].allocations = total.allocations - frameStartCounts[i].allocations;
+    frameCounts[i].bytes = total.bytes - frameStartCounts[i].bytes;
+    if(i != SUBSYSTEM_OTHER && frameCounts[i].allocations > 0)
+    {
+      allocated = true;
+    }
+  }
+
+  if(!allocated)
+  {
+    return false;
+  }
+  ++allocatingFrameCount;
+  if(steadyState)
+  {
+    ++steadyStateAllocatingFrameCount;
+  }
+  return steadyState;
+}
+
+AllocationTracker::Counts AllocationTracker::getFrameCounts(Subsystem subsystem)
+{
+  return frameCounts[subsystem];
+}
+
+AllocationTracker::Counts AllocationTracker::getTotalCounts(Subsystem subsystem)
+{
+  Counts counts;
+  counts.allocations = allocationCounts[subsystem].load(std::memory_order_relaxed);
+  counts.bytes = allocationBytes[subsystem].load(std::memory_order_relaxed);
+  return counts;
+}
+
+uint64_t AllocationTracker::getAllocatingFrameCount()
+{
+  return allocatingFrameCount;
+}
+
+uint64_t AllocationTracker::getSteadyStateAllocatingFrameCount()
+{
+  return steadyStateAllocatingFrameCount;
+}
+
+const char* AllocationTracker::getSubsystemName(Subsystem subsystem)
+{
+  return subsystemNames[subsystem];
+}
+
+/* The replacements that every allocation in the program goes through. Each array and nothrow form
+   is written out, rather than left to the runtime's, so that none of them bypass the count. */
+void* operator new(size_t size)
+{
+  void* memory = malloc(size > 0 ? size : 1);
+  if(!memory)
+  {
+    throw std::bad_alloc();
+  }
+  AllocationTracker::recordAllocation(size);
+  return memory;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+  void* memory = malloc(size > 0 ? size : 1);
+  if(memory)
+  {
+    AllocationTracker::recordAllocation(size);
+  }
+  return memory;
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) throw()
+{
+  return operator new(size, nothrow);
+}
+
+void operator delete(void* memory) throw()
+{
+  free(memory);
+}
+
+void operator delete[](void* memory) throw()
+{
+  free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) throw()
+{
+  free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) throw()
+{
+  free(memory);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Counts the heap allocations made through operator new, by subsystem and by frame, so that allocations
+ * on the timed path show up on the HUD, in telemetry and in FrameLoopBenchmark. Linking AllocationTracker.cpp
+ * replaces the global operator new and delete, which is where the counts come from. Allocations made by
+ * the graphics driver and the OS with their own heaps are not counted.
+ *
+ * Each thread counts its allocations against the subsystem of its innermost Scope, or SUBSYSTEM_OTHER
+ * outside of every scope. Counting is two relaxed atomic adds per allocation, so it is always on.
+ */
+class AllocationTracker
+{
+public:
+  enum Subsystem
+  {
+    /** Threads that are not rendering, such as the telemetry flusher and the config watcher */
+    SUBSYSTEM_OTHER = 0,
+    /** The loop itself, outside of the models and outputs: config changes, commands and scheduling */
+    SUBSYSTEM_FRAME_LOOP,
+    /** Updating the models, their HUD values and telemetry */
+    SUBSYSTEM_MODEL,
+    /** Laying out and drawing the timer, HUD and error screen */
+    SUBSYSTEM_DRAWING,
+    /** Beginning and presenting each output's frame */
+    SUBSYSTEM_PRESENT,
+    SUBSYSTEM_COUNT
+  };
+
+  struct Counts
+  {
+    uint64_t allocations;
+    uint64_t bytes;
+  };
+
+  /**
+   * Counts the calling thread's allocations against a subsystem until it is destroyed.
+   */
+  class Scope
+  {
+  public:
+    explicit Scope(Subsystem subsystem);
+    ~Scope(void);
+
+  private:
+    Subsystem mPrevious;
+
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+  };
+
+  /**
+   * Called by operator new on the thread that allocated.
+   */
+  static void recordAllocation(size_t bytes);
+
+  /**
+   * @return how many allocations the calling thread has made, for counting them over part of a frame.
+   */
+  static uint64_t getThreadAllocationCount();
+
+  /**
+   * Starts counting a frame. Called by the thread that runs the frame loop, between frames.
+   */
+  static void frameStarted();
+
+  /**
+   * Ends the frame started by frameStarted(). Allocations made by SUBSYSTEM_OTHER during the frame
+   * are not counted against it, since they are made by threads that do not render.
+   * @param steadyState true if nothing was changed between frames, so the frame should not have allocated.
+   * @return true if it was a steady state frame that allocated.
+   */
+  static bool frameComplete(bool steadyState);
+
+  /**
+   * @return what the subsystem allocated in the last complete frame.
+   */
+  static Counts getFrameCounts(Subsystem subsystem);
+
+  /**
+   * @return what the subsystem has allocated since startup, in frames or not.
+   */
+  static Counts getTotalCounts(Subsystem subsystem);
+
+  /**
+   * @return the complete frames that allocated, and of those, the ones that were steady state.
+   */
+  static uint64_t getAllocatingFrameCount();
+  static uint64_t getSteadyStateAllocatingFrameCount();
+
+  static const char* getSubsystemName(Subsystem subsystem);
+};
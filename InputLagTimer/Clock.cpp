@@ -0,0 +1,90 @@
+#include "Clock.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+Clock* Clock::getSystemClock()
+{
+#if defined(_WIN32)
+  static QueryPerformanceClock systemClock;
+#else
+  static MonotonicRawClock systemClock;
+#endif
+  return &systemClock;
+}
+
+#if defined(_WIN32)
+
+QueryPerformanceClock::QueryPerformanceClock(void)
+{
+  LARGE_INTEGER performanceFrequency;
+  QueryPerformanceFrequency(&performanceFrequency);
+  mFrequency = performanceFrequency.QuadPart;
+}
+
+uint64_t QueryPerformanceClock::getCount()
+{
+  LARGE_INTEGER currentCount;
+  QueryPerformanceCounter(&currentCount);
+  return currentCount.QuadPart;
+}
+
+uint64_t QueryPerformanceClock::getFrequency() const
+{
+  return mFrequency;
+}
+
+#else
+
+uint64_t MonotonicRawClock::getCount()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + now.tv_nsec;
+}
+
+uint64_t MonotonicRawClock::getFrequency() const
+{
+  return 1000000000ull;
+}
+
+#endif
+
+ReplayClock::ReplayClock(uint64_t frequency, const std::vector<uint64_t>& counts)
+  :mFrequency(frequency),
+  mCounts(counts),
+  mPosition(0)
+{
+}
+
+uint64_t ReplayClock::getCount()
+{
+  if(mCounts.empty())
+  {
+    return 0;
+  }
+  if(mPosition >= mCounts.size())
+  {
+    return mCounts.back();
+  }
+  return mCounts[mPosition++];
+}
+
+uint64_t ReplayClock::getFrequency() const
+{
+  return mFrequency;
+}
+
+bool ReplayClock::isFinished() const
+{
+  return mPosition >= mCounts.size();
+}
+
+void ReplayClock::rewind()
+{
+  mPosition = 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+ * A source of high resolution counter ticks.
+ * The timer math only ever deals in counts and a frequency so that it can be
+ * driven by the platform's counter, or by a recorded trace when benchmarking.
+ */
+class Clock
+{
+public:
+  /**
+   * @return the clock backed by the platform's high resolution counter:
+   * QueryPerformanceCounter on Windows and CLOCK_MONOTONIC_RAW elsewhere.
+   * This clock is owned by the Clock class and must not be deleted.
+   */
+  static Clock* getSystemClock();
+
+  virtual ~Clock(void) {}
+
+  /**
+   * @return the current value of the counter in ticks.
+   */
+  virtual uint64_t getCount() = 0;
+
+  /**
+   * @return the number of ticks per second. This never changes for the life of the clock.
+   */
+  virtual uint64_t getFrequency() const = 0;
+};
+
+#if defined(_WIN32)
+
+/**
+ * Reads QueryPerformanceCounter. The frequency is queried once on construction.
+ */
+class QueryPerformanceClock : public Clock
+{
+public:
+  QueryPerformanceClock(void);
+
+  virtual uint64_t getCount();
+  virtual uint64_t getFrequency() const;
+
+protected:
+  uint64_t mFrequency;
+};
+
+#else
+
+/**
+ * Reads clock_gettime(CLOCK_MONOTONIC_RAW), which is not slewed by NTP.
+ * Ticks are nanoseconds.
+ */
+class MonotonicRawClock : public Clock
+{
+public:
+  virtual uint64_t getCount();
+  virtual uint64_t getFrequency() const;
+};
+
+#endif
+
+/**
+ * Plays back a recorded list of counter values, one value per call to getCount().
+ * Once the end of the trace is reached, the last value is repeated.
+ */
+class ReplayClock : public Clock
+{
+public:
+  ReplayClock(uint64_t frequency, const std::vector<uint64_t>& counts);
+
+  virtual uint64_t getCount();
+  virtual uint64_t getFrequency() const;
+
+  /**
+   * @return true once every count in the trace has been returned.
+   */
+  bool isFinished() const;
+
+  /**
+   * Starts playback from the beginning of the trace again.
+   */
+  void rewind();
+
+protected:
+  uint64_t mFrequency;
+  std::vector<uint64_t> mCounts;
+  size_t mPosition;
+};
@@ -1,38 +1,307 @@
-#include "stdafx.h"
 #include "Config.h"
+#include "IniFile.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define CONFIG_PATH "config.ini"
+/* How often the watcher checks config.ini for changes */
+#define WATCH_INTERVAL_MS 250
+
+#if !defined(ARRAYSIZE)
+#define ARRAYSIZE(a) (sizeof(a) / sizeof((a)[0]))
+#endif
 
 double Config::longestFrameTime = 0;
 double Config::highestRenderVariance = 0;
 
 int Config::numColumns = 2;
-DirectX::XMVECTOR Config::fontColour = { 0.0, 0.0, 0.0, 1.0f };
+float Config::fontColour[4] = { 0.0, 0.0, 0.0, 1.0f };
 float Config::backgroundColour[4] = { 1.0, 1.0, 1.0, 1.0f };
 
+bool Config::renderThreadPerDevice = false;
+bool Config::separateMessageThread = false;
+
+int Config::frameIntervalUs = 0;
+int Config::framesPerRefresh = 0;
+
+bool Config::telemetryEnabled = false;
+std::string Config::telemetryPath = "timing.iltlog";
+
+bool Config::profileEnabled = false;
+std::string Config::profilePath = "display.iltprofile";
+
+bool Config::failOnFrameAllocation = false;
+std::string Config::tracePath = "trace.json";
+
+int Config::configuredLongestFrameTime = 0;
+int Config::configuredHighestRenderVariance = 0;
+double Config::baselineFrameTimeP99 = 0.0;
+double Config::baselineRenderVarianceP99 = 0.0;
+
+std::atomic<Config::Values*> Config::pendingValues(nullptr);
+
+/* How far above the measured 99th percentile a failsafe that follows the displays is set */
+#define BASELINE_FAILSAFE_MARGIN 1.5
+/* The failsafes in the shipped config.ini, used when there is no baseline to follow */
+#define DEFAULT_LONGEST_FRAME_TIME 0.004
+#define DEFAULT_HIGHEST_RENDER_VARIANCE 0.001
+
+namespace
+{
+  /**
+   * A key in config.ini that holds a number, and the range it is clamped to.
+   */
+  struct IntKey
+  {
+    const char* section;
+    const char* key;
+    int Config::Values::* field;
+    int defaultValue;
+    int minimum;
+    int maximum;
+  };
+
+  struct StringKey
+  {
+    const char* section;
+    const char* key;
+    std::string Config::Values::* field;
+    const char* defaultValue;
+  };
+
+  std::thread watcherThread;
+  std::mutex watcherMutex;
+  std::condition_variable watcherWake;
+  bool watcherStopping = false;
+
+  /**
+   * @return false if the file could not be found. Otherwise outStamp changes whenever the file is written:
+   * it is the last write time, in 100ns units on Windows and nanoseconds elsewhere, and the size.
+   * Whole seconds would miss an edit that keeps the size, such as 40 to 50, saved within a second of the last.
+   */
+  bool getFileStamp(const char* path, std::pair<long long, long long>* outStamp)
+  {
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if(!GetFileAttributesExA(path, GetFileExInfoStandard, &attributes))
+    {
+      return false;
+    }
+    outStamp->first = static_cast<long long>((static_cast<unsigned long long>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+                                             attributes.ftLastWriteTime.dwLowDateTime);
+    outStamp->second = static_cast<long long>((static_cast<unsigned long long>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow);
+#else
+    struct stat fileStat;
+    if(stat(path, &fileStat) != 0)
+    {
+      return false;
+    }
+#if defined(__APPLE__)
+    const timespec& modified = fileStat.st_mtimespec;
+#else
+    const timespec& modified = fileStat.st_mtim;
+#endif
+    outStamp->first = static_cast<long long>(modified.tv_sec) * 1000000000LL + modified.tv_nsec;
+    outStamp->second = static_cast<long long>(fileStat.st_size);
+#endif
+    return true;
+  }
+}
+
+/* The schema of config.ini. Keys that are not here are ignored. */
+namespace
+{
+  const IntKey intKeys[] =
+  {
+    { "FAILSAFES", "longest_frame_time", &Config::Values::longestFrameTime, 10, 0, 100000 },
+    { "FAILSAFES", "highest_render_variance", &Config::Values::highestRenderVariance, 10, 0, 100000 },
+    { "DISPLAY", "num_columns", &Config::Values::numColumns, 2, 1, 16 },
+    { "DISPLAY", "font_colour_r", &Config::Values::fontColourR, 255, 0, 255 },
+    { "DISPLAY", "font_colour_g", &Config::Values::fontColourG, 255, 0, 255 },
+    { "DISPLAY", "font_colour_b", &Config::Values::fontColourB, 255, 0, 255 },
+    { "DISPLAY", "background_colour_r", &Config::Values::backgroundColourR, 0, 0, 255 },
+    { "DISPLAY", "background_colour_g", &Config::Values::backgroundColourG, 0, 0, 255 },
+    { "DISPLAY", "background_colour_b", &Config::Values::backgroundColourB, 0, 0, 255 },
+    { "RENDERING", "render_thread_per_device", &Config::Values::renderThreadPerDevice, 0, 0, 1 },
+    { "RENDERING", "separate_message_thread", &Config::Values::separateMessageThread, 0, 0, 1 },
+    { "PACING", "frame_interval_us", &Config::Values::frameIntervalUs, 0, 0, 1000000 },
+    { "PACING", "frames_per_refresh", &Config::Values::framesPerRefresh, 0, 0, 1000 },
+    { "TELEMETRY", "enabled", &Config::Values::telemetryEnabled, 0, 0, 1 },
+    { "PROFILE", "enabled", &Config::Values::profileEnabled, 0, 0, 1 },
+    { "DEBUG", "fail_on_frame_allocation", &Config::Values::failOnFrameAllocation, 0, 0, 1 },
+  };
+
+  const StringKey stringKeys[] =
+  {
+    { "TELEMETRY", "path", &Config::Values::telemetryPath, "timing.iltlog" },
+    { "PROFILE", "path", &Config::Values::profilePath, "display.iltprofile" },
+    { "DEBUG", "trace_path", &Config::Values::tracePath, "trace.json" },
+  };
+}
+
 void Config::config()
 {
-  int longestFrameTime = GetPrivateProfileInt(L"FAILSAFES", L"longest_frame_time", 10, L".\\config.ini");
-  Config::longestFrameTime = (double)longestFrameTime / 10000.0;
-  int highestRenderVariance = GetPrivateProfileInt(L"FAILSAFES", L"highest_render_variance", 10, L".\\config.ini");
-  Config::highestRenderVariance = (double)highestRenderVariance / 10000.0;
-  
-  Config::numColumns = GetPrivateProfileInt(L"DISPLAY", L"num_columns", 2, L".\\config.ini");
-
-  int colour = GetPrivateProfileInt(L"DISPLAY", L"font_colour_r", 255, L".\\config.ini");
-  float r = getColourComponent(colour);
-  colour = GetPrivateProfileInt(L"DISPLAY", L"font_colour_g", 255, L".\\config.ini");
-  float g = getColourComponent(colour);
-  colour = GetPrivateProfileInt(L"DISPLAY", L"font_colour_b", 255, L".\\config.ini");
-  float b = getColourComponent(colour);
-  DirectX::XMVECTOR newColour = { r, g, b, 1.0f };
-  fontColour = newColour;
-
-  colour = GetPrivateProfileInt(L"DISPLAY", L"background_colour_r", 0, L".\\config.ini");
-  getColourComponent(colour, &backgroundColour[0]);
-  colour = GetPrivateProfileInt(L"DISPLAY", L"background_colour_g", 0, L".\\config.ini");
-  getColourComponent(colour, &backgroundColour[1]);
-  colour = GetPrivateProfileInt(L"DISPLAY", L"background_colour_b", 0, L".\\config.ini");
-  getColourComponent(colour, &backgroundColour[2]);
+  IniFile file;
+  file.load(CONFIG_PATH);
+  Values values;
+  readValues(file, &values);
+  applyValues(values, true);
+}
+
+void Config::startWatching()
+{
+  watcherStopping = false;
+  watcherThread = std::thread(&Config::watcherMain);
+}
+
+void Config::stopWatching()
+{
+  if(!watcherThread.joinable())
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(watcherMutex);
+    watcherStopping = true;
+  }
+  watcherWake.notify_one();
+  watcherThread.join();
+
+  delete pendingValues.exchange(nullptr);
+}
+
+bool Config::applyPendingChanges()
+{
+  /* Cheap enough to check every frame: one atomic load while nothing has changed */
+  if(!pendingValues.load(std::memory_order_relaxed))
+  {
+    return false;
+  }
+  Values* values = pendingValues.exchange(nullptr);
+  if(!values)
+  {
+    return false;
+  }
+  applyValues(*values, false);
+  delete values;
+  return true;
+}
+
+void Config::applyBaseline(double frameTimeP99, double renderVarianceP99)
+{
+  baselineFrameTimeP99 = frameTimeP99;
+  baselineRenderVarianceP99 = renderVarianceP99;
+  resolveFailsafes();
+}
+
+void Config::readValues(const IniFile& file, Values* outValues)
+{
+  for(size_t i = 0; i < ARRAYSIZE(intKeys); ++i)
+  {
+    const IntKey& key = intKeys[i];
+    int value = key.defaultValue;
+    file.getInt(key.section, key.key, &value);
+    value = value < key.minimum ? key.minimum : value;
+    value = value > key.maximum ? key.maximum : value;
+    outValues->*key.field = value;
+  }
+
+  for(size_t i = 0; i < ARRAYSIZE(stringKeys); ++i)
+  {
+    const StringKey& key = stringKeys[i];
+    const std::string* value = file.find(key.section, key.key);
+    outValues->*key.field = value ? *value : key.defaultValue;
+  }
+}
+
+void Config::applyValues(const Values& values, bool startup)
+{
+  configuredLongestFrameTime = values.longestFrameTime;
+  configuredHighestRenderVariance = values.highestRenderVariance;
+  resolveFailsafes();
+
+  numColumns = values.numColumns;
+
+  getColourComponent(values.fontColourR, &fontColour[0]);
+  getColourComponent(values.fontColourG, &fontColour[1]);
+  getColourComponent(values.fontColourB, &fontColour[2]);
+  fontColour[3] = 1.0f;
+
+  getColourComponent(values.backgroundColourR, &backgroundColour[0]);
+  getColourComponent(values.backgroundColourG, &backgroundColour[1]);
+  getColourComponent(values.backgroundColourB, &backgroundColour[2]);
   backgroundColour[3] = 1.0f;
+
+  frameIntervalUs = values.frameIntervalUs;
+  framesPerRefresh = values.framesPerRefresh;
+
+  failOnFrameAllocation = 0 != values.failOnFrameAllocation;
+  tracePath = values.tracePath;
+
+  if(startup)
+  {
+    renderThreadPerDevice = 0 != values.renderThreadPerDevice;
+    separateMessageThread = 0 != values.separateMessageThread;
+    telemetryEnabled = 0 != values.telemetryEnabled;
+    telemetryPath = values.telemetryPath;
+    profileEnabled = 0 != values.profileEnabled;
+    profilePath = values.profilePath;
+  }
+}
+
+void Config::resolveFailsafes()
+{
+  longestFrameTime = configuredLongestFrameTime / 10000.0;
+  if(longestFrameTime <= 0.0)
+  {
+    longestFrameTime = baselineFrameTimeP99 > 0.0 ? baselineFrameTimeP99 * BASELINE_FAILSAFE_MARGIN : DEFAULT_LONGEST_FRAME_TIME;
+  }
+  highestRenderVariance = configuredHighestRenderVariance / 10000.0;
+  if(highestRenderVariance <= 0.0)
+  {
+    highestRenderVariance = baselineRenderVarianceP99 > 0.0 ? baselineRenderVarianceP99 * BASELINE_FAILSAFE_MARGIN : DEFAULT_HIGHEST_RENDER_VARIANCE;
+  }
+}
+
+void Config::watcherMain()
+{
+  std::pair<long long, long long> lastStamp(0, 0);
+  bool hadFile = getFileStamp(CONFIG_PATH, &lastStamp);
+
+  std::unique_lock<std::mutex> lock(watcherMutex);
+  while(!watcherStopping)
+  {
+    watcherWake.wait_for(lock, std::chrono::milliseconds(WATCH_INTERVAL_MS));
+    if(watcherStopping)
+    {
+      break;
+    }
+
+    std::pair<long long, long long> stamp;
+    bool hasFile = getFileStamp(CONFIG_PATH, &stamp);
+    if(hasFile == hadFile && (!hasFile || stamp == lastStamp))
+    {
+      continue;
+    }
+    hadFile = hasFile;
+    lastStamp = stamp;
+
+    /* Parsed here so that the render loop only ever swaps a pointer */
+    IniFile file;
+    file.load(CONFIG_PATH);
+    Values* values = new Values();
+    readValues(file, values);
+    delete pendingValues.exchange(values);
+  }
 }
 
 float Config::getColourComponent(int colour, float* outDestination)
@@ -1,20 +1,135 @@
-#include <DirectXMath.h>
+#pragma once
+
+#include <stddef.h>
+#include <atomic>
+#include <string>
+
+class IniFile;
 
 class Config
 {
 public:
+  /**
+   * The contents of config.ini, as written in the file.
+   */
+  struct Values
+  {
+    /** In units of 1/10 of a millisecond */
+    int longestFrameTime;
+    int highestRenderVariance;
+
+    int numColumns;
+    int fontColourR;
+    int fontColourG;
+    int fontColourB;
+    int backgroundColourR;
+    int backgroundColourG;
+    int backgroundColourB;
+
+    int renderThreadPerDevice;
+    int separateMessageThread;
+    int frameIntervalUs;
+    int framesPerRefresh;
+    int telemetryEnabled;
+    std::string telemetryPath;
+    int profileEnabled;
+    std::string profilePath;
+    int failOnFrameAllocation;
+    std::string tracePath;
+  };
+
+  /**
+   * Reads config.ini and applies every key, including the ones that only take effect at startup.
+   */
   static void config();
 
+  /**
+   * Starts a thread that reparses config.ini whenever it changes and leaves the new values for applyPendingChanges().
+   */
+  static void startWatching();
+
+  /**
+   * Stops the watching thread. Must be called before exit if startWatching() was.
+   */
+  static void stopWatching();
+
+  /**
+   * Applies the values from the last change to config.ini, if it has changed since the last call.
+   * Only the FAILSAFES, DISPLAY, PACING and DEBUG keys are applied; the rest only take effect at startup.
+   * Call between frames, while nothing is rendering, so that a frame never sees half of a change.
+   * @return true if new values were applied
+   */
+  static bool applyPendingChanges();
+
   static double longestFrameTime;
   static double highestRenderVariance;
 
   static int numColumns;
-  static DirectX::XMVECTOR fontColour;
+  static float fontColour[4];
   static float backgroundColour[4];
 
+  /** Render each device's outputs on its own thread, released together on one counter sample. */
+  static bool renderThreadPerDevice;
+
+  /** Render on a raised-priority render thread, leaving the thread that owns the windows to only handle their messages. */
+  static bool separateMessageThread;
+
+  /**
+   * Frame pacing. When framesPerRefresh is not 0, frames are started that many times per refresh of the
+   * fastest output. Otherwise, when frameIntervalUs is not 0, frames are started that many microseconds apart.
+   * With both 0, frames are rendered as fast as possible.
+   */
+  static int frameIntervalUs;
+  static int framesPerRefresh;
+
+  /** Write every frame's timing to telemetryPath */
+  static bool telemetryEnabled;
+  static std::string telemetryPath;
+
+  /** Remember each output's display mode and measured refresh period in profilePath between sessions */
+  static bool profileEnabled;
+  static std::string profilePath;
+
+  /** Stop with an assertion, in debug builds, when a steady state frame allocates from the heap */
+  static bool failOnFrameAllocation;
+
+  /** Where the T key writes the frame loop's trace zones when it stops a trace */
+  static std::string tracePath;
+
+  /**
+   * Failsafes that were set to 0 follow the displays instead: they are set a margin above the
+   * 99th percentiles measured in an earlier session, or to the defaults if there was none.
+   * The baseline is kept, so that failsafes changed to 0 by a reload follow it too.
+   * @param frameTimeP99 in seconds, or 0 if there is no earlier session.
+   * @param renderVarianceP99 in seconds, or 0 if there is no earlier session.
+   */
+  static void applyBaseline(double frameTimeP99, double renderVarianceP99);
+
 protected:
+  /**
+   * Fills in every key from the file, using each key's default where the file does not have it.
+   */
+  static void readValues(const IniFile& file, Values* outValues);
+
+  /**
+   * @param startup also applies the keys that only take effect at startup.
+   */
+  static void applyValues(const Values& values, bool startup);
+
+  static void resolveFailsafes();
+  static void watcherMain();
+
   /**
    * @param outDestination if not NULL, the result will be written to this address.
    */
   static float getColourComponent(int colour, float* outDestination = NULL);
+
+  /** The failsafes as configured, before 0 is replaced by the baseline */
+  static int configuredLongestFrameTime;
+  static int configuredHighestRenderVariance;
+  static double baselineFrameTimeP99;
+  static double baselineRenderVarianceP99;
+
+  /** Left by the watcher for applyPendingChanges() to take */
+  static std::atomic<Values*> pendingValues;
 };
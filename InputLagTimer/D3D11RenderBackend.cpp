@@ -0,0 +1,117 @@
+#include "stdafx.h"
+#include "D3D11RenderBackend.h"
+#include "TraceZones.h"
+
+static_assert(sizeof(RenderBackend::SpriteVertex) == sizeof(DirectX::VertexPositionColorTexture), "SpriteVertex must match VertexPositionColorTexture");
+static_assert(sizeof(RenderBackend::ColorVertex) == sizeof(DirectX::VertexPositionColor), "ColorVertex must match VertexPositionColor");
+
+D3D11RenderBackend::D3D11RenderBackend(ID3D11DeviceContext* context,
+                                       DirectX::SpriteBatch* spriteBatch,
+                                       DirectX::PrimitiveBatch<DirectX::VertexPositionColor>* primitiveBatch,
+                                       DirectX::BasicEffect* basicEffect,
+                                       ID3D11InputLayout* inputLayout)
+  :mContext(context),
+  mSpriteBatch(spriteBatch),
+  mPrimitiveBatch(primitiveBatch),
+  mBasicEffect(basicEffect),
+  mInputLayout(inputLayout),
+  mRenderTargetView(NULL),
+  mSwapChain(NULL),
+  mBatch(BATCH_NONE)
+{
+  ZeroMemory(&mViewport, sizeof(mViewport));
+}
+
+D3D11RenderBackend::~D3D11RenderBackend(void)
+{
+}
+
+void D3D11RenderBackend::setTarget(ID3D11RenderTargetView* renderTargetView, IDXGISwapChain* swapChain, UINT width, UINT height)
+{
+  mRenderTargetView = renderTargetView;
+  mSwapChain = swapChain;
+  mViewport.Width = static_cast<FLOAT>(width);
+  mViewport.Height = static_cast<FLOAT>(height);
+  mViewport.MinDepth = 0.0f;
+  mViewport.MaxDepth = 1.0f;
+  mViewport.TopLeftX = 0;
+  mViewport.TopLeftY = 0;
+}
+
+void D3D11RenderBackend::beginFrame(const float clearColour[4])
+{
+  mContext->RSSetViewports(1, &mViewport);
+  mContext->OMSetRenderTargets(1, &mRenderTargetView, NULL);
+  clear(clearColour);
+}
+
+void D3D11RenderBackend::clear(const float colour[4])
+{
+  beginBatch(BATCH_NONE);
+  TRACE_ZONE("ClearRenderTargetView");
+  mContext->ClearRenderTargetView(mRenderTargetView, colour);
+}
+
+void D3D11RenderBackend::drawSprites(TextureHandle texture, size_t spriteCount, const SpriteWriter& writeVertices)
+{
+  beginBatch(BATCH_SPRITES);
+  /* Immediate mode maps the vertex buffer, writes the sprites and unmaps it inside DrawVertices */
+  TRACE_ZONE("SpriteBatch::DrawVertices");
+  ID3D11ShaderResourceView* shaderResourceView = static_cast<ID3D11ShaderResourceView*>(const_cast<void*>(texture));
+  mSpriteBatch->DrawVertices(shaderResourceView, spriteCount, [&writeVertices](DirectX::VertexPositionColorTexture* vertices, size_t firstSprite, size_t count)
+  {
+    writeVertices(reinterpret_cast<SpriteVertex*>(vertices), firstSprite, count);
+  });
+}
+
+void D3D11RenderBackend::drawTriangles(const ColorVertex* vertices, size_t triangleCount)
+{
+  beginBatch(BATCH_TRIANGLES);
+  TRACE_ZONE("PrimitiveBatch::Draw");
+  mPrimitiveBatch->Draw(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, reinterpret_cast<const DirectX::VertexPositionColor*>(vertices), triangleCount * 3);
+}
+
+void D3D11RenderBackend::present()
+{
+  beginBatch(BATCH_NONE);
+  if(mSwapChain)
+  {
+    TRACE_ZONE("Present");
+    mSwapChain->Present(0, 0);
+  }
+}
+
+void D3D11RenderBackend::beginBatch(Batch batch)
+{
+  if(batch == mBatch)
+  {
+    return;
+  }
+
+  if(mBatch == BATCH_SPRITES)
+  {
+    TRACE_ZONE("SpriteBatch::End");
+    mSpriteBatch->End();
+  }
+  else if(mBatch == BATCH_TRIANGLES)
+  {
+    TRACE_ZONE("PrimitiveBatch::End");
+    mPrimitiveBatch->End();
+  }
+
+  if(batch == BATCH_SPRITES)
+  {
+    /* Immediate, so that the vertices go straight to the vertex buffer without a flush per draw */
+    mSpriteBatch->Begin(DirectX::SpriteSortMode_Immediate);
+  }
+  else if(batch == BATCH_TRIANGLES)
+  {
+    /* The effect is shared with windows of other sizes */
+    TRACE_ZONE("BasicEffect::Apply");
+    mBasicEffect->SetProjection(DirectX::XMMatrixOrthographicOffCenterRH(0, mViewport.Width, mViewport.Height, 0, 0, 1));
+    mBasicEffect->Apply(mContext);
+    mContext->IASetInputLayout(mInputLayout);
+    mPrimitiveBatch->Begin();
+  }
+  mBatch = batch;
+}
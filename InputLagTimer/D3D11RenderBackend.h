@@ -0,0 +1,67 @@
+#pragma once
+#include "RenderBackend.h"
+#include "SpriteBatch.h"
+#include "PrimitiveBatch.h"
+#include "VertexTypes.h"
+#include "Effects.h"
+
+/**
+ * Draws a window's frames with a device's immediate context: sprites through SpriteBatch::DrawVertices,
+ * and triangles through PrimitiveBatch with BasicEffect. The batches and effect are usually a device's
+ * shared DeviceResources, so a backend is only used on the thread that renders the device's windows.
+ *
+ * A batch is begun by the first draw that needs it and ended when the other batch is needed, the target is
+ * cleared, or the frame is presented, so consecutive sprite draws share one Begin.
+ */
+class D3D11RenderBackend : public RenderBackend
+{
+public:
+  /**
+   * None of the arguments are owned.
+   * @param primitiveBatch, basicEffect and inputLayout draw triangles, and may be NULL if no triangles are drawn.
+   */
+  D3D11RenderBackend(ID3D11DeviceContext* context,
+                     DirectX::SpriteBatch* spriteBatch,
+                     DirectX::PrimitiveBatch<DirectX::VertexPositionColor>* primitiveBatch,
+                     DirectX::BasicEffect* basicEffect,
+                     ID3D11InputLayout* inputLayout);
+  virtual ~D3D11RenderBackend(void);
+
+  /**
+   * Sets what beginFrame() binds and present() presents. Called again whenever the swap chain's buffers are resized.
+   * @param swapChain may be NULL to draw without presenting. Not owned, nor is renderTargetView.
+   */
+  void setTarget(ID3D11RenderTargetView* renderTargetView, IDXGISwapChain* swapChain, UINT width, UINT height);
+
+  virtual void beginFrame(const float clearColour[4]);
+  virtual void clear(const float colour[4]);
+  virtual void drawSprites(TextureHandle texture, size_t spriteCount, const SpriteWriter& writeVertices);
+  virtual void drawTriangles(const ColorVertex* vertices, size_t triangleCount);
+  virtual void present();
+
+protected:
+  enum Batch
+  {
+    BATCH_NONE,
+    BATCH_SPRITES,
+    BATCH_TRIANGLES
+  };
+
+  /** Ends the batch that is begun, and begins the one given, if they are different */
+  void beginBatch(Batch batch);
+
+  ID3D11DeviceContext* mContext;
+  DirectX::SpriteBatch* mSpriteBatch;
+  DirectX::PrimitiveBatch<DirectX::VertexPositionColor>* mPrimitiveBatch;
+  DirectX::BasicEffect* mBasicEffect;
+  ID3D11InputLayout* mInputLayout;
+
+  ID3D11RenderTargetView* mRenderTargetView;
+  IDXGISwapChain* mSwapChain;
+  D3D11_VIEWPORT mViewport;
+  Batch mBatch;
+
+private:
+  D3D11RenderBackend(const D3D11RenderBackend&);
+  D3D11RenderBackend& operator=(const D3D11RenderBackend&);
+};
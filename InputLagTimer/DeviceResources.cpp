@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "DeviceResources.h"
+#include "Clock.h"
+#include "PlatformHelpers.h"
+#include "SharedResourcePool.h"
+
+FontLoader* DeviceResources::fontLoader = nullptr;
+int DeviceResources::createdCount = 0;
+int DeviceResources::reusedCount = 0;
+uint64_t DeviceResources::savedBytes = 0;
+double DeviceResources::savedSeconds = 0.0;
+
+namespace
+{
+  DirectX::SharedResourcePool<ID3D11Device*, DeviceResources> deviceResourcesPool;
+}
+
+std::shared_ptr<DeviceResources> DeviceResources::getForDevice(ID3D11Device* device)
+{
+  int createdBefore = createdCount;
+  std::shared_ptr<DeviceResources> resources = deviceResourcesPool.DemandCreate(device);
+  if(createdCount == createdBefore)
+  {
+    reusedCount++;
+    savedBytes += resources->mFontBytes;
+    savedSeconds += resources->mCreateSeconds;
+  }
+  return resources;
+}
+
+void DeviceResources::setFontLoader(FontLoader* loader)
+{
+  fontLoader = loader;
+}
+
+int DeviceResources::getCreatedCount()
+{
+  return createdCount;
+}
+
+int DeviceResources::getReusedCount()
+{
+  return reusedCount;
+}
+
+uint64_t DeviceResources::getSavedBytes()
+{
+  return savedBytes;
+}
+
+double DeviceResources::getSavedSeconds()
+{
+  return savedSeconds;
+}
+
+DeviceResources::DeviceResources(ID3D11Device* device)
+  :mNormalFont(nullptr),
+  mInputLayout(nullptr),
+  mFontBytes(0),
+  mCreateSeconds(0.0)
+{
+  Clock* clock = Clock::getSystemClock();
+  uint64_t startCount = clock->getCount();
+
+  /* The windows' contexts are the device's immediate context */
+  ID3D11DeviceContext* context = nullptr;
+  device->GetImmediateContext(&context);
+  mSpriteBatch.reset(new DirectX::SpriteBatch(context));
+  mPrimitiveBatch.reset(new DirectX::PrimitiveBatch<DirectX::VertexPositionColor>(context));
+  context->Release();
+
+  mBasicEffect.reset(new DirectX::BasicEffect(device));
+  mBasicEffect->SetVertexColorEnabled(true);
+
+  void const* shaderByteCode;
+  size_t byteCodeLength;
+  mBasicEffect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
+
+  device->CreateInputLayout(DirectX::VertexPositionColor::InputElements,
+                            DirectX::VertexPositionColor::InputElementCount,
+                            shaderByteCode, byteCodeLength,
+                            &mInputLayout);
+
+  /* Create the fonts' textures. Waits for the fonts if they are still being parsed. */
+  const std::vector<FontLoader::ParsedFont>& timerFonts = fontLoader->getTimerFonts();
+  for(auto iter = timerFonts.begin(); iter != timerFonts.end(); ++iter)
+  {
+    mTimerFonts.push_back(createFont(device, *iter));
+    mTimerTextRenderers.push_back(new TimerTextRenderer(mTimerFonts.back()));
+  }
+  mNormalFont = createFont(device, fontLoader->getNormalFont());
+
+  mCreateSeconds = static_cast<double>(clock->getCount() - startCount) / clock->getFrequency();
+  createdCount++;
+}
+
+DeviceResources::~DeviceResources(void)
+{
+  for(auto iter = mTimerTextRenderers.begin(); iter != mTimerTextRenderers.end(); ++iter)
+  {
+    delete *iter;
+  }
+  for(auto iter = mTimerFonts.begin(); iter != mTimerFonts.end(); ++iter)
+  {
+    delete *iter;
+  }
+  delete mNormalFont;
+  for(auto iter = mFontTextures.begin(); iter != mFontTextures.end(); ++iter)
+  {
+    (*iter)->Release();
+  }
+  if(mInputLayout)
+  {
+    mInputLayout->Release();
+  }
+}
+
+FontFace* DeviceResources::createFont(ID3D11Device* device, const FontLoader::ParsedFont& font)
+{
+  mFontBytes += font.mapping->Size();
+  ID3D11ShaderResourceView* texture = nullptr;
+  DirectX::ThrowIfFailed(DirectX::CreateSpriteFontTexture(device, font.view, &texture));
+  mFontTextures.push_back(texture);
+  return new FontFace(font.view, texture);
+}
+
+const std::vector<TimerTextRenderer*>& DeviceResources::getTimerTextRenderers() const
+{
+  return mTimerTextRenderers;
+}
+
+const FontFace* DeviceResources::getNormalFont() const
+{
+  return mNormalFont;
+}
+
+DirectX::SpriteBatch* DeviceResources::getSpriteBatch() const
+{
+  return mSpriteBatch.get();
+}
+
+DirectX::PrimitiveBatch<DirectX::VertexPositionColor>* DeviceResources::getPrimitiveBatch() const
+{
+  return mPrimitiveBatch.get();
+}
+
+DirectX::BasicEffect* DeviceResources::getBasicEffect() const
+{
+  return mBasicEffect.get();
+}
+
+ID3D11InputLayout* DeviceResources::getInputLayout() const
+{
+  return mInputLayout;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "SpriteBatch.h"
+#include "SpriteFont.h"
+#include "PrimitiveBatch.h"
+#include "VertexTypes.h"
+#include "Effects.h"
+#include "FontLoader.h"
+#include "FontFace.h"
+#include "TimerTextRenderer.h"
+
+/**
+ * The fonts, effect and batches that every window on a device can share.
+ * Several outputs on one GPU used to load their own copy of every font texture;
+ * now the first window on a device creates these and the others reuse them.
+ *
+ * The batches draw with the device's immediate context, so they may only be used
+ * by the one thread that renders the device's windows. The basic effect's projection
+ * depends on the window size, so it must be set each time before the effect is applied.
+ */
+class DeviceResources
+{
+public:
+  /**
+   * @return the resources for this device, created if no window on the device holds them.
+   */
+  static std::shared_ptr<DeviceResources> getForDevice(ID3D11Device* device);
+
+  /**
+   * Sets where the fonts come from when a device's resources are created.
+   * Must be set while windows are being created; the loader is not owned.
+   */
+  static void setFontLoader(FontLoader* fontLoader);
+
+  /**
+   * @return the number of devices that have had their resources created.
+   */
+  static int getCreatedCount();
+
+  /**
+   * @return the number of times that a window reused another window's resources instead of creating its own.
+   */
+  static int getReusedCount();
+
+  /**
+   * @return the bytes of font data that would have been loaded again by the windows that reused resources.
+   */
+  static uint64_t getSavedBytes();
+
+  /**
+   * @return the time in seconds that creating the resources would have taken for the windows that reused them.
+   */
+  static double getSavedSeconds();
+
+  /** Use getForDevice() so that the resources are shared */
+  explicit DeviceResources(ID3D11Device* device);
+  virtual ~DeviceResources(void);
+
+  /** @return a renderer for each of the timer fonts, in the order of their file names */
+  const std::vector<TimerTextRenderer*>& getTimerTextRenderers() const;
+  const FontFace* getNormalFont() const;
+  DirectX::SpriteBatch* getSpriteBatch() const;
+  DirectX::PrimitiveBatch<DirectX::VertexPositionColor>* getPrimitiveBatch() const;
+  DirectX::BasicEffect* getBasicEffect() const;
+  ID3D11InputLayout* getInputLayout() const;
+
+protected:
+  /**
+   * Creates the font's texture on this device, held in mFontTextures. Throws if it can't be created.
+   * The size of the font file is added to mFontBytes.
+   * @return the font, drawing with that texture.
+   */
+  FontFace* createFont(ID3D11Device* device, const FontLoader::ParsedFont& font);
+
+  static FontLoader* fontLoader;
+  static int createdCount;
+  static int reusedCount;
+  static uint64_t savedBytes;
+  static double savedSeconds;
+
+  /** The fonts' textures. FontFace lays out and draws every font, so there is no SpriteFont to hold them. */
+  std::vector<ID3D11ShaderResourceView*> mFontTextures;
+  std::vector<FontFace*> mTimerFonts;
+  std::vector<TimerTextRenderer*> mTimerTextRenderers;
+  FontFace* mNormalFont;
+  std::unique_ptr<DirectX::SpriteBatch> mSpriteBatch;
+  std::unique_ptr<DirectX::PrimitiveBatch<DirectX::VertexPositionColor>> mPrimitiveBatch;
+  std::unique_ptr<DirectX::BasicEffect> mBasicEffect;
+  ID3D11InputLayout* mInputLayout;
+
+  uint64_t mFontBytes;
+  double mCreateSeconds;
+
+private:
+  DeviceResources(const DeviceResources&);
+  DeviceResources& operator=(const DeviceResources&);
+};
@@ -0,0 +1,129 @@
+#include "DisplayProfile.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#pragma warning(disable : 4996)
+#endif
+
+DisplayProfile::DisplayProfile(void)
+{
+  memset(&mFrameTime, 0, sizeof(mFrameTime));
+  memset(&mRenderVariance, 0, sizeof(mRenderVariance));
+}
+
+bool DisplayProfile::load(const std::string& path)
+{
+  mOutputs.clear();
+  memset(&mFrameTime, 0, sizeof(mFrameTime));
+  memset(&mRenderVariance, 0, sizeof(mRenderVariance));
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if(!file)
+  {
+    return false;
+  }
+
+  DisplayProfileHeader header;
+  bool valid = fread(&header, sizeof(header), 1, file) == 1
+    && memcmp(header.magic, DISPLAY_PROFILE_MAGIC, sizeof(header.magic)) == 0
+    && header.version == DISPLAY_PROFILE_VERSION
+    && header.recordSize == sizeof(DisplayProfileOutputRecord);
+  if(valid)
+  {
+    mOutputs.resize(header.outputCount);
+    valid = header.outputCount == 0 || fread(mOutputs.data(), sizeof(DisplayProfileOutputRecord), header.outputCount, file) == header.outputCount;
+  }
+  fclose(file);
+
+  if(!valid)
+  {
+    mOutputs.clear();
+    return false;
+  }
+
+  for(auto iter = mOutputs.begin(); iter != mOutputs.end(); ++iter)
+  {
+    iter->identity[DISPLAY_PROFILE_IDENTITY_LENGTH - 1] = '\0';
+  }
+  mFrameTime = header.frameTime;
+  mRenderVariance = header.renderVariance;
+  return true;
+}
+
+bool DisplayProfile::save(const std::string& path) const
+{
+  FILE* file = fopen(path.c_str(), "wb");
+  if(!file)
+  {
+    return false;
+  }
+
+  DisplayProfileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, DISPLAY_PROFILE_MAGIC, sizeof(header.magic));
+  header.version = DISPLAY_PROFILE_VERSION;
+  header.recordSize = sizeof(DisplayProfileOutputRecord);
+  header.outputCount = static_cast<uint32_t>(mOutputs.size());
+  header.frameTime = mFrameTime;
+  header.renderVariance = mRenderVariance;
+
+  bool written = fwrite(&header, sizeof(header), 1, file) == 1
+    && (mOutputs.empty() || fwrite(mOutputs.data(), sizeof(DisplayProfileOutputRecord), mOutputs.size(), file) == mOutputs.size());
+  return fclose(file) == 0 && written;
+}
+
+const DisplayProfileOutputRecord* DisplayProfile::findOutput(const std::string& identity) const
+{
+  DisplayProfileOutputRecord key;
+  setIdentity(identity, &key);
+  for(auto iter = mOutputs.begin(); iter != mOutputs.end(); ++iter)
+  {
+    if(strcmp(iter->identity, key.identity) == 0)
+    {
+      return &*iter;
+    }
+  }
+  return NULL;
+}
+
+void DisplayProfile::setOutput(const DisplayProfileOutputRecord& output)
+{
+  for(auto iter = mOutputs.begin(); iter != mOutputs.end(); ++iter)
+  {
+    if(strcmp(iter->identity, output.identity) == 0)
+    {
+      *iter = output;
+      return;
+    }
+  }
+  mOutputs.push_back(output);
+}
+
+void DisplayProfile::setIdentity(const std::string& identity, DisplayProfileOutputRecord* outOutput)
+{
+  memset(outOutput->identity, 0, sizeof(outOutput->identity));
+  size_t length = identity.size() < DISPLAY_PROFILE_IDENTITY_LENGTH - 1 ? identity.size() : DISPLAY_PROFILE_IDENTITY_LENGTH - 1;
+  memcpy(outOutput->identity, identity.data(), length);
+}
+
+const Percentiles& DisplayProfile::getFrameTime() const
+{
+  return mFrameTime;
+}
+
+const Percentiles& DisplayProfile::getRenderVariance() const
+{
+  return mRenderVariance;
+}
+
+void DisplayProfile::setBaseline(const Percentiles& frameTime, const Percentiles& renderVariance)
+{
+  mFrameTime = frameTime;
+  mRenderVariance = renderVariance;
+}
+
+bool DisplayProfile::hasBaseline() const
+{
+  return mFrameTime.max > 0.0;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Histogram.h"
+
+/**
+ * What was learned about the displays in earlier sessions, so that the next launch
+ * can skip finding each output's display mode and start with a known refresh period
+ * and frame time baseline instead of waiting for them to settle.
+ *
+ * The file is a DisplayProfileHeader followed by a DisplayProfileOutputRecord per output.
+ * All values are little-endian. A file with a different magic or version is ignored.
+ */
+
+#define DISPLAY_PROFILE_MAGIC "ILTPROFL"
+#define DISPLAY_PROFILE_VERSION 1
+
+/** Identities longer than this are truncated, which only matters if two outputs then collide */
+#define DISPLAY_PROFILE_IDENTITY_LENGTH 96
+
+#pragma pack(push, 1)
+
+struct DisplayProfileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint32_t outputCount;
+  uint32_t reserved;
+  /** In seconds, over every output during the last session. Zero if there was no session yet. */
+  Percentiles frameTime;
+  Percentiles renderVariance;
+};
+
+struct DisplayProfileOutputRecord
+{
+  char identity[DISPLAY_PROFILE_IDENTITY_LENGTH];
+  /** The desktop mode that the display mode was chosen for */
+  uint32_t desktopWidth;
+  uint32_t desktopHeight;
+  uint32_t desktopFrequency;
+  /** The chosen DXGI_MODE_DESC */
+  uint32_t width;
+  uint32_t height;
+  uint32_t refreshNumerator;
+  uint32_t refreshDenominator;
+  uint32_t format;
+  uint32_t scanlineOrdering;
+  uint32_t scaling;
+  /** The refresh period measured from the output's vblanks in seconds, or zero if it never was */
+  double refreshPeriod;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(DisplayProfileHeader) == 104, "DisplayProfileHeader layout is part of the file format");
+static_assert(sizeof(DisplayProfileOutputRecord) == 144, "DisplayProfileOutputRecord layout is part of the file format");
+
+class DisplayProfile
+{
+public:
+  DisplayProfile(void);
+
+  /**
+   * Replaces the contents of the profile with the file's.
+   * @return false, leaving the profile empty, if the file is missing, cut short or from another version.
+   */
+  bool load(const std::string& path);
+
+  /**
+   * @return false if the file could not be written.
+   */
+  bool save(const std::string& path) const;
+
+  /**
+   * @return the output with this identity, or NULL if the profile has not seen it.
+   */
+  const DisplayProfileOutputRecord* findOutput(const std::string& identity) const;
+
+  /**
+   * Adds the output, or replaces the output with the same identity.
+   */
+  void setOutput(const DisplayProfileOutputRecord& output);
+
+  /**
+   * Fills in the identity of a record, truncating it if it is too long.
+   */
+  static void setIdentity(const std::string& identity, DisplayProfileOutputRecord* outOutput);
+
+  /**
+   * @return the last session's frame time in seconds. Every value is zero if there was none.
+   */
+  const Percentiles& getFrameTime() const;
+  const Percentiles& getRenderVariance() const;
+  void setBaseline(const Percentiles& frameTime, const Percentiles& renderVariance);
+
+  /**
+   * @return true if the last session recorded a baseline.
+   */
+  bool hasBaseline() const;
+
+protected:
+  std::vector<DisplayProfileOutputRecord> mOutputs;
+  Percentiles mFrameTime;
+  Percentiles mRenderVariance;
+};
@@ -0,0 +1,162 @@
+#include "FontFace.h"
+#include <wctype.h>
+#include <algorithm>
+
+FontFace::FontFace(const DirectX::SpriteFontView& font, RenderBackend::TextureHandle texture)
+  :mGlyphs(font.glyphs, font.glyphs + font.glyphCount),
+  mDefaultGlyph(NULL),
+  mLineSpacing(font.lineSpacing),
+  mTexture(texture),
+  mInverseTextureWidth(1.0f / font.textureWidth),
+  mInverseTextureHeight(1.0f / font.textureHeight)
+{
+  mGlyphLookup.Reset(mGlyphs.data(), mGlyphs.data() + mGlyphs.size());
+  mDefaultGlyph = mGlyphLookup.Find(font.defaultCharacter);
+}
+
+FontFace::~FontFace(void)
+{
+}
+
+const FontFace::Glyph* FontFace::findGlyph(wchar_t character) const
+{
+  const Glyph* glyph = mGlyphLookup.Find(static_cast<uint32_t>(character));
+  return glyph ? glyph : mDefaultGlyph;
+}
+
+template<typename TAction>
+void FontFace::forEachGlyph(const wchar_t* text, TAction action) const
+{
+  float x = 0.0f;
+  float y = 0.0f;
+  for(; *text; ++text)
+  {
+    wchar_t character = *text;
+    if(character == L'\r')
+    {
+      continue;
+    }
+    if(character == L'\n')
+    {
+      x = 0.0f;
+      y += mLineSpacing;
+      continue;
+    }
+
+    /* SpriteFont throws for a character that it can't draw; a frame is better off without it */
+    const Glyph* glyph = findGlyph(character);
+    if(!glyph)
+    {
+      continue;
+    }
+
+    x += glyph->XOffset;
+    if(x < 0.0f)
+    {
+      x = 0.0f;
+    }
+    if(!iswspace(character))
+    {
+      action(glyph, x, y);
+    }
+    x += glyph->Subrect.right - glyph->Subrect.left + glyph->XAdvance;
+  }
+}
+
+void FontFace::measureString(const wchar_t* text, float* outWidth, float* outHeight) const
+{
+  float width = 0.0f;
+  float height = 0.0f;
+  float lineSpacing = mLineSpacing;
+  forEachGlyph(text, [&](const Glyph* glyph, float x, float y)
+  {
+    float w = static_cast<float>(glyph->Subrect.right - glyph->Subrect.left);
+    float h = std::max(static_cast<float>(glyph->Subrect.bottom - glyph->Subrect.top) + glyph->YOffset, lineSpacing);
+    width = std::max(width, x + w);
+    height = std::max(height, y + h);
+  });
+  *outWidth = width;
+  *outHeight = height;
+}
+
+size_t FontFace::countGlyphs(const wchar_t* text) const
+{
+  size_t glyphCount = 0;
+  forEachGlyph(text, [&glyphCount](const Glyph*, float, float)
+  {
+    ++glyphCount;
+  });
+  return glyphCount;
+}
+
+void FontFace::drawString(RenderBackend* backend, const wchar_t* text, float x, float y, const float colour[4]) const
+{
+  size_t glyphCount = countGlyphs(text);
+
+  /* The backend may ask for the glyphs a batch at a time, so each call lays the whole string out and writes the ones asked for.
+     The writer only holds a pointer to this, so that std::function can hold it without allocating. */
+  StringDraw draw = { this, text, x, y, colour };
+  const StringDraw* drawPointer = &draw;
+  backend->drawSprites(mTexture, glyphCount, [drawPointer](RenderBackend::SpriteVertex* vertices, size_t firstSprite, size_t spriteCount)
+  {
+    drawPointer->font->writeGlyphs(*drawPointer, vertices, firstSprite, spriteCount);
+  });
+}
+
+size_t FontFace::layoutString(const wchar_t* text, float x, float y, const float colour[4], std::vector<RenderBackend::SpriteVertex>* outVertices) const
+{
+  size_t glyphCount = countGlyphs(text);
+  if(glyphCount > 0)
+  {
+    size_t first = outVertices->size();
+    outVertices->resize(first + glyphCount * 4);
+    StringDraw draw = { this, text, x, y, colour };
+    writeGlyphs(draw, &(*outVertices)[first], 0, glyphCount);
+  }
+  return glyphCount;
+}
+
+void FontFace::writeGlyphs(const StringDraw& draw, RenderBackend::SpriteVertex* vertices, size_t firstSprite, size_t spriteCount) const
+{
+  size_t index = 0;
+  forEachGlyph(draw.text, [&](const Glyph* glyph, float x, float y)
+  {
+    if(index >= firstSprite && index < firstSprite + spriteCount)
+    {
+      float width = static_cast<float>(glyph->Subrect.right - glyph->Subrect.left);
+      float height = static_cast<float>(glyph->Subrect.bottom - glyph->Subrect.top);
+      /* The same corner order as SpriteBatch */
+      for(int corner = 0; corner < 4; ++corner)
+      {
+        float cornerX = static_cast<float>(corner & 1);
+        float cornerY = static_cast<float>(corner >> 1);
+        RenderBackend::SpriteVertex& vertex = *vertices++;
+        vertex.x = draw.x + x + cornerX * width;
+        vertex.y = draw.y + y + glyph->YOffset + cornerY * height;
+        vertex.z = 0.0f;
+        vertex.r = draw.colour[0];
+        vertex.g = draw.colour[1];
+        vertex.b = draw.colour[2];
+        vertex.a = draw.colour[3];
+        vertex.u = (glyph->Subrect.left + cornerX * width) * mInverseTextureWidth;
+        vertex.v = (glyph->Subrect.top + cornerY * height) * mInverseTextureHeight;
+      }
+    }
+    ++index;
+  });
+}
+
+RenderBackend::TextureHandle FontFace::getTexture() const
+{
+  return mTexture;
+}
+
+float FontFace::getInverseTextureWidth() const
+{
+  return mInverseTextureWidth;
+}
+
+float FontFace::getInverseTextureHeight() const
+{
+  return mInverseTextureHeight;
+}
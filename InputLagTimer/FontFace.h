@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "GlyphLookup.h"
+#include "SpriteFontParser.h"
+#include "RenderBackend.h"
+
+/**
+ * A font's glyphs and texture, for laying out and drawing text through a RenderBackend.
+ * Text is laid out with the same rules as SpriteFont::DrawString and MeasureString, and drawn
+ * with the vertices that SpriteBatch would write for it, unrotated and unscaled.
+ * This is the only text layout that InputLagTimer uses: its fonts are never made into SpriteFonts,
+ * and their textures are created with DirectX::CreateSpriteFontTexture.
+ */
+class FontFace
+{
+public:
+  typedef DirectX::SpriteFontView::Glyph Glyph;
+
+  /**
+   * @param font is copied, so it does not need to outlive this.
+   * @param texture the font's texture, as the backend that draws it knows it. Not owned.
+   */
+  FontFace(const DirectX::SpriteFontView& font, RenderBackend::TextureHandle texture);
+  virtual ~FontFace(void);
+
+  /**
+   * @return the character's glyph, the default character's if the font does not have it,
+   * or NULL if the font has no default character either.
+   */
+  const Glyph* findGlyph(wchar_t character) const;
+
+  /**
+   * Gives the size that SpriteFont::MeasureString would.
+   */
+  void measureString(const wchar_t* text, float* outWidth, float* outHeight) const;
+
+  /**
+   * Draws the text with its top left at (x, y).
+   * @param colour red, green, blue and alpha from 0 to 1.
+   */
+  void drawString(RenderBackend* backend, const wchar_t* text, float x, float y, const float colour[4]) const;
+
+  /**
+   * Writes the vertices that drawString() would draw, 4 per glyph, to the end of outVertices,
+   * so that text which stays the same can be drawn again without being laid out again.
+   * @return the number of glyphs written.
+   */
+  size_t layoutString(const wchar_t* text, float x, float y, const float colour[4], std::vector<RenderBackend::SpriteVertex>* outVertices) const;
+
+  RenderBackend::TextureHandle getTexture() const;
+  float getInverseTextureWidth() const;
+  float getInverseTextureHeight() const;
+
+protected:
+  /** What drawString() was asked to draw */
+  struct StringDraw
+  {
+    const FontFace* font;
+    const wchar_t* text;
+    float x;
+    float y;
+    const float* colour;
+  };
+
+  /**
+   * Calls action(glyph, x, y) for each glyph that is drawn, with the pen position relative to the start of the text.
+   */
+  template<typename TAction>
+  void forEachGlyph(const wchar_t* text, TAction action) const;
+
+  /** @return the number of glyphs that drawing the text draws */
+  size_t countGlyphs(const wchar_t* text) const;
+
+  /** Writes the vertices of the glyphs numbered firstSprite to firstSprite + spriteCount */
+  void writeGlyphs(const StringDraw& draw, RenderBackend::SpriteVertex* vertices, size_t firstSprite, size_t spriteCount) const;
+
+  std::vector<Glyph> mGlyphs;
+  DirectX::GlyphLookup<Glyph> mGlyphLookup;
+  const Glyph* mDefaultGlyph;
+  float mLineSpacing;
+  RenderBackend::TextureHandle mTexture;
+  float mInverseTextureWidth;
+  float mInverseTextureHeight;
+
+private:
+  FontFace(const FontFace&);
+  FontFace& operator=(const FontFace&);
+};
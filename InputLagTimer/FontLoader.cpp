@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include "FontLoader.h"
+#include "Window.h"
+
+FontLoader::FontLoader(const std::wstring& timerFontPath, const std::wstring& normalFontPath)
+  :mClock(Clock::getSystemClock()),
+  mWaitCounts(0)
+{
+  mStartCount = mClock->getCount();
+  mFinishCount = mStartCount;
+  mTimerFonts = std::async(std::launch::async, [this, timerFontPath]() { return parseDirectory(timerFontPath); }).share();
+  mNormalFont = std::async(std::launch::async, [this, normalFontPath]() { return parseFile(normalFontPath); }).share();
+}
+
+FontLoader::~FontLoader(void)
+{
+  /* The workers update mFinishCount, so they must be done before this goes away */
+  if(mTimerFonts.valid())
+  {
+    mTimerFonts.wait();
+  }
+  if(mNormalFont.valid())
+  {
+    mNormalFont.wait();
+  }
+}
+
+const std::vector<FontLoader::ParsedFont>& FontLoader::getTimerFonts()
+{
+  waitFor(mTimerFonts);
+  return mTimerFonts.get();
+}
+
+const FontLoader::ParsedFont& FontLoader::getNormalFont()
+{
+  waitFor(mNormalFont);
+  return mNormalFont.get();
+}
+
+double FontLoader::getParseSeconds()
+{
+  waitFor(mTimerFonts);
+  waitFor(mNormalFont);
+  return static_cast<double>(mFinishCount - mStartCount) / mClock->getFrequency();
+}
+
+double FontLoader::getWaitSeconds() const
+{
+  return static_cast<double>(mWaitCounts) / mClock->getFrequency();
+}
+
+template<typename T>
+void FontLoader::waitFor(const std::shared_future<T>& future)
+{
+  if(future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+  {
+    uint64_t waitStart = mClock->getCount();
+    future.wait();
+    mWaitCounts += mClock->getCount() - waitStart;
+  }
+}
+
+std::vector<FontLoader::ParsedFont> FontLoader::parseDirectory(const std::wstring& path)
+{
+  bool error;
+  std::set<std::wstring, InsensitiveCompare>* fontPaths = Window::getFontPaths(path, &error);
+  std::vector<std::future<ParsedFont>> parsing;
+  for(auto iter = fontPaths->begin(); iter != fontPaths->end(); ++iter)
+  {
+    std::wstring fullPath = path;
+    fullPath.append(*iter);
+    parsing.push_back(std::async(std::launch::async, [this, fullPath]() { return parseFile(fullPath); }));
+  }
+  delete fontPaths;
+
+  /* Let every worker finish before any failure is rethrown, since they all use this loader */
+  for(auto iter = parsing.begin(); iter != parsing.end(); ++iter)
+  {
+    iter->wait();
+  }
+
+  std::vector<ParsedFont> result;
+  for(auto iter = parsing.begin(); iter != parsing.end(); ++iter)
+  {
+    result.push_back(iter->get());
+  }
+  return result;
+}
+
+FontLoader::ParsedFont FontLoader::parseFile(const std::wstring& path)
+{
+  ParsedFont result;
+  result.mapping = DirectX::FileMapping::Open(path);
+  DirectX::ParseSpriteFont(result.mapping->Data(), result.mapping->Size(), &result.view);
+
+  /* Keep the latest finish across all of the workers */
+  uint64_t finishCount = mClock->getCount();
+  uint64_t latest = mFinishCount;
+  while(finishCount > latest && !mFinishCount.compare_exchange_weak(latest, finishCount))
+  {
+  }
+  return result;
+}
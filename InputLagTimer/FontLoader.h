@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Clock.h"
+#include "FileMapping.h"
+#include "SpriteFontParser.h"
+
+/**
+ * Reads and parses the spritefont files on worker threads, starting as soon as it is constructed,
+ * so that startup is not waiting on the disk while adapters, devices and windows are being set up.
+ * Creating the textures needs a device, so that part is left to the main thread.
+ */
+class FontLoader
+{
+public:
+  /**
+   * A parsed font. The view points into the mapping, which is kept open for as long as the font is.
+   */
+  struct ParsedFont
+  {
+    std::shared_ptr<DirectX::FileMapping> mapping;
+    DirectX::SpriteFontView view;
+  };
+
+  FontLoader(const std::wstring& timerFontPath, const std::wstring& normalFontPath);
+  virtual ~FontLoader(void);
+
+  /**
+   * Waits for the timer fonts if they are still being parsed. Throws if a font could not be read.
+   * @return the timer fonts, in the order of their file names
+   */
+  const std::vector<ParsedFont>& getTimerFonts();
+
+  /**
+   * Waits for the normal font if it is still being parsed. Throws if the font could not be read.
+   */
+  const ParsedFont& getNormalFont();
+
+  /**
+   * @return the seconds that the workers took to read and parse every font, once they are all done.
+   */
+  double getParseSeconds();
+
+  /**
+   * @return the seconds that callers spent waiting for fonts that were not parsed yet.
+   */
+  double getWaitSeconds() const;
+
+protected:
+  /**
+   * Parses every font in the directory, each on its own worker.
+   */
+  std::vector<ParsedFont> parseDirectory(const std::wstring& path);
+  ParsedFont parseFile(const std::wstring& path);
+
+  /**
+   * Adds the time spent waiting to mWaitCounts if the future is not ready yet.
+   */
+  template<typename T>
+  void waitFor(const std::shared_future<T>& future);
+
+  Clock* mClock;
+  uint64_t mStartCount;
+  /** The latest count at which a worker finished parsing a font */
+  std::atomic<uint64_t> mFinishCount;
+  uint64_t mWaitCounts;
+  std::shared_future<std::vector<ParsedFont>> mTimerFonts;
+  std::shared_future<ParsedFont> mNormalFont;
+
+private:
+  FontLoader(const FontLoader&);
+  FontLoader& operator=(const FontLoader&);
+};
@@ -0,0 +1,49 @@
+#include "FrameLoop.h"
+#include "AllocationTracker.h"
+#include "Config.h"
+#include "TimingSession.h"
+#include "TraceZones.h"
+#include <assert.h>
+
+FrameLoop::FrameLoop(TimingSession* session, Outputs* outputs)
+  :mSession(session),
+  mOutputs(outputs),
+  mLoopCount(0)
+{
+}
+
+FrameLoop::~FrameLoop(void)
+{
+}
+
+void FrameLoop::run()
+{
+  TRACE_ZONE("FrameLoop::run");
+  AllocationTracker::frameStarted();
+  AllocationTracker::Scope scope(AllocationTracker::SUBSYSTEM_FRAME_LOOP);
+
+  /* Nothing is rendering between frames, so this is where changes to config.ini
+     and the render state changes asked for by window messages take effect.
+     Either can reallocate what the frames draw with, so the loop is not a steady state one. */
+  bool changed = Config::applyPendingChanges();
+  changed = mOutputs->processCommands() > 0 || changed;
+
+  {
+    AllocationTracker::Scope modelScope(AllocationTracker::SUBSYSTEM_MODEL);
+    mSession->loopStarted();
+  }
+  mOutputs->renderOutputs();
+  mSession->loopComplete();
+
+  bool steadyState = !changed && mLoopCount >= WARMUP_LOOPS;
+  if(AllocationTracker::frameComplete(steadyState) && Config::failOnFrameAllocation)
+  {
+    assert(!"A steady state frame allocated from the heap. AllocationTracker::getFrameCounts() has the subsystems that did.");
+  }
+  ++mLoopCount;
+}
+
+uint64_t FrameLoop::getLoopCount() const
+{
+  return mLoopCount;
+}
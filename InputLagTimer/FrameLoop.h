@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+
+class TimingSession;
+
+/**
+ * One pass of the frame loop, which renders a frame for every output: config changes and queued
+ * commands are made, the session's timings are combined, the outputs are rendered, and the
+ * loop's heap allocations are checked. WindowManager::render() runs it with its windows as the
+ * outputs, and FrameLoopBenchmark with virtual outputs, so that both measure the same loop.
+ */
+class FrameLoop
+{
+public:
+  /**
+   * What the loop renders.
+   */
+  class Outputs
+  {
+  public:
+    virtual ~Outputs(void) {}
+
+    /**
+     * Makes the render state changes queued since the last loop. Nothing is rendering when it is called.
+     * @return the number of changes made.
+     */
+    virtual int processCommands() = 0;
+
+    /**
+     * Renders one frame for every output.
+     */
+    virtual void renderOutputs() = 0;
+  };
+
+  /** Loops that lay out and create what later loops reuse, before a loop that allocates is a steady state one */
+  static const uint64_t WARMUP_LOOPS = 2;
+
+  /**
+   * @param session and outputs are not owned, and must outlive this.
+   */
+  FrameLoop(TimingSession* session, Outputs* outputs);
+  virtual ~FrameLoop(void);
+
+  /**
+   * Runs one loop. Only called from the thread that renders.
+   */
+  void run();
+
+  /** @return the number of loops run */
+  uint64_t getLoopCount() const;
+
+protected:
+  TimingSession* mSession;
+  Outputs* mOutputs;
+  uint64_t mLoopCount;
+
+private:
+  FrameLoop(const FrameLoop&);
+  FrameLoop& operator=(const FrameLoop&);
+};
@@ -0,0 +1,168 @@
+#include "FramePacer.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#else
+#include <errno.h>
+#include <time.h>
+#endif
+
+/* The spin margin starts at this many microseconds, and never shrinks below a tenth of it */
+#define INITIAL_SPIN_MARGIN_US 2000
+/* How far past the latest wake-up seen the spin margin is set, as a fraction of it */
+#define SPIN_MARGIN_HEADROOM 0.25
+/* The spin margin shrinks by 1/this of the way towards the last sleep's lateness after each sleep,
+   and towards the calibrated margin after each wait too short to sleep in */
+#define SPIN_MARGIN_DECAY 256
+/* The spin margin never grows past this many times the calibrated one, so one sleep that the OS
+   woke very late cannot leave every later wait too short to sleep in */
+#define SPIN_MARGIN_CAP 4
+#define CALIBRATION_SLEEP_US 1000
+
+FramePacer::FramePacer(Clock* clock)
+  :mClock(clock),
+  mFrequency(clock->getFrequency()),
+  mWaitedCounts(0),
+  mSpunCounts(0)
+{
+  mSpinMargin = mFrequency * INITIAL_SPIN_MARGIN_US / 1000000;
+  mCalibratedSpinMargin = mSpinMargin;
+  mMinSpinMargin = mSpinMargin / 10;
+  mMaxSpinMargin = mSpinMargin * SPIN_MARGIN_CAP;
+#if defined(_WIN32)
+  /* Otherwise Sleep(1) can take as long as the 15.6ms default tick */
+  timeBeginPeriod(1);
+#endif
+}
+
+FramePacer::~FramePacer(void)
+{
+#if defined(_WIN32)
+  timeEndPeriod(1);
+#endif
+}
+
+uint64_t FramePacer::waitUntil(uint64_t targetCount)
+{
+  uint64_t start = mClock->getCount();
+  uint64_t now = start;
+
+  /* Differences are taken as signed, so a target that has already passed is never waited for */
+  int64_t remaining = static_cast<int64_t>(targetCount - now);
+  if(remaining > static_cast<int64_t>(mSpinMargin))
+  {
+    uint64_t sleepCounts = remaining - mSpinMargin;
+    sleepFor(sleepCounts);
+    now = mClock->getCount();
+
+    /* Widen the margin as soon as a sleep wakes later than it allowed for, and narrow it slowly otherwise */
+    uint64_t lateness = now - start > sleepCounts ? now - start - sleepCounts : 0;
+    if(lateness >= mSpinMargin)
+    {
+      mSpinMargin = lateness + static_cast<uint64_t>(lateness * SPIN_MARGIN_HEADROOM);
+      mSpinMargin = mSpinMargin > mMaxSpinMargin ? mMaxSpinMargin : mSpinMargin;
+    }
+    else
+    {
+      mSpinMargin -= (mSpinMargin - lateness) / SPIN_MARGIN_DECAY;
+      mSpinMargin = mSpinMargin < mMinSpinMargin ? mMinSpinMargin : mSpinMargin;
+    }
+  }
+  else if(remaining > 0 && mSpinMargin > mCalibratedSpinMargin)
+  {
+    /* Nothing was slept, so there is no lateness to go by. Narrow back towards the calibrated margin,
+       so that waits a margin widened by a late sleep made too short to sleep in are slept in again. */
+    mSpinMargin -= (mSpinMargin - mCalibratedSpinMargin + SPIN_MARGIN_DECAY - 1) / SPIN_MARGIN_DECAY;
+  }
+
+  uint64_t spinStart = now;
+  while(static_cast<int64_t>(targetCount - now) > 0)
+  {
+    now = mClock->getCount();
+  }
+  mSpunCounts += now - spinStart;
+  mWaitedCounts += now - start;
+
+  /* A frame that overran its target is not the pacer's error */
+  if(remaining > 0)
+  {
+    mWakeErrors.record(toNanoseconds(now - targetCount));
+  }
+  return now;
+}
+
+void FramePacer::calibrate(int sleepCount)
+{
+  uint64_t sleepCounts = mFrequency * CALIBRATION_SLEEP_US / 1000000;
+  uint64_t latest = 0;
+  for(int i = 0; i < sleepCount; ++i)
+  {
+    uint64_t start = mClock->getCount();
+    sleepFor(sleepCounts);
+    uint64_t slept = mClock->getCount() - start;
+    uint64_t lateness = slept > sleepCounts ? slept - sleepCounts : 0;
+    latest = lateness > latest ? lateness : latest;
+  }
+  mSpinMargin = latest + static_cast<uint64_t>(latest * SPIN_MARGIN_HEADROOM);
+  mSpinMargin = mSpinMargin < mMinSpinMargin ? mMinSpinMargin : mSpinMargin;
+  mCalibratedSpinMargin = mSpinMargin;
+  mMaxSpinMargin = mSpinMargin * SPIN_MARGIN_CAP;
+}
+
+const Histogram& FramePacer::getWakeErrors() const
+{
+  return mWakeErrors;
+}
+
+uint64_t FramePacer::getSpinMargin() const
+{
+  return mSpinMargin;
+}
+
+uint64_t FramePacer::getMaxSpinMargin() const
+{
+  return mMaxSpinMargin;
+}
+
+uint64_t FramePacer::getSleepGranularity() const
+{
+#if defined(_WIN32)
+  return mFrequency / 1000;
+#else
+  return 0;
+#endif
+}
+
+double FramePacer::getSpinFraction() const
+{
+  return mWaitedCounts > 0 ? static_cast<double>(mSpunCounts) / mWaitedCounts : 0.0;
+}
+
+void FramePacer::sleepFor(uint64_t counts)
+{
+#if defined(_WIN32)
+  /* Rounded down, since the spin makes up the rest */
+  DWORD milliseconds = static_cast<DWORD>(counts * 1000 / mFrequency);
+  if(milliseconds > 0)
+  {
+    Sleep(milliseconds);
+  }
+#else
+  uint64_t nanoseconds = toNanoseconds(counts);
+  timespec duration;
+  duration.tv_sec = static_cast<time_t>(nanoseconds / 1000000000ull);
+  duration.tv_nsec = static_cast<long>(nanoseconds % 1000000000ull);
+  /* Relative, because the clock is CLOCK_MONOTONIC_RAW, which clock_nanosleep cannot wait on */
+  while(clock_nanosleep(CLOCK_MONOTONIC, 0, &duration, &duration) == EINTR)
+  {
+  }
+#endif
+}
+
+uint64_t FramePacer::toNanoseconds(uint64_t counts) const
+{
+  return static_cast<uint64_t>(static_cast<double>(counts) * 1000000000.0 / mFrequency + 0.5);
+}
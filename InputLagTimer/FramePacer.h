@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stdint.h>
+#include "Clock.h"
+#include "Histogram.h"
+
+/**
+ * Waits until the clock reaches a target count, without spinning on the counter for the whole wait.
+ * The OS sleep is coarse and wakes late by a varying amount, so the pacer sleeps until a margin
+ * before the target and spins on the counter for the rest. The margin is calibrated on construction
+ * from how late short sleeps wake, and raised whenever a sleep wakes later than it allowed for, up to
+ * a few times the calibrated margin. It narrows again slowly after every wait, slept in or not.
+ *
+ * Sleeping uses Sleep with a 1ms timer resolution on Windows, and clock_nanosleep elsewhere.
+ */
+class FramePacer
+{
+public:
+  explicit FramePacer(Clock* clock);
+  virtual ~FramePacer(void);
+
+  /**
+   * Sleeps and then spins until the clock reaches targetCount, and records how late it woke.
+   * Returns at once if targetCount has already passed.
+   * @return the count at which the wait ended.
+   */
+  uint64_t waitUntil(uint64_t targetCount);
+
+  /**
+   * Measures how late sleeps of about a millisecond wake, and sets the spin margin from the latest of them.
+   */
+  void calibrate(int sleepCount);
+
+  /**
+   * @return in nanoseconds, how far past the target each waitUntil() returned.
+   */
+  const Histogram& getWakeErrors() const;
+
+  /**
+   * @return the counts before the target at which sleeping stops and spinning starts.
+   */
+  uint64_t getSpinMargin() const;
+
+  /**
+   * @return the widest the spin margin can grow to, which is a few times the calibrated margin.
+   */
+  uint64_t getMaxSpinMargin() const;
+
+  /**
+   * @return in counts, the granularity that sleeps are rounded down to, with the spin making up the rest. 0 if sleeps are not rounded.
+   */
+  uint64_t getSleepGranularity() const;
+
+  /**
+   * @return the fraction of the time spent waiting that was spent spinning rather than asleep.
+   */
+  double getSpinFraction() const;
+
+protected:
+  /**
+   * Sleeps for about the given number of counts, using the OS timer.
+   */
+  void sleepFor(uint64_t counts);
+
+  uint64_t toNanoseconds(uint64_t counts) const;
+
+  Clock* mClock;
+  uint64_t mFrequency;
+  uint64_t mSpinMargin;
+  /** The margin set by the last calibration, which waits too short to sleep in narrow the margin back towards */
+  uint64_t mCalibratedSpinMargin;
+  /** The smallest and largest margins the spin is allowed to shrink and grow to */
+  uint64_t mMinSpinMargin;
+  uint64_t mMaxSpinMargin;
+
+  Histogram mWakeErrors;
+  uint64_t mWaitedCounts;
+  uint64_t mSpunCounts;
+
+private:
+  FramePacer(const FramePacer&);
+  FramePacer& operator=(const FramePacer&);
+};
@@ -0,0 +1,187 @@
+#include "FrameScheduler.h"
+#include "AllocationTracker.h"
+#include "TraceZones.h"
+#include <string>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+/* How long a lane spins for the next frame before it sleeps. Long enough to cover the gap
+   between frames when they are not paced, so that only a lane that would idle sleeps. */
+#define LANE_SPIN_SECONDS 0.0002
+
+FrameScheduler::FrameScheduler(Clock* clock, const std::vector<Lane>& lanes)
+  :mClock(clock),
+  mLanes(lanes),
+  mLaneStartCounts(lanes.size(), 0),
+  mGeneration(0),
+  mSleepingLanes(0),
+  mLanesComplete(0),
+  mLanesCompleteEvent(nullptr),
+  mStopping(false),
+  mSharedCount(0),
+  mFrameCount(0),
+  mLastReleaseSpread(0),
+  mMaxReleaseSpread(0)
+{
+#if defined(_WIN32)
+  mLanesCompleteEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+#endif
+  for(size_t i = 0; i < mLanes.size(); ++i)
+  {
+    mThreads.push_back(std::thread(&FrameScheduler::laneMain, this, i));
+  }
+}
+
+FrameScheduler::~FrameScheduler(void)
+{
+  mStopping.store(true);
+  /* Wake the lanes so they can see that they are stopping */
+  releaseLanes();
+  for(auto iter = mThreads.begin(); iter != mThreads.end(); ++iter)
+  {
+    iter->join();
+  }
+#if defined(_WIN32)
+  CloseHandle(mLanesCompleteEvent);
+#endif
+}
+
+void FrameScheduler::runFrame()
+{
+  if(mLanes.empty())
+  {
+    return;
+  }
+  mLanesComplete.store(0, std::memory_order_relaxed);
+
+  /* QUERY THE PERFORMANCE COUNTER! Once, for every output. */
+  mSharedCount = mClock->getCount();
+  releaseLanes();
+  ++mFrameCount;
+
+#if defined(_WIN32)
+  /* The lanes Present to windows that may belong to this thread, and DXGI waits from Present for
+     the messages it sends them to be handled, so waiting without handling them could deadlock.
+     Only sent messages are handled here. Posted ones are left for the message loop, so no input
+     or command is handled in the middle of a frame. */
+  HANDLE lanesComplete = mLanesCompleteEvent;
+  while(MsgWaitForMultipleObjects(1, &lanesComplete, FALSE, INFINITE, QS_SENDMESSAGE) == WAIT_OBJECT_0 + 1)
+  {
+    MSG msg;
+    PeekMessage(&msg, NULL, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+  }
+#else
+  while(mLanesComplete.load(std::memory_order_acquire) < mLanes.size())
+  {
+    std::this_thread::yield();
+  }
+#endif
+
+  uint64_t earliest = mLaneStartCounts[0];
+  uint64_t latest = mLaneStartCounts[0];
+  for(auto iter = mLaneStartCounts.begin(); iter != mLaneStartCounts.end(); ++iter)
+  {
+    if(*iter < earliest)
+    {
+      earliest = *iter;
+    }
+    if(*iter > latest)
+    {
+      latest = *iter;
+    }
+  }
+  mLastReleaseSpread = latest - earliest;
+  if(mLastReleaseSpread > mMaxReleaseSpread)
+  {
+    mMaxReleaseSpread = mLastReleaseSpread;
+  }
+}
+
+double FrameScheduler::getLastReleaseSpread() const
+{
+  return ((double)mLastReleaseSpread) / mClock->getFrequency();
+}
+
+double FrameScheduler::getMaxReleaseSpread() const
+{
+  return ((double)mMaxReleaseSpread) / mClock->getFrequency();
+}
+
+uint64_t FrameScheduler::getFrameCount() const
+{
+  return mFrameCount;
+}
+
+void FrameScheduler::releaseLanes()
+{
+  mGeneration.fetch_add(1);
+  /* A lane counts itself as sleeping before it checks the generation for the last time, so either it
+     sees the new generation, or it is counted here. Taking the mutex makes sure it is waiting by then. */
+  if(mSleepingLanes.load() > 0)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mReleaseMutex);
+    }
+    mRelease.notify_all();
+  }
+}
+
+uint64_t FrameScheduler::waitForRelease(uint64_t seenGeneration)
+{
+  /* Spin rather than sleep at first: waking from a kernel wait adds skew between the lanes */
+  uint64_t spinCounts = static_cast<uint64_t>(mClock->getFrequency() * LANE_SPIN_SECONDS);
+  uint64_t spinStart = mClock->getCount();
+  uint64_t generation = mGeneration.load(std::memory_order_acquire);
+  while(generation == seenGeneration && mClock->getCount() - spinStart < spinCounts)
+  {
+    std::this_thread::yield();
+    generation = mGeneration.load(std::memory_order_acquire);
+  }
+  if(generation != seenGeneration)
+  {
+    return generation;
+  }
+
+  std::unique_lock<std::mutex> lock(mReleaseMutex);
+  mSleepingLanes.fetch_add(1);
+  generation = mGeneration.load();
+  while(generation == seenGeneration)
+  {
+    mRelease.wait(lock);
+    generation = mGeneration.load();
+  }
+  mSleepingLanes.fetch_sub(1);
+  return generation;
+}
+
+void FrameScheduler::laneMain(size_t laneIndex)
+{
+  TraceZones::registerThread(("lane " + std::to_string(static_cast<unsigned long long>(laneIndex))).c_str());
+  /* Everything the lane does from here on is part of a frame, as on the thread that runs the loop */
+  AllocationTracker::Scope scope(AllocationTracker::SUBSYSTEM_FRAME_LOOP);
+  uint64_t seenGeneration = 0;
+  while(true)
+  {
+    seenGeneration = waitForRelease(seenGeneration);
+
+    if(mStopping.load())
+    {
+      return;
+    }
+
+    mLaneStartCounts[laneIndex] = mClock->getCount();
+    mLanes[laneIndex](mSharedCount);
+
+#if defined(_WIN32)
+    if(mLanesComplete.fetch_add(1, std::memory_order_release) + 1 == mLanes.size())
+    {
+      SetEvent(mLanesCompleteEvent);
+    }
+#else
+    mLanesComplete.fetch_add(1, std::memory_order_release);
+#endif
+  }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Clock.h"
+
+/**
+ * Renders outputs in lock-step on one worker thread per lane.
+ * Each frame, the counter is sampled once and every lane is released with
+ * that shared count, so all outputs show the same timer value and the skew
+ * between them no longer grows with the render and Present time of the
+ * outputs before them.
+ *
+ * A lane is normally one device: a D3D11 immediate context may only be used
+ * by one thread at a time, so all outputs on a device render on its lane.
+ *
+ * After finishing a frame, a lane spins for a short while in case the next
+ * frame is released straight away, and then sleeps until it is, so that lanes
+ * that are paced or waiting on vsync do not each keep a core busy.
+ */
+class FrameScheduler
+{
+public:
+  /**
+   * Renders a lane's outputs using the shared count as the frame's timer sample.
+   */
+  typedef std::function<void(uint64_t sharedCount)> Lane;
+
+  FrameScheduler(Clock* clock, const std::vector<Lane>& lanes);
+  virtual ~FrameScheduler(void);
+
+  /**
+   * Samples the clock, releases every lane with that count, and returns
+   * once every lane has finished its frame. Does nothing if there are no lanes.
+   * On Windows, the messages sent to this thread's windows while it waits are handled,
+   * since the lanes' Present waits for them.
+   */
+  void runFrame();
+
+  /**
+   * @return the time in seconds between the first and last lane starting work in the last frame.
+   */
+  double getLastReleaseSpread() const;
+
+  /**
+   * @return the largest release spread in seconds seen since the scheduler started.
+   */
+  double getMaxReleaseSpread() const;
+
+  uint64_t getFrameCount() const;
+
+protected:
+  void laneMain(size_t laneIndex);
+
+  /**
+   * Increments mGeneration, and wakes the lanes that are sleeping.
+   */
+  void releaseLanes();
+
+  /**
+   * Waits for mGeneration to move on from seenGeneration: spinning at first, then sleeping.
+   * @return the new generation.
+   */
+  uint64_t waitForRelease(uint64_t seenGeneration);
+
+  Clock* mClock;
+  std::vector<Lane> mLanes;
+  std::vector<std::thread> mThreads;
+
+  /** Written by each lane's thread: the count at which it woke for the current frame. */
+  std::vector<uint64_t> mLaneStartCounts;
+
+  /** Incremented by the main thread to release the lanes. */
+  std::atomic<uint64_t> mGeneration;
+  /** The lanes that have stopped spinning, and wait on mRelease to be released */
+  std::atomic<size_t> mSleepingLanes;
+  std::mutex mReleaseMutex;
+  std::condition_variable mRelease;
+  std::atomic<size_t> mLanesComplete;
+  /** On Windows, an event set by the last lane to complete a frame, which runFrame() waits on while handling messages */
+  void* mLanesCompleteEvent;
+  std::atomic<bool> mStopping;
+  uint64_t mSharedCount;
+  uint64_t mFrameCount;
+
+  uint64_t mLastReleaseSpread;
+  uint64_t mMaxReleaseSpread;
+
+private:
+  FrameScheduler(const FrameScheduler&);
+  FrameScheduler& operator=(const FrameScheduler&);
+};
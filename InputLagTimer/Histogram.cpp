@@ -0,0 +1,120 @@
+#include "Histogram.h"
+#include <string.h>
+
+Histogram::Histogram(void)
+{
+  clear();
+}
+
+void Histogram::clear()
+{
+  memset(mCounts, 0, sizeof(mCounts));
+  mTotalCount = 0;
+  mMax = 0;
+}
+
+void Histogram::add(const Histogram& other)
+{
+  for(int i = 0; i < BUCKET_COUNT; ++i)
+  {
+    mCounts[i] += other.mCounts[i];
+  }
+  mTotalCount += other.mTotalCount;
+  if(other.mMax > mMax)
+  {
+    mMax = other.mMax;
+  }
+}
+
+uint64_t Histogram::getValueAtPercentile(double percentile) const
+{
+  if(mTotalCount == 0)
+  {
+    return 0;
+  }
+
+  uint64_t countAtPercentile = static_cast<uint64_t>(percentile / 100.0 * mTotalCount + 0.5);
+  if(countAtPercentile < 1)
+  {
+    countAtPercentile = 1;
+  }
+
+  uint64_t runningCount = 0;
+  for(int i = 0; i < BUCKET_COUNT; ++i)
+  {
+    runningCount += mCounts[i];
+    if(runningCount >= countAtPercentile)
+    {
+      uint64_t highest = getBucketHighestValue(i);
+      return highest < mMax ? highest : mMax;
+    }
+  }
+  return mMax;
+}
+
+uint64_t Histogram::getMax() const
+{
+  return mMax;
+}
+
+uint64_t Histogram::getTotalCount() const
+{
+  return mTotalCount;
+}
+
+uint64_t Histogram::getBucketLowestValue(int index)
+{
+  if(index < 2 * SUB_BUCKET_COUNT)
+  {
+    return index;
+  }
+  int shift = index / SUB_BUCKET_COUNT - 1;
+  return static_cast<uint64_t>(index - shift * SUB_BUCKET_COUNT) << shift;
+}
+
+uint64_t Histogram::getBucketHighestValue(int index)
+{
+  if(index < 2 * SUB_BUCKET_COUNT)
+  {
+    return index;
+  }
+  int shift = index / SUB_BUCKET_COUNT - 1;
+  return getBucketLowestValue(index) + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+SlidingHistogram::SlidingHistogram(int windowCount)
+  :mWindows(windowCount),
+  mCurrentWindow(0)
+{
+}
+
+void SlidingHistogram::advance()
+{
+  mCurrentWindow = (mCurrentWindow + 1) % mWindows.size();
+  mWindows[mCurrentWindow].clear();
+
+  mMerged.clear();
+  for(auto iter = mWindows.begin(); iter != mWindows.end(); ++iter)
+  {
+    mMerged.add(*iter);
+  }
+}
+
+const Histogram& SlidingHistogram::getLastWindow() const
+{
+  return mWindows[(mCurrentWindow + mWindows.size() - 1) % mWindows.size()];
+}
+
+const Histogram& SlidingHistogram::getAllWindows() const
+{
+  return mMerged;
+}
+
+void Percentiles::fromNanoseconds(const Histogram& histogram)
+{
+  p50 = histogram.getValueAtPercentile(50.0) / 1000000000.0;
+  p90 = histogram.getValueAtPercentile(90.0) / 1000000000.0;
+  p99 = histogram.getValueAtPercentile(99.0) / 1000000000.0;
+  p999 = histogram.getValueAtPercentile(99.9) / 1000000000.0;
+  max = histogram.getMax() / 1000000000.0;
+}
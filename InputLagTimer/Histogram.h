@@ -0,0 +1,139 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * A fixed-size log-linear histogram in the style of HdrHistogram.
+ * Values below 64 have their own bucket. Above that, every power of two is
+ * split into 32 linear sub-buckets, so any recorded value is known to within
+ * about 3%. Recording is O(1) and never allocates.
+ * Values are unsigned integers; the timer records nanoseconds.
+ */
+class Histogram
+{
+public:
+  static const int SUB_BUCKET_BITS = 5;
+  static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+  /** Values at or above 2^36 (about 68 seconds in ns) are counted in the last bucket. */
+  static const int MAX_VALUE_BITS = 36;
+  static const int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+  Histogram(void);
+
+  void record(uint64_t value)
+  {
+    ++mCounts[getBucketIndex(value)];
+    ++mTotalCount;
+    if(value > mMax)
+    {
+      mMax = value;
+    }
+  }
+
+  void clear();
+
+  /**
+   * Adds all of the counts of other into this histogram.
+   */
+  void add(const Histogram& other);
+
+  /**
+   * @param percentile between 0 and 100.
+   * @return the highest value that is equivalent to the value at the percentile, or 0 if nothing was recorded.
+   */
+  uint64_t getValueAtPercentile(double percentile) const;
+
+  uint64_t getMax() const;
+  uint64_t getTotalCount() const;
+
+  static int getBucketIndex(uint64_t value);
+  static uint64_t getBucketLowestValue(int index);
+  static uint64_t getBucketHighestValue(int index);
+
+protected:
+  uint32_t mCounts[BUCKET_COUNT];
+  uint64_t mTotalCount;
+  uint64_t mMax;
+};
+
+/**
+ * A ring of histograms, one per time window, that together cover a sliding span of time.
+ * Values are recorded into the current window. Calling advance() closes the current window
+ * and reuses the oldest one, so memory stays fixed no matter how long the timer runs.
+ */
+class SlidingHistogram
+{
+public:
+  explicit SlidingHistogram(int windowCount);
+
+  void record(uint64_t value)
+  {
+    mWindows[mCurrentWindow].record(value);
+  }
+
+  /**
+   * Closes the current window and starts recording into a cleared window.
+   */
+  void advance();
+
+  /**
+   * @return the most recently closed window.
+   */
+  const Histogram& getLastWindow() const;
+
+  /**
+   * @return every closed window merged together. Only valid until the next call to advance().
+   */
+  const Histogram& getAllWindows() const;
+
+protected:
+  std::vector<Histogram> mWindows;
+  int mCurrentWindow;
+  /** The closed windows merged together, rebuilt on each advance() */
+  Histogram mMerged;
+};
+
+/**
+ * The summary of a histogram shown on the HUD, in seconds.
+ */
+struct Percentiles
+{
+  double p50;
+  double p90;
+  double p99;
+  double p999;
+  double max;
+
+  /**
+   * Summarises a histogram of nanosecond values.
+   */
+  void fromNanoseconds(const Histogram& histogram);
+};
+
+inline int Histogram::getBucketIndex(uint64_t value)
+{
+  if(value < 2 * SUB_BUCKET_COUNT)
+  {
+    return static_cast<int>(value);
+  }
+
+  /* Find the most significant bit */
+  int msb = 0;
+  uint64_t remaining = value;
+  if(remaining >> 32) { remaining >>= 32; msb += 32; }
+  if(remaining >> 16) { remaining >>= 16; msb += 16; }
+  if(remaining >> 8) { remaining >>= 8; msb += 8; }
+  if(remaining >> 4) { remaining >>= 4; msb += 4; }
+  if(remaining >> 2) { remaining >>= 2; msb += 2; }
+  if(remaining >> 1) { msb += 1; }
+
+  if(msb >= MAX_VALUE_BITS)
+  {
+    return BUCKET_COUNT - 1;
+  }
+
+  /* The top SUB_BUCKET_BITS + 1 bits select the bucket within the power of two */
+  int shift = msb - SUB_BUCKET_BITS;
+  return shift * SUB_BUCKET_COUNT + static_cast<int>(value >> shift);
+}
@@ -0,0 +1,171 @@
+#include "IniFile.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(disable : 4996)
+#endif
+
+namespace
+{
+  bool isSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r';
+  }
+
+  /* Narrows [begin, end) to exclude surrounding whitespace */
+  void trim(const char** begin, const char** end)
+  {
+    while(*begin < *end && isSpace(**begin))
+    {
+      ++*begin;
+    }
+    while(*end > *begin && isSpace(*(*end - 1)))
+    {
+      --*end;
+    }
+  }
+}
+
+bool IniFile::load(const std::string& path)
+{
+  mValues.clear();
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if(!file)
+  {
+    return false;
+  }
+
+  std::vector<char> text;
+  char buffer[4096];
+  size_t bytesRead;
+  while((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0)
+  {
+    text.insert(text.end(), buffer, buffer + bytesRead);
+  }
+  bool readError = ferror(file) != 0;
+  fclose(file);
+  if(readError)
+  {
+    return false;
+  }
+
+  parse(text.data(), text.size());
+  return true;
+}
+
+void IniFile::parse(const char* text, size_t length)
+{
+  mValues.clear();
+
+  const char* end = text + length;
+  const char* section = "";
+  size_t sectionLength = 0;
+
+  /* Skip a UTF-8 byte order mark */
+  if(length >= 3 && memcmp(text, "\xEF\xBB\xBF", 3) == 0)
+  {
+    text += 3;
+  }
+
+  const char* lineStart = text;
+  while(lineStart < end)
+  {
+    const char* lineEnd = static_cast<const char*>(memchr(lineStart, '\n', end - lineStart));
+    if(!lineEnd)
+    {
+      lineEnd = end;
+    }
+
+    const char* begin = lineStart;
+    const char* finish = lineEnd;
+    trim(&begin, &finish);
+
+    if(begin < finish && *begin != ';' && *begin != '#')
+    {
+      if(*begin == '[')
+      {
+        const char* close = static_cast<const char*>(memchr(begin, ']', finish - begin));
+        if(close)
+        {
+          const char* nameBegin = begin + 1;
+          const char* nameEnd = close;
+          trim(&nameBegin, &nameEnd);
+          section = nameBegin;
+          sectionLength = nameEnd - nameBegin;
+        }
+      }
+      else
+      {
+        const char* equals = static_cast<const char*>(memchr(begin, '=', finish - begin));
+        if(equals)
+        {
+          const char* keyEnd = equals;
+          trim(&begin, &keyEnd);
+          const char* valueBegin = equals + 1;
+          const char* valueEnd = finish;
+          trim(&valueBegin, &valueEnd);
+          if(valueEnd - valueBegin >= 2 && (*valueBegin == '"' || *valueBegin == '\'') && *(valueEnd - 1) == *valueBegin)
+          {
+            ++valueBegin;
+            --valueEnd;
+          }
+
+          /* insert does not replace, so the first occurrence wins */
+          mValues.insert(std::make_pair(makeName(section, sectionLength, begin, keyEnd - begin), std::string(valueBegin, valueEnd)));
+        }
+      }
+    }
+
+    lineStart = lineEnd + 1;
+  }
+}
+
+const std::string* IniFile::find(const char* section, const char* key) const
+{
+  auto iter = mValues.find(makeName(section, strlen(section), key, strlen(key)));
+  return iter == mValues.end() ? NULL : &iter->second;
+}
+
+bool IniFile::getInt(const char* section, const char* key, int* outValue) const
+{
+  const std::string* value = find(section, key);
+  if(!value)
+  {
+    return false;
+  }
+
+  long result = 0;
+  const char* digits = value->c_str();
+  if(isdigit(static_cast<unsigned char>(*digits)))
+  {
+    result = strtol(digits, NULL, 10);
+  }
+  if(result > INT_MAX)
+  {
+    result = INT_MAX;
+  }
+  *outValue = result > 0 ? static_cast<int>(result) : 0;
+  return true;
+}
+
+std::string IniFile::makeName(const char* section, size_t sectionLength, const char* key, size_t keyLength)
+{
+  std::string name;
+  name.reserve(sectionLength + 1 + keyLength);
+  for(size_t i = 0; i < sectionLength; ++i)
+  {
+    name += static_cast<char>(tolower(static_cast<unsigned char>(section[i])));
+  }
+  name += ']';
+  for(size_t i = 0; i < keyLength; ++i)
+  {
+    name += static_cast<char>(tolower(static_cast<unsigned char>(key[i])));
+  }
+  return name;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <map>
+#include <string>
+
+/**
+ * Reads an INI file in one pass, with the same rules as GetPrivateProfileString:
+ * section and key names are case-insensitive, the first occurrence of a key wins,
+ * lines starting with ';' or '#' are comments, whitespace around names and values
+ * is ignored and a value wrapped in matching quotes has them removed.
+ */
+class IniFile
+{
+public:
+  /**
+   * Replaces the contents with the file's.
+   * @return false, leaving the contents empty, if the file could not be read.
+   */
+  bool load(const std::string& path);
+
+  /**
+   * Replaces the contents with the parsed text.
+   */
+  void parse(const char* text, size_t length);
+
+  /**
+   * @return the value of the key, or NULL if the key is not in the file.
+   */
+  const std::string* find(const char* section, const char* key) const;
+
+  /**
+   * Reads the key as GetPrivateProfileInt does: the leading decimal digits of the value,
+   * or 0 if there are none or the number is negative.
+   * @return false, leaving outValue untouched, if the key is not in the file.
+   */
+  bool getInt(const char* section, const char* key, int* outValue) const;
+
+protected:
+  /** @return the lower case "section]key" that values are stored under */
+  static std::string makeName(const char* section, size_t sectionLength, const char* key, size_t keyLength);
+
+  std::map<std::string, std::string> mValues;
+};
@@ -6,6 +6,11 @@
 #include "Setup.h"
 #include "WindowManager.h"
 #include "Config.h"
+#include "DisplayProfile.h"
+#include "FontLoader.h"
+#include "StartupProfile.h"
+#include "RenderLoop.h"
+#include "TraceZones.h"
 
 #define MAX_LOADSTRING 100
 
@@ -20,6 +25,8 @@ ATOM				MyRegisterClass(HINSTANCE hInstance);
 BOOL				InitInstance(HINSTANCE, int);
 LRESULT CALLBACK	WndProc(HWND, UINT, WPARAM, LPARAM);
 INT_PTR CALLBACK	About(HWND, UINT, WPARAM, LPARAM);
+void reportStartup(StartupProfile* startupProfile, FontLoader* fontLoader);
+void handleMessage(MSG* msg, HACCEL hAccelTable, RenderLoop* renderLoop);
 
 int APIENTRY _tWinMain(_In_ HINSTANCE hInstance,
                      _In_opt_ HINSTANCE hPrevInstance,
@@ -42,29 +49,65 @@ int APIENTRY _tWinMain(_In_ HINSTANCE hInstance,
 		return FALSE;
 	}
 
+  /* Start reading the fonts so that they are ready by the time the devices are */
+  StartupProfile* startupProfile = new StartupProfile(Clock::getSystemClock());
+  FontLoader* fontLoader = new FontLoader(L"res/fonts/timer/", L"res/fonts/normal.spritefont");
+
   /* Config INI file */
   Config::config();
+  Config::startWatching();
+  startupProfile->endPhase(L"config");
+
+  /* What earlier sessions learned about the displays */
+  DisplayProfile* displayProfile = nullptr;
+  if(Config::profileEnabled)
+  {
+    displayProfile = new DisplayProfile();
+    displayProfile->load(Config::profilePath);
+  }
 
   /* Setup of windows */
-  Setup* setup = new Setup();
-  windowManager = new WindowManager(setup->getSettings(), hInstance);
+  Setup* setup = new Setup(displayProfile);
+  startupProfile->endPhase(L"system analysis");
+  if(displayProfile)
+  {
+    wchar_t report[128];
+    _snwprintf_s(report, 128, _TRUNCATE, L"Display profile: %d outputs used their profiled display mode\n", setup->getProfiledOutputCount());
+    OutputDebugString(report);
+  }
+  windowManager = new WindowManager(setup->getSettings(), hInstance, fontLoader, startupProfile, displayProfile);
   delete setup;
 
 	hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_INPUTLAGTIMER));
 
+  /* The first frame is always rendered here, so that startup is measured the same way in either mode */
+  TraceZones::registerThread("main");
+  Clock* clock = Clock::getSystemClock();
+  RenderLoop* renderLoop = new RenderLoop(windowManager, clock);
+  renderLoop->renderFrame();
+  startupProfile->endPhase(L"first frame");
+  reportStartup(startupProfile, fontLoader);
+  delete fontLoader;
+  fontLoader = nullptr;
+  delete startupProfile;
+  startupProfile = nullptr;
+  if(Config::separateMessageThread)
+  {
+    renderLoop->start();
+  }
+
   // Main message loop
   MSG msg = {0};
   bool justRendered = true;
   while( WM_QUIT != msg.message )
   {
-    if(!windowManager)
+    if(renderLoop->isRunning())
     {
-	    GetMessage(&msg, NULL, 0, 0);
-		  if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
-		  {
-			  TranslateMessage(&msg);
-			  DispatchMessage(&msg);
-		  }
+      /* Every frame is rendered on the render thread, so this thread only waits for messages */
+      if(GetMessage(&msg, NULL, 0, 0) > 0)
+      {
+        handleMessage(&msg, hAccelTable, renderLoop);
+      }
     }
     else
     {
@@ -73,24 +116,65 @@ int APIENTRY _tWinMain(_In_ HINSTANCE hInstance,
          and therefore prevents a large batch of messages from delaying renders. */
       if( justRendered && PeekMessage( &msg, NULL, 0, 0, PM_REMOVE ) )
       {
-	  	  if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
-	  	  {
-	  		  TranslateMessage(&msg);
-	  		  DispatchMessage(&msg);
-	  	  }
+        handleMessage(&msg, hAccelTable, renderLoop);
         justRendered = false;
       }
       else
       {
-        windowManager->render();
+        renderLoop->renderFrame();
         justRendered = true;
       }
     }
   }
 
+  renderLoop->stop();
+  renderLoop->report();
+  delete renderLoop;
+
+  /* Leaves fullscreen and saves what this session measured */
+  delete windowManager;
+  windowManager = nullptr;
+  delete displayProfile;
+  Config::stopWatching();
+
 	return (int) msg.wParam;
 }
 
+/**
+ * Writes how long each phase of startup took, and how well the font parsing overlapped it.
+ */
+void reportStartup(StartupProfile* startupProfile, FontLoader* fontLoader)
+{
+  wchar_t text[128];
+  _snwprintf_s(text, 128, _TRUNCATE, L"Startup: %.1fms to the first frame (", startupProfile->getTotalSeconds() * 1000.0);
+  std::wstring report = text;
+  for(int phase = 0; phase < startupProfile->getPhaseCount(); ++phase)
+  {
+    _snwprintf_s(text, 128, _TRUNCATE, L"%s%s %.1fms", phase == 0 ? L"" : L", ",
+      startupProfile->getPhaseName(phase), startupProfile->getPhaseSeconds(phase) * 1000.0);
+    report += text;
+  }
+  _snwprintf_s(text, 128, _TRUNCATE, L")\nStartup: fonts parsed in %.1fms on worker threads, %.1fms spent waiting for them\n",
+    fontLoader->getParseSeconds() * 1000.0, fontLoader->getWaitSeconds() * 1000.0);
+  report += text;
+  OutputDebugString(report.c_str());
+}
+
+/**
+ * Handles one message, and records how long it took. When rendering between messages,
+ * this is how long the next frame was held up.
+ */
+void handleMessage(MSG* msg, HACCEL hAccelTable, RenderLoop* renderLoop)
+{
+  uint64_t start = Clock::getSystemClock()->getCount();
+  if (!TranslateAccelerator(msg->hwnd, hAccelTable, msg))
+  {
+    TranslateMessage(msg);
+    DispatchMessage(msg);
+  }
+  renderLoop->recordMessage(Clock::getSystemClock()->getCount() - start);
+}
+
 //
 //  FUNCTION: MyRegisterClass()
 //
@@ -0,0 +1,126 @@
+#include "NullRenderBackend.h"
+#include <string.h>
+#include <algorithm>
+
+/* The states that SpriteBatch::Begin sets: blend, depth stencil, rasterizer, sampler, topology,
+   input layout, vertex and pixel shaders, vertex and index buffers, and the transform's constant buffer */
+#define SPRITE_PIPELINE_STATES 11
+/* The states that applying BasicEffect and beginning PrimitiveBatch set: vertex and pixel shaders,
+   their constant buffer, input layout, vertex buffer and topology */
+#define TRIANGLE_PIPELINE_STATES 6
+/* SpriteBatch wraps to the start of its vertex buffer rather than draw fewer sprites than this at its end */
+#define MIN_SPRITE_BATCH 128
+#define VERTICES_PER_SPRITE 4
+
+NullRenderBackend::NullRenderBackend(void)
+  :mPipeline(PIPELINE_NONE),
+  mSpritePosition(0),
+  mTrianglePosition(0),
+  mSpriteVertices(SPRITE_BUFFER_SIZE * VERTICES_PER_SPRITE)
+{
+  resetCounters();
+}
+
+NullRenderBackend::~NullRenderBackend(void)
+{
+}
+
+void NullRenderBackend::beginFrame(const float clearColour[4])
+{
+  /* The render target and the viewport */
+  mCounters.stateChanges += 2;
+  clear(clearColour);
+}
+
+void NullRenderBackend::clear(const float /*colour*/[4])
+{
+  mCounters.clears++;
+}
+
+void NullRenderBackend::drawSprites(TextureHandle /*texture*/, size_t spriteCount, const SpriteWriter& writeVertices)
+{
+  if(spriteCount == 0)
+  {
+    return;
+  }
+
+  /* SpriteBatch::DrawVertices binds the texture on every call */
+  bindPipeline(PIPELINE_SPRITES);
+  mCounters.stateChanges++;
+
+  size_t firstSprite = 0;
+  while(firstSprite < spriteCount)
+  {
+    /* SpriteBatch takes what is left of its buffer, unless that is too little to be worth a draw */
+    size_t batchSize = spriteCount - firstSprite;
+    size_t remainingSpace = SPRITE_BUFFER_SIZE - mSpritePosition;
+    if(batchSize > remainingSpace && remainingSpace >= MIN_SPRITE_BATCH)
+    {
+      batchSize = remainingSpace;
+    }
+    batchSize = std::min(batchSize, SPRITE_BUFFER_SIZE);
+
+    size_t position = mapRing(&mSpritePosition, SPRITE_BUFFER_SIZE, batchSize, sizeof(SpriteVertex) * VERTICES_PER_SPRITE);
+    writeVertices(&mSpriteVertices[position * VERTICES_PER_SPRITE], firstSprite, batchSize);
+    mCounters.drawCalls++;
+
+    firstSprite += batchSize;
+  }
+}
+
+void NullRenderBackend::drawTriangles(const ColorVertex* /*vertices*/, size_t triangleCount)
+{
+  if(triangleCount == 0)
+  {
+    return;
+  }
+
+  bindPipeline(PIPELINE_TRIANGLES);
+  mapRing(&mTrianglePosition, TRIANGLE_BUFFER_VERTICES, triangleCount * 3, sizeof(ColorVertex));
+  mCounters.drawCalls++;
+}
+
+void NullRenderBackend::present()
+{
+  mCounters.presents++;
+  /* A frame's batches end with it, so the next frame binds its pipeline again */
+  mPipeline = PIPELINE_NONE;
+}
+
+const NullRenderBackend::Counters& NullRenderBackend::getCounters() const
+{
+  return mCounters;
+}
+
+void NullRenderBackend::resetCounters()
+{
+  memset(&mCounters, 0, sizeof(mCounters));
+}
+
+void NullRenderBackend::bindPipeline(Pipeline pipeline)
+{
+  if(pipeline == mPipeline)
+  {
+    return;
+  }
+  mPipeline = pipeline;
+  mCounters.stateChanges += (pipeline == PIPELINE_SPRITES) ? SPRITE_PIPELINE_STATES : TRIANGLE_PIPELINE_STATES;
+}
+
+size_t NullRenderBackend::mapRing(size_t* position, size_t capacity, size_t count, size_t elementSize)
+{
+  if(*position + count > capacity)
+  {
+    *position = 0;
+  }
+  if(*position == 0)
+  {
+    mCounters.allocations++;
+  }
+  mCounters.maps++;
+  mCounters.bytesMapped += count * elementSize;
+
+  size_t result = *position;
+  *position += count;
+  return result;
+}
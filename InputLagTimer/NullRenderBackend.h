@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "RenderBackend.h"
+
+/**
+ * A backend that draws nothing, and instead counts the work that D3D11RenderBackend would have given
+ * the device for the same frames. Sprite vertices are still written, into memory that stands in for
+ * the mapped vertex buffer, so the CPU cost of a frame is measured as it is with a device.
+ *
+ * The counts follow how SpriteBatch and PrimitiveBatch use their buffers: sprites go into a ring of
+ * SPRITE_BUFFER_SIZE sprites, and a map that wraps back to the start of a ring discards it, which
+ * the driver serves by allocating another buffer.
+ */
+class NullRenderBackend : public RenderBackend
+{
+public:
+  struct Counters
+  {
+    /** Render target, viewport, pipeline state, shader, buffer and texture bindings */
+    uint64_t stateChanges;
+    uint64_t drawCalls;
+    uint64_t clears;
+    uint64_t maps;
+    /** Vertex data written to mapped buffers */
+    uint64_t bytesMapped;
+    /** Buffers that the driver would allocate: one for every map that discards a ring's contents */
+    uint64_t allocations;
+    uint64_t presents;
+  };
+
+  /** SpriteBatch's MaxBatchSize */
+  static const size_t SPRITE_BUFFER_SIZE = 2048;
+  /** PrimitiveBatch's default number of vertices */
+  static const size_t TRIANGLE_BUFFER_VERTICES = 2048;
+
+  NullRenderBackend(void);
+  virtual ~NullRenderBackend(void);
+
+  virtual void beginFrame(const float clearColour[4]);
+  virtual void clear(const float colour[4]);
+  virtual void drawSprites(TextureHandle texture, size_t spriteCount, const SpriteWriter& writeVertices);
+  virtual void drawTriangles(const ColorVertex* vertices, size_t triangleCount);
+  virtual void present();
+
+  /** @return everything counted since construction or the last resetCounters() */
+  const Counters& getCounters() const;
+  void resetCounters();
+
+protected:
+  enum Pipeline
+  {
+    PIPELINE_NONE,
+    PIPELINE_SPRITES,
+    PIPELINE_TRIANGLES
+  };
+
+  /** Counts the states that binding the pipeline sets, if it is not already bound */
+  void bindPipeline(Pipeline pipeline);
+
+  /**
+   * Counts a map of count elements from a ring of capacity elements, wrapping and discarding the ring
+   * if they do not fit in what is left of it.
+   * @return the position in the ring that the elements go.
+   */
+  size_t mapRing(size_t* position, size_t capacity, size_t count, size_t elementSize);
+
+  Counters mCounters;
+  Pipeline mPipeline;
+  size_t mSpritePosition;
+  size_t mTrianglePosition;
+  /** Stands in for the mapped sprite vertex buffer */
+  std::vector<SpriteVertex> mSpriteVertices;
+
+private:
+  NullRenderBackend(const NullRenderBackend&);
+  NullRenderBackend& operator=(const NullRenderBackend&);
+};
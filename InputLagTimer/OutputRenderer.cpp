@@ -0,0 +1,334 @@
+#include "OutputRenderer.h"
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+#include "AllocationTracker.h"
+#include "Config.h"
+#include "TraceZones.h"
+
+#if defined(_MSC_VER)
+#pragma warning(disable : 4996)
+#endif
+
+#define TIMER_VALUE_PADDING 10
+#define COLUMN_SEPARATOR_WIDTH 15
+#define HUD_BUFFER_LENGTH 300
+/* Longer than any error message, so that showing an error never allocates */
+#define ERROR_BUFFER_LENGTH 64
+
+OutputRenderer::OutputRenderer(RenderBackend* backend, const std::vector<TimerTextRenderer*>& timerTexts, const FontFace* normalFont)
+  :mBackend(backend),
+  mTimerTexts(timerTexts),
+  mNormalFont(normalFont),
+  mLayoutWidth(0),
+  mLayoutHeight(0),
+  mLayoutColumns(0),
+  mHUDGeneration(0),
+  mHUDLongestFrameTime(0.0),
+  mHUDHighestRenderVariance(0.0),
+  mErrorTextError(Model::ERROR_TYPE_NONE)
+{
+  memset(&mHUDOutput, 0, sizeof(mHUDOutput));
+  memset(mHUDQuad, 0, sizeof(mHUDQuad));
+
+  /* A glyph is never more than a character, so laying out the HUD and error screen never allocates after this */
+  mHUDText.reserve(HUD_BUFFER_LENGTH);
+  mErrorText.reserve(ERROR_BUFFER_LENGTH);
+}
+
+OutputRenderer::~OutputRenderer(void)
+{
+}
+
+void OutputRenderer::renderFrame(Model* model, const Output& output)
+{
+  TRACE_ZONE("OutputRenderer::renderFrame");
+  beginFrame();
+  {
+    AllocationTracker::Scope scope(AllocationTracker::SUBSYSTEM_MODEL);
+    model->update();
+  }
+  drawModel(model, output);
+  endFrame(model);
+}
+
+void OutputRenderer::renderFrame(Model* model, const Output& output, uint64_t sharedCount)
+{
+  TRACE_ZONE("OutputRenderer::renderFrame");
+  beginFrame();
+  {
+    AllocationTracker::Scope scope(AllocationTracker::SUBSYSTEM_MODEL);
+    model->update(sharedCount);
+  }
+  drawModel(model, output);
+  endFrame(model);
+}
+
+void OutputRenderer::beginFrame()
+{
+  AllocationTracker::Scope scope(AllocationTracker::SUBSYSTEM_PRESENT);
+  mBackend->beginFrame(Config::backgroundColour);
+}
+
+void OutputRenderer::endFrame(Model* model)
+{
+  {
+    AllocationTracker::Scope scope(AllocationTracker::SUBSYSTEM_PRESENT);
+    mBackend->present();
+  }
+  AllocationTracker::Scope scope(AllocationTracker::SUBSYSTEM_MODEL);
+  model->renderComplete();
+}
+
+void OutputRenderer::drawModel(Model* model, const Output& output)
+{
+  TRACE_ZONE("OutputRenderer::drawModel");
+  AllocationTracker::Scope scope(AllocationTracker::SUBSYSTEM_DRAWING);
+
+  /* Generate strings */
+  Model::TimerValue timerValue = model->getTimerValue();
+  assert(timerValue.high < 1000 && timerValue.low < 100); /* Current design of display expects to always have less than a second */
+  wchar_t timerString[7];
+  swprintf(timerString, 7, L"%03u.%02u", timerValue.high, timerValue.low);
+
+  if(mLayoutWidth != output.layoutWidth || mLayoutHeight != output.layoutHeight || mLayoutColumns != Config::numColumns)
+  {
+    layoutColumns(output);
+  }
+
+  int column = model->getColumn();
+  for(auto iter = mTimerColumns.begin(); iter != mTimerColumns.end(); ++iter)
+  {
+    drawColumn(*iter, timerString, column);
+  }
+
+  drawHUD(*model->getSession(), output);
+
+  /* Render error if there is one */
+  Model::ErrorType currentError = model->getCurrentError();
+  if(Model::ERROR_TYPE_NONE != currentError)
+  {
+    drawError(currentError);
+  }
+}
+
+void OutputRenderer::layoutColumns(const Output& output)
+{
+  TRACE_ZONE("OutputRenderer::layoutColumns");
+  mTimerColumns.clear();
+  auto textIter = mTimerTexts.begin();
+  int x = TIMER_VALUE_PADDING;
+  while(static_cast<unsigned int>(x) < output.layoutWidth && textIter != mTimerTexts.end())
+  {
+    TimerColumn timerColumn;
+    x = layoutColumn(x, output.layoutHeight, *textIter, &timerColumn);
+    mTimerColumns.push_back(timerColumn);
+
+    ++textIter;
+  }
+
+  mLayoutWidth = output.layoutWidth;
+  mLayoutHeight = output.layoutHeight;
+  mLayoutColumns = Config::numColumns;
+}
+
+int OutputRenderer::layoutColumn(int x, unsigned int layoutHeight, TimerTextRenderer* text, TimerColumn* outColumn, bool drawHeader)
+{
+  unsigned int y = TIMER_VALUE_PADDING;
+  float width, height;
+  text->getFont()->measureString(L"888.88", &width, &height);
+  int textWidth = static_cast<int>(ceilf(width));
+  int lineHeight = static_cast<int>(ceilf(height));
+
+  outColumn->text = text;
+  outColumn->drawHeader = drawHeader;
+
+  /* Leave room for the header */
+  if(drawHeader)
+  {
+    outColumn->headerPosition.x = static_cast<float>(x);
+    outColumn->headerPosition.y = static_cast<float>(y);
+    y += lineHeight + TIMER_VALUE_PADDING;
+  }
+
+  /* Timer value rows, for each column that the model can select */
+  outColumn->rowPositions.resize(Config::numColumns);
+  for(int column = 0; column < Config::numColumns; ++column)
+  {
+    int textX = x + (textWidth * column);
+    for(unsigned int rowY = y; rowY < layoutHeight; rowY += lineHeight + TIMER_VALUE_PADDING)
+    {
+      TimerTextRenderer::Position position = { static_cast<float>(textX), static_cast<float>(rowY) };
+      outColumn->rowPositions[column].push_back(position);
+    }
+  }
+
+  /* Column Separator */
+  int separatorX = x + (textWidth * Config::numColumns) + COLUMN_SEPARATOR_WIDTH;
+
+  return separatorX;
+}
+
+void OutputRenderer::drawColumn(const TimerColumn& timerColumn, const wchar_t* timerString, int column)
+{
+  TRACE_ZONE("OutputRenderer::drawColumn");
+  const FontFace* font = timerColumn.text->getFont();
+
+  /* Draw header */
+  if(timerColumn.drawHeader)
+  {
+    font->drawString(mBackend, L"12345.67890", timerColumn.headerPosition.x, timerColumn.headerPosition.y, Config::fontColour);
+  }
+
+  /* Draw Timer Values */
+  const std::vector<TimerTextRenderer::Position>& rows = timerColumn.rowPositions[column];
+  if(!timerColumn.text->draw(mBackend, timerString, rows.data(), rows.size(), Config::fontColour))
+  {
+    for(auto iter = rows.begin(); iter != rows.end(); ++iter)
+    {
+      font->drawString(mBackend, timerString, iter->x, iter->y, Config::fontColour);
+    }
+  }
+}
+
+void OutputRenderer::drawHUD(const TimingSession& session, const Output& output)
+{
+  TRACE_ZONE("OutputRenderer::drawHUD");
+  if(mHUDGeneration != session.getHUDGeneration() ||
+     mHUDLongestFrameTime != Config::longestFrameTime ||
+     mHUDHighestRenderVariance != Config::highestRenderVariance ||
+     !isSameHUDOutput(mHUDOutput, output))
+  {
+    layoutHUD(session, output);
+  }
+
+  mBackend->drawTriangles(mHUDQuad, 2);
+  mHUDText.draw(mBackend);
+}
+
+bool OutputRenderer::isSameHUDOutput(const Output& output, const Output& otherOutput)
+{
+  return output.number == otherOutput.number &&
+    output.count == otherOutput.count &&
+    output.width == otherOutput.width &&
+    output.height == otherOutput.height &&
+    output.refreshNumerator == otherOutput.refreshNumerator &&
+    output.refreshDenominator == otherOutput.refreshDenominator;
+}
+
+void OutputRenderer::layoutHUD(const TimingSession& session, const Output& output)
+{
+  TRACE_ZONE("OutputRenderer::layoutHUD");
+  wchar_t buffer[HUD_BUFFER_LENGTH];
+  /*
+  output1/2
+  1920x1080
+  59.97Hz
+
+  542FPS
+
+  frame
+  time(max)
+  5.23ms
+  p99(10s)
+  4.80ms
+  error at
+  10.0ms
+
+  render
+  variance
+  2.45ms
+  p99(10s)
+  1.20ms
+  error at
+  2.0ms
+
+  allocating
+  frames
+  0
+
+  inputlag
+  .allenwp
+  .com
+
+  FUTURE:
+  time drift
+  0.00045ms/1ms
+  shortest
+  frame time
+  +/-0.01ms
+  */
+  swprintf(buffer, HUD_BUFFER_LENGTH, L"output%d/%d\n%ux%u\n%.2fHz\n\n%dFPS\n\nframe\ntime(max)\n%.2fms\np99(%ds)\n%.2fms\nerror at\n%.1fms\n\nrender\nvariance\n%.2fms\np99(%ds)\n%.2fms\nerror at\n%.1fms\n\nallocating\nframes\n%llu\n\nv0.8.1\n\ninputlag\n.allenwp\n.com",
+    output.number, output.count, output.width, output.height, static_cast<float>(output.refreshNumerator / output.refreshDenominator),
+    session.getFPS(),
+    static_cast<float>(session.getFrameTime() * 1000.0f),
+    TimingSession::HISTOGRAM_WINDOW_SECONDS, static_cast<float>(session.getFrameTimePercentiles().p99 * 1000.0f),
+    static_cast<float>(Config::longestFrameTime * 1000.0f),
+    static_cast<float>(session.getRenderVariance() * 1000.0f),
+    TimingSession::HISTOGRAM_WINDOW_SECONDS, static_cast<float>(session.getRenderVariancePercentiles().p99 * 1000.0f),
+    static_cast<float>(Config::highestRenderVariance * 1000.0f),
+    static_cast<unsigned long long>(AllocationTracker::getAllocatingFrameCount()));
+  float textWidth, textHeight;
+  mNormalFont->measureString(buffer, &textWidth, &textHeight);
+
+  /* A black quad behind the text, as PrimitiveBatch::DrawQuad draws it */
+  float left = output.width - textWidth;
+  float right = static_cast<float>(output.width);
+  float top = 0.0f;
+  float bottom = textHeight;
+  RenderBackend::ColorVertex quad[6] =
+  {
+    { left, top, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+    { right, top, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+    { right, bottom, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+    { left, top, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+    { right, bottom, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+    { left, bottom, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+  };
+  memcpy(mHUDQuad, quad, sizeof(mHUDQuad));
+
+  static const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+  mHUDText.clear();
+  mHUDText.addString(mNormalFont, buffer, left, top, white);
+
+  mHUDOutput = output;
+  mHUDGeneration = session.getHUDGeneration();
+  mHUDLongestFrameTime = Config::longestFrameTime;
+  mHUDHighestRenderVariance = Config::highestRenderVariance;
+}
+
+void OutputRenderer::drawError(Model::ErrorType error)
+{
+  TRACE_ZONE("OutputRenderer::drawError");
+  static const float red[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+  mBackend->clear(red);
+
+  if(error != mErrorTextError)
+  {
+    layoutError(error);
+  }
+  mErrorText.draw(mBackend);
+}
+
+void OutputRenderer::layoutError(Model::ErrorType error)
+{
+  const wchar_t* errorMessage = L"";
+  switch(error)
+  {
+  case Model::ERROR_TYPE_NONE:
+    break;
+  case Model::ERROR_TYPE_RENDER_TIME_VARIANCE_TOO_HIGH:
+    errorMessage = L"Render time variance too high.\nWaiting for stability...";
+    break;
+  case Model::ERROR_TYPE_FRAME_TIME_TOO_LONG:
+    errorMessage = L"Timer frame time too long.\nWaiting for stability...";
+    break;
+  }
+
+  static const float white[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+  mErrorText.clear();
+  mErrorText.addString(mNormalFont, errorMessage, 10.0f, 10.0f, white);
+  mErrorTextError = error;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "FontFace.h"
+#include "RenderBackend.h"
+#include "RetainedSprites.h"
+#include "TimerTextRenderer.h"
+#include "TimingSession.h"
+
+/**
+ * Renders an output's frames through a RenderBackend: the columns of timer values, the HUD,
+ * and the error screen when the model has an error. This is everything a Window does in a
+ * frame apart from talking to its swap chain, so the frame loop can be driven, and measured,
+ * with any backend.
+ */
+class OutputRenderer
+{
+public:
+  /**
+   * What the HUD shows about the output, and the size that the timer columns are laid out for.
+   */
+  struct Output
+  {
+    /** From 1 to count */
+    int number;
+    int count;
+    unsigned int width;
+    unsigned int height;
+    unsigned int refreshNumerator;
+    unsigned int refreshDenominator;
+    /** The widest and tallest of every output, so that the rows line up across outputs */
+    unsigned int layoutWidth;
+    unsigned int layoutHeight;
+  };
+
+  /**
+   * @param backend draws the frames. Not owned.
+   * @param timerTexts a renderer for each timer font, in the order that their columns are laid out. Not owned.
+   * @param normalFont the HUD and error font. Not owned.
+   */
+  OutputRenderer(RenderBackend* backend, const std::vector<TimerTextRenderer*>& timerTexts, const FontFace* normalFont);
+  virtual ~OutputRenderer(void);
+
+  /**
+   * Renders and presents a frame: begins it, updates the model, draws it and presents it,
+   * then tells the model that rendering is complete.
+   */
+  void renderFrame(Model* model, const Output& output);
+
+  /**
+   * Renders and presents a frame using a counter value that was sampled once for all outputs.
+   */
+  void renderFrame(Model* model, const Output& output, uint64_t sharedCount);
+
+protected:
+  /**
+   * A font's block of timer values. Everything but the timer string is the same every frame,
+   * so the positions of every row are worked out once for each column the model can select.
+   */
+  struct TimerColumn
+  {
+    TimerTextRenderer* text;
+    bool drawHeader;
+    TimerTextRenderer::Position headerPosition;
+    std::vector<std::vector<TimerTextRenderer::Position>> rowPositions;
+  };
+
+  /** Begins the frame on the backend, and presents it and tells the model that rendering is complete */
+  void beginFrame();
+  void endFrame(Model* model);
+
+  void drawModel(Model* model, const Output& output);
+
+  /**
+   * Lays out a TimerColumn for each font that fits across the widest output.
+   * Called again if another output raises the max width or height, or the number of columns is reloaded.
+   */
+  void layoutColumns(const Output& output);
+
+  /**
+   * @return the new x coordinate of the right of the column that was laid out
+   * @param drawHeader will draw "12345.67890" as reference digits at the top of the column.
+   * The header was an old feature that was designed to help reability, but after the discovery
+   * of varaible latancy displays, it was decided that the header would take away from otherwise
+   * important values at the top of the column.
+   */
+  int layoutColumn(int x, unsigned int layoutHeight, TimerTextRenderer* text, TimerColumn* outColumn, bool drawHeader = false);
+
+  void drawColumn(const TimerColumn& timerColumn, const wchar_t* timerString, int column);
+
+  /**
+   * The HUD's values change at most once a second, so its text and the quad behind it are kept
+   * between frames, and only laid out again by layoutHUD() when something that it shows changes.
+   * The count of frames that allocated is not one of those, so it is as of the last second.
+   */
+  void drawHUD(const TimingSession& session, const Output& output);
+
+  void layoutHUD(const TimingSession& session, const Output& output);
+
+  /** The error screen is kept between frames in the same way as the HUD, until the error changes */
+  void drawError(Model::ErrorType error);
+
+  void layoutError(Model::ErrorType error);
+
+  /** @return true if the HUD of one output would show the same as the HUD of the other */
+  static bool isSameHUDOutput(const Output& output, const Output& otherOutput);
+
+  RenderBackend* mBackend;
+  std::vector<TimerTextRenderer*> mTimerTexts;
+  const FontFace* mNormalFont;
+
+  std::vector<TimerColumn> mTimerColumns;
+  unsigned int mLayoutWidth;
+  unsigned int mLayoutHeight;
+  /** Config::numColumns when the columns were laid out, which a config reload can change */
+  int mLayoutColumns;
+
+  RetainedSprites mHUDText;
+  RenderBackend::ColorVertex mHUDQuad[6];
+  /** What the HUD was laid out with. mHUDOutput.count is 0 until it has been laid out. */
+  Output mHUDOutput;
+  uint32_t mHUDGeneration;
+  double mHUDLongestFrameTime;
+  double mHUDHighestRenderVariance;
+
+  RetainedSprites mErrorText;
+  /** The error that mErrorText was laid out for */
+  Model::ErrorType mErrorTextError;
+
+private:
+  OutputRenderer(const OutputRenderer&);
+  OutputRenderer& operator=(const OutputRenderer&);
+};
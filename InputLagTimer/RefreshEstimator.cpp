@@ -0,0 +1,175 @@
+#include "RefreshEstimator.h"
+#include <math.h>
+
+/* The smallest fraction of each error that moves the phase */
+#define PHASE_GAIN 0.1
+/* The smallest fraction of each error, per refresh since the last observation, that moves the period.
+   A quarter of the phase gain squared critically damps the loop. */
+#define PERIOD_GAIN (PHASE_GAIN * PHASE_GAIN / 4.0)
+/* Errors larger than this fraction of the period are glitches, not drift */
+#define OUTLIER_TOLERANCE 0.25
+/* This many glitches in a row starts the estimate again from them */
+#define RESYNC_OUTLIERS 4
+/* Locked once this many errors in a row are within LOCK_TOLERANCE of the period */
+#define LOCK_OBSERVATIONS 8
+#define LOCK_TOLERANCE 0.05
+/* By this many observations, both gains have fallen to their floors */
+#define MAX_FIT_LENGTH 64
+
+RefreshEstimator::RefreshEstimator(double nominalPeriod)
+{
+  reset(nominalPeriod);
+}
+
+void RefreshEstimator::reset(double nominalPeriod)
+{
+  mPeriod = nominalPeriod;
+  mReferenceCount = 0;
+  mReferenceOffset = 0.0;
+  mReferenceRefresh = 0;
+  mLastRefreshCount = 0;
+  mLastError = 0.0;
+  mFitLength = 1;
+  mSettledCount = 0;
+  mOutliersInRow = 0;
+  mLocked = false;
+  mObservationCount = 0;
+  mRejectedCount = 0;
+  mResyncCount = 0;
+  mFirstOutlierRefreshCount = 0;
+  mFirstOutlierCount = 0;
+}
+
+void RefreshEstimator::resync(uint32_t refreshCount, uint64_t count)
+{
+  /* The refresh numbers carry on from before, so that the columns they pick do not jump */
+  mReferenceRefresh += static_cast<uint32_t>(refreshCount - mLastRefreshCount);
+  mReferenceCount = count;
+  mReferenceOffset = 0.0;
+  mLastRefreshCount = refreshCount;
+  mFitLength = 1;
+  mSettledCount = 0;
+  mOutliersInRow = 0;
+  mLocked = false;
+}
+
+void RefreshEstimator::observe(uint32_t refreshCount, uint64_t count)
+{
+  if(mObservationCount == 0)
+  {
+    mReferenceRefresh = refreshCount;
+    mReferenceCount = count;
+    mLastRefreshCount = refreshCount;
+    ++mObservationCount;
+    return;
+  }
+
+  /* Unsigned subtraction, so a refresh count that wrapped around still gives the refreshes between */
+  uint32_t refreshes = refreshCount - mLastRefreshCount;
+  if(refreshes == 0)
+  {
+    return;
+  }
+  ++mObservationCount;
+
+  double elapsed = static_cast<double>(static_cast<int64_t>(count - mReferenceCount)) - mReferenceOffset;
+  double error = elapsed - refreshes * mPeriod;
+  if(fabs(error) > mPeriod * OUTLIER_TOLERANCE)
+  {
+    ++mRejectedCount;
+    if(mOutliersInRow == 0)
+    {
+      mFirstOutlierRefreshCount = refreshCount;
+      mFirstOutlierCount = count;
+    }
+    if(++mOutliersInRow >= RESYNC_OUTLIERS)
+    {
+      /* The outliers agree with each other, so measure the new period from the first to the last of them */
+      uint32_t outlierRefreshes = refreshCount - mFirstOutlierRefreshCount;
+      int64_t outlierCounts = static_cast<int64_t>(count - mFirstOutlierCount);
+      if(outlierRefreshes > 0 && outlierRefreshes < 0x80000000u && outlierCounts > 0)
+      {
+        mPeriod = static_cast<double>(outlierCounts) / outlierRefreshes;
+      }
+      resync(refreshCount, count);
+      ++mResyncCount;
+    }
+    return;
+  }
+  mOutliersInRow = 0;
+
+  /* Until the gains fall to their floors, they are the ones that make the estimate a least squares
+     fit of a line through every observation so far, which settles far faster than fixed gains would */
+  if(mFitLength < MAX_FIT_LENGTH)
+  {
+    ++mFitLength;
+  }
+  double fitSquare = static_cast<double>(mFitLength) * (mFitLength + 1);
+  double phaseGain = 2.0 * (2 * mFitLength - 1) / fitSquare;
+  if(phaseGain < PHASE_GAIN)
+  {
+    phaseGain = PHASE_GAIN;
+  }
+  double periodGain = 6.0 / fitSquare;
+  if(periodGain < PERIOD_GAIN)
+  {
+    periodGain = PERIOD_GAIN;
+  }
+
+  /* The vblank is placed a fraction of the error away from the prediction. Only the offset
+     is a double, and it is never larger than the error, so precision does not run down. */
+  mReferenceCount = count;
+  mReferenceOffset = -(1.0 - phaseGain) * error;
+  mReferenceRefresh += refreshes;
+  mLastRefreshCount = refreshCount;
+  mPeriod += periodGain * error / refreshes;
+  mLastError = error;
+
+  if(fabs(error) < mPeriod * LOCK_TOLERANCE)
+  {
+    if(++mSettledCount >= LOCK_OBSERVATIONS)
+    {
+      mLocked = true;
+    }
+  }
+  else
+  {
+    mSettledCount = 0;
+  }
+}
+
+bool RefreshEstimator::isLocked() const
+{
+  return mLocked;
+}
+
+double RefreshEstimator::getPeriod() const
+{
+  return mPeriod;
+}
+
+uint64_t RefreshEstimator::getRefreshStart(uint64_t refreshIndex) const
+{
+  double sinceReference = static_cast<double>(static_cast<int64_t>(refreshIndex - mReferenceRefresh)) * mPeriod + mReferenceOffset;
+  return mReferenceCount + static_cast<int64_t>(floor(sinceReference + 0.5));
+}
+
+double RefreshEstimator::getLastError() const
+{
+  return mLastError;
+}
+
+uint64_t RefreshEstimator::getObservationCount() const
+{
+  return mObservationCount;
+}
+
+uint64_t RefreshEstimator::getRejectedCount() const
+{
+  return mRejectedCount;
+}
+
+int RefreshEstimator::getResyncCount() const
+{
+  return mResyncCount;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Tracks an output's true refresh period and the phase of its vblanks from observed
+ * (refresh number, counter value) pairs, such as the SyncRefreshCount and SyncQPCTime
+ * that DXGI's frame statistics give.
+ *
+ * The estimate is a second order phase-locked loop: each observation's error against
+ * the predicted vblank moves the phase by a fraction of it, and the period by a smaller
+ * fraction spread over the refreshes since the last observation. The fractions start
+ * large and shrink to fixed floors, so the loop locks quickly and then filters out jitter.
+ * Observing and looking up a refresh are both O(1), and neither allocates.
+ *
+ * Observations far from the prediction are treated as glitches and ignored. If several
+ * come in a row the output has most likely changed mode, so the estimate starts again
+ * from them.
+ */
+class RefreshEstimator
+{
+public:
+  /**
+   * @param nominalPeriod the period, in counter ticks, that the estimate starts from.
+   */
+  explicit RefreshEstimator(double nominalPeriod);
+
+  /**
+   * Starts the estimate again from a new period, forgetting the phase.
+   */
+  void reset(double nominalPeriod);
+
+  /**
+   * Adds an observed vblank. Observations must be in order. One of the same refresh as the
+   * last is ignored, which is what the frame statistics give when no vblank has passed.
+   * @param refreshCount the number of the refresh, which may wrap around past 2^32.
+   * @param count the counter value at which that refresh started. May wrap around past 2^64.
+   */
+  void observe(uint32_t refreshCount, uint64_t count);
+
+  /**
+   * @return true once enough observations in a row have landed close to their predictions
+   * for getRefreshIndex() to be trusted. Cleared when the estimate starts again.
+   */
+  bool isLocked() const;
+
+  /**
+   * @return the estimated period in counter ticks.
+   */
+  double getPeriod() const;
+
+  /**
+   * @return the number of the refresh that had started by count, counted on from the first
+   * observation's refreshCount without wrapping around. Only meaningful once there has been an observation.
+   */
+  uint64_t getRefreshIndex(uint64_t count) const
+  {
+    double sinceReference = static_cast<double>(static_cast<int64_t>(count - mReferenceCount)) - mReferenceOffset;
+    double refreshes = sinceReference / mPeriod;
+    int64_t whole = static_cast<int64_t>(refreshes);
+    if(refreshes < whole)
+    {
+      --whole; /* Rounded towards zero, but the refresh before a vblank is the one below */
+    }
+    return mReferenceRefresh + whole;
+  }
+
+  /**
+   * @return the counter value at which refreshIndex is predicted to start, from the same numbering as getRefreshIndex().
+   */
+  uint64_t getRefreshStart(uint64_t refreshIndex) const;
+
+  /**
+   * @return the error of the last accepted observation against its prediction, in counter ticks.
+   */
+  double getLastError() const;
+
+  uint64_t getObservationCount() const;
+
+  /**
+   * @return the observations ignored for being too far from their prediction.
+   */
+  uint64_t getRejectedCount() const;
+
+  /**
+   * @return how many times the estimate has started again from observations it had been rejecting.
+   */
+  int getResyncCount() const;
+
+protected:
+  /**
+   * Starts the phase from an observation, keeping the period.
+   */
+  void resync(uint32_t refreshCount, uint64_t count);
+
+  double mPeriod;
+  /** The predicted vblank of mReferenceRefresh is mReferenceOffset ticks from mReferenceCount.
+      Held as a count and a small offset, so that the phase keeps full precision however long it runs. */
+  uint64_t mReferenceCount;
+  double mReferenceOffset;
+  uint64_t mReferenceRefresh;
+  uint32_t mLastRefreshCount;
+
+  double mLastError;
+  /** The observations the estimate has been fitted to since it last started. Stops counting once the gains reach their floors. */
+  int mFitLength;
+  /** Accepted observations in a row within the lock tolerance */
+  int mSettledCount;
+  int mOutliersInRow;
+  bool mLocked;
+
+  uint64_t mObservationCount;
+  uint64_t mRejectedCount;
+  int mResyncCount;
+
+  /** The first observation of the run of outliers, which the period is measured from if it resyncs */
+  uint32_t mFirstOutlierRefreshCount;
+  uint64_t mFirstOutlierCount;
+};
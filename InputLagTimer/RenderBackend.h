@@ -0,0 +1,72 @@
+#pragma once
+
+#include <stddef.h>
+#include <functional>
+
+/**
+ * What a window's frame is drawn through: a render target to clear, sprites from a font texture,
+ * solid triangles, and a present. Window draws through D3D11RenderBackend, and the frame loop can
+ * be driven without a GPU through NullRenderBackend, which only counts what a device would have done.
+ *
+ * Everything is drawn in pixels, with the origin at the top left of the target, and blended with
+ * premultiplied alpha, as SpriteBatch and PrimitiveBatch draw with their default states.
+ */
+class RenderBackend
+{
+public:
+  /** The layout of DirectX::VertexPositionColorTexture */
+  struct SpriteVertex
+  {
+    float x, y, z;
+    float r, g, b, a;
+    float u, v;
+  };
+
+  /** The layout of DirectX::VertexPositionColor */
+  struct ColorVertex
+  {
+    float x, y, z;
+    float r, g, b, a;
+  };
+
+  /**
+   * A texture, as the backend that draws it knows it: an ID3D11ShaderResourceView for D3D11RenderBackend.
+   * Textures are created with the device, not by the backend, so that every window on a device shares them.
+   */
+  typedef const void* TextureHandle;
+
+  /**
+   * Writes spriteCount sprites, starting with the sprite numbered firstSprite, 4 vertices each:
+   * top left, top right, bottom left, bottom right. Called as many times as the backend needs to
+   * split the sprites between its buffers, with vertices pointing at memory it has mapped.
+   */
+  typedef std::function<void(SpriteVertex* vertices, size_t firstSprite, size_t spriteCount)> SpriteWriter;
+
+  virtual ~RenderBackend(void) {}
+
+  /**
+   * Binds the output's render target and viewport and clears the target. Called before anything else in a frame.
+   * @param clearColour red, green, blue and alpha from 0 to 1.
+   */
+  virtual void beginFrame(const float clearColour[4]) = 0;
+
+  /**
+   * Clears the render target, including everything drawn to it earlier in the frame.
+   */
+  virtual void clear(const float colour[4]) = 0;
+
+  /**
+   * Draws sprites from the texture, with their vertices written straight into the backend's buffers.
+   */
+  virtual void drawSprites(TextureHandle texture, size_t spriteCount, const SpriteWriter& writeVertices) = 0;
+
+  /**
+   * Draws solid triangles, 3 vertices each.
+   */
+  virtual void drawTriangles(const ColorVertex* vertices, size_t triangleCount) = 0;
+
+  /**
+   * Ends the frame and shows it.
+   */
+  virtual void present() = 0;
+};
@@ -0,0 +1,152 @@
+#include "stdafx.h"
+#include "RenderLoop.h"
+#include "WindowManager.h"
+#include "Config.h"
+#include "TraceZones.h"
+#include <stdio.h>
+
+/* Short sleeps measured to set the frame pacer's spin margin before the first paced frame */
+#define PACER_CALIBRATION_SLEEPS 20
+
+RenderLoop::RenderLoop(WindowManager* windowManager, Clock* clock)
+  :mWindowManager(windowManager),
+  mClock(clock),
+  mStopping(false),
+  mUsedRenderThread(false),
+  mLastFrameEnd(0),
+  mNextFrameCount(0)
+{
+}
+
+RenderLoop::~RenderLoop(void)
+{
+  stop();
+}
+
+void RenderLoop::renderFrame()
+{
+  /* The gap is taken before pacing, so that it only holds the time lost to other work */
+  uint64_t frameStart = mClock->getCount();
+  if(mLastFrameEnd != 0)
+  {
+    mFrameGaps.record(frameStart - mLastFrameEnd);
+  }
+  pace(frameStart);
+  mWindowManager->render();
+  mLastFrameEnd = mClock->getCount();
+}
+
+void RenderLoop::start()
+{
+  mStopping = false;
+  mUsedRenderThread = true;
+  mRenderThread = std::thread(&RenderLoop::renderThreadMain, this);
+  /* Stay ahead of the thread handling messages, and of anything else on the desktop */
+  SetThreadPriority(mRenderThread.native_handle(), THREAD_PRIORITY_HIGHEST);
+}
+
+void RenderLoop::stop()
+{
+  if(!mRenderThread.joinable())
+  {
+    return;
+  }
+  mStopping = true;
+
+  /* Joining without handling messages could deadlock: DXGI sends messages to the windows
+     from Present and ResizeBuffers, and waits for them to be handled. */
+  HANDLE renderThread = mRenderThread.native_handle();
+  while(MsgWaitForMultipleObjects(1, &renderThread, FALSE, INFINITE, QS_ALLINPUT) == WAIT_OBJECT_0 + 1)
+  {
+    MSG msg;
+    while(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+    {
+      TranslateMessage(&msg);
+      DispatchMessage(&msg);
+    }
+  }
+  mRenderThread.join();
+}
+
+bool RenderLoop::isRunning() const
+{
+  return mRenderThread.joinable();
+}
+
+void RenderLoop::recordMessage(uint64_t handlingCounts)
+{
+  mMessageTimes.record(handlingCounts);
+}
+
+void RenderLoop::report() const
+{
+  double msPerCount = 1000.0 / mClock->getFrequency();
+  wchar_t report[256];
+  _snwprintf_s(report, 256, _TRUNCATE,
+    L"Render loop: %s, %llu frames, gap between frames p99 %.3fms max %.3fms\n"
+    L"Render loop: %llu messages handled, p99 %.3fms max %.3fms, %d render commands dropped\n",
+    mUsedRenderThread ? L"render thread" : L"between messages",
+    (unsigned long long)mFrameGaps.getTotalCount(),
+    mFrameGaps.getValueAtPercentile(99.0) * msPerCount, mFrameGaps.getMax() * msPerCount,
+    (unsigned long long)mMessageTimes.getTotalCount(),
+    mMessageTimes.getValueAtPercentile(99.0) * msPerCount, mMessageTimes.getMax() * msPerCount,
+    WindowManager::getDroppedCommandCount());
+  OutputDebugString(report);
+
+  if(mFramePacer)
+  {
+    Percentiles wakeErrors;
+    wakeErrors.fromNanoseconds(mFramePacer->getWakeErrors());
+    _snwprintf_s(report, 256, _TRUNCATE,
+      L"Frame pacer: %llu waits, woke late by p50 %.1fus p99 %.1fus max %.1fus, spin margin %.1fus, %.0f%% of waiting spent spinning\n",
+      (unsigned long long)mFramePacer->getWakeErrors().getTotalCount(),
+      wakeErrors.p50 * 1000000.0, wakeErrors.p99 * 1000000.0, wakeErrors.max * 1000000.0,
+      mFramePacer->getSpinMargin() * 1000000.0 / mClock->getFrequency(), mFramePacer->getSpinFraction() * 100.0);
+    OutputDebugString(report);
+  }
+}
+
+void RenderLoop::pace(uint64_t now)
+{
+  TRACE_ZONE("RenderLoop::pace");
+  uint64_t frameInterval = getFrameInterval();
+  mWindowManager->setPacingInterval(static_cast<double>(frameInterval) / mClock->getFrequency());
+  if(frameInterval == 0)
+  {
+    mNextFrameCount = 0;
+    return;
+  }
+
+  if(!mFramePacer)
+  {
+    mFramePacer.reset(new FramePacer(mClock));
+    mFramePacer->calibrate(PACER_CALIBRATION_SLEEPS);
+    now = mClock->getCount();
+  }
+
+  /* A frame that ran more than an interval over restarts the schedule, rather than being followed by a burst of frames to catch up */
+  if(mNextFrameCount == 0 || static_cast<int64_t>(now - mNextFrameCount) > static_cast<int64_t>(frameInterval))
+  {
+    mNextFrameCount = now;
+  }
+  mFramePacer->waitUntil(mNextFrameCount);
+  mNextFrameCount += frameInterval;
+}
+
+uint64_t RenderLoop::getFrameInterval() const
+{
+  if(Config::framesPerRefresh > 0)
+  {
+    return mWindowManager->getCountsPerRefresh() / Config::framesPerRefresh;
+  }
+  return mClock->getFrequency() * Config::frameIntervalUs / 1000000;
+}
+
+void RenderLoop::renderThreadMain()
+{
+  TraceZones::registerThread("render");
+  while(!mStopping)
+  {
+    renderFrame();
+  }
+}
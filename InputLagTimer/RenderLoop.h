@@ -0,0 +1,92 @@
+#pragma once
+#include "Clock.h"
+#include "FramePacer.h"
+#include "Histogram.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+class WindowManager;
+
+/**
+ * Drives WindowManager::render(), either one frame at a time between window messages on the
+ * thread that owns the windows, or continuously on its own elevated-priority render thread so
+ * that the time spent handling window messages never lands between two timed frames.
+ * Records the gaps between frames and the time spent handling each message, so that the two
+ * ways of running can be compared.
+ * Frames are paced by Config::framesPerRefresh or Config::frameIntervalUs when either is set.
+ */
+class RenderLoop
+{
+public:
+  RenderLoop(WindowManager* windowManager, Clock* clock);
+
+  /**
+   * Stops the render thread if it is still running.
+   */
+  virtual ~RenderLoop(void);
+
+  /**
+   * Renders one frame on the calling thread. Must not be called while the render thread is running.
+   */
+  void renderFrame();
+
+  /**
+   * Starts rendering every frame on a render thread with a raised priority.
+   * The calling thread should only handle window messages from then on.
+   */
+  void start();
+
+  /**
+   * Stops and joins the render thread. Window messages sent to this thread are handled while
+   * waiting, because Present and ResizeBuffers on the render thread can wait on the windows.
+   */
+  void stop();
+
+  bool isRunning() const;
+
+  /**
+   * Records how long the thread that owns the windows spent handling one message.
+   */
+  void recordMessage(uint64_t handlingCounts);
+
+  /**
+   * Writes the gaps between frames, the message handling times and how precisely frames were paced to the debug output.
+   */
+  void report() const;
+
+protected:
+  void renderThreadMain();
+
+  /**
+   * Waits until the next paced frame should start, if frames are being paced.
+   */
+  void pace(uint64_t now);
+
+  /**
+   * @return the counts between the starts of paced frames, or 0 if frames are not paced.
+   */
+  uint64_t getFrameInterval() const;
+
+  WindowManager* mWindowManager;
+  Clock* mClock;
+  std::thread mRenderThread;
+  std::atomic<bool> mStopping;
+  /** Whether frames were rendered on the render thread, for the report */
+  bool mUsedRenderThread;
+
+  /** The counts from the end of one frame to the start of the next. Only written by the rendering thread. */
+  Histogram mFrameGaps;
+  uint64_t mLastFrameEnd;
+  /** Only written by the thread that owns the windows */
+  Histogram mMessageTimes;
+
+  /** Created the first time frames are paced, since it raises the OS timer resolution */
+  std::unique_ptr<FramePacer> mFramePacer;
+  /** The count at which the next paced frame starts, or 0 if frames are not being paced */
+  uint64_t mNextFrameCount;
+
+private:
+  RenderLoop(const RenderLoop&);
+  RenderLoop& operator=(const RenderLoop&);
+};
@@ -0,0 +1,50 @@
+#include "RetainedSprites.h"
+#include <assert.h>
+#include <string.h>
+
+RetainedSprites::RetainedSprites(void)
+  :mTexture(NULL)
+{
+}
+
+RetainedSprites::~RetainedSprites(void)
+{
+}
+
+void RetainedSprites::clear()
+{
+  mVertices.clear();
+  mTexture = NULL;
+}
+
+void RetainedSprites::reserve(size_t spriteCount)
+{
+  mVertices.reserve(spriteCount * 4);
+}
+
+void RetainedSprites::addString(const FontFace* font, const wchar_t* text, float x, float y, const float colour[4])
+{
+  assert(mTexture == NULL || mTexture == font->getTexture()); /* Every sprite is drawn in one drawSprites() */
+  mTexture = font->getTexture();
+  font->layoutString(text, x, y, colour, &mVertices);
+}
+
+void RetainedSprites::draw(RenderBackend* backend) const
+{
+  if(mVertices.empty())
+  {
+    return;
+  }
+
+  /* The writer only holds a pointer to this, so that std::function can hold it without allocating */
+  const RetainedSprites* sprites = this;
+  backend->drawSprites(mTexture, getSpriteCount(), [sprites](RenderBackend::SpriteVertex* vertices, size_t firstSprite, size_t spriteCount)
+  {
+    memcpy(vertices, &sprites->mVertices[firstSprite * 4], spriteCount * 4 * sizeof(RenderBackend::SpriteVertex));
+  });
+}
+
+size_t RetainedSprites::getSpriteCount() const
+{
+  return mVertices.size() / 4;
+}
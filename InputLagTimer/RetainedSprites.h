@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include "FontFace.h"
+#include "RenderBackend.h"
+
+/**
+ * Sprites that are laid out once and drawn every frame until they change, such as the HUD's text.
+ * Drawing copies the vertices into the backend's buffers in one drawSprites(), without laying
+ * anything out. Every string added must use the same font texture.
+ */
+class RetainedSprites
+{
+public:
+  RetainedSprites(void);
+  virtual ~RetainedSprites(void);
+
+  /**
+   * Removes every sprite, keeping the memory for the sprites that replace them.
+   */
+  void clear();
+
+  /**
+   * Makes room for this many sprites, so that laying out no more than that never allocates.
+   */
+  void reserve(size_t spriteCount);
+
+  /**
+   * Lays out the text as FontFace::drawString() would draw it, and adds its glyphs.
+   */
+  void addString(const FontFace* font, const wchar_t* text, float x, float y, const float colour[4]);
+
+  /**
+   * Draws every sprite added since the last clear().
+   */
+  void draw(RenderBackend* backend) const;
+
+  size_t getSpriteCount() const;
+
+protected:
+  std::vector<RenderBackend::SpriteVertex> mVertices;
+  RenderBackend::TextureHandle mTexture;
+
+private:
+  RetainedSprites(const RetainedSprites&);
+  RetainedSprites& operator=(const RetainedSprites&);
+};
@@ -2,6 +2,33 @@
 #include "Setup.h"
 
 void Setup::getClosestDisplayModeToCurrent(IDXGIOutput* output, DXGI_MODE_DESC* outCurrentDisplayMode)
+{
+  DEVMODE devMode;
+  getDesktopMode(output, &devMode);
+  findClosestDisplayMode(output, devMode, outCurrentDisplayMode);
+}
+
+std::string Setup::getOutputIdentity(IDXGIAdapter* adapter, IDXGIOutput* output)
+{
+  DXGI_ADAPTER_DESC adapterDesc;
+  adapter->GetDesc(&adapterDesc);
+  DXGI_OUTPUT_DESC outputDesc;
+  output->GetDesc(&outputDesc);
+
+  /* The first display device under the output's device is the monitor attached to it */
+  DISPLAY_DEVICE monitorDevice;
+  ZeroMemory(&monitorDevice, sizeof(monitorDevice));
+  monitorDevice.cb = sizeof(monitorDevice);
+  EnumDisplayDevices(outputDesc.DeviceName, 0, &monitorDevice, 0);
+
+  char identity[DISPLAY_PROFILE_IDENTITY_LENGTH];
+  _snprintf_s(identity, DISPLAY_PROFILE_IDENTITY_LENGTH, _TRUNCATE, "%04X:%04X:%08X:%02X|%ls|%ls",
+    adapterDesc.VendorId, adapterDesc.DeviceId, adapterDesc.SubSysId, adapterDesc.Revision,
+    outputDesc.DeviceName, monitorDevice.DeviceID);
+  return identity;
+}
+
+void Setup::getDesktopMode(IDXGIOutput* output, DEVMODE* outDevMode)
 {
   DXGI_OUTPUT_DESC outputDesc;
   output->GetDesc(&outputDesc);
@@ -9,11 +36,13 @@ void Setup::getClosestDisplayModeToCurrent(IDXGIOutput* output, DXGI_MODE_DESC*
   MONITORINFOEX monitorInfo;
   monitorInfo.cbSize = sizeof(MONITORINFOEX);
   GetMonitorInfo(hMonitor, &monitorInfo);
-  DEVMODE devMode;
-  devMode.dmSize = sizeof(DEVMODE);
-  devMode.dmDriverExtra = 0;
-  EnumDisplaySettings(monitorInfo.szDevice, ENUM_CURRENT_SETTINGS, &devMode);
+  outDevMode->dmSize = sizeof(DEVMODE);
+  outDevMode->dmDriverExtra = 0;
+  EnumDisplaySettings(monitorInfo.szDevice, ENUM_CURRENT_SETTINGS, outDevMode);
+}
 
+void Setup::findClosestDisplayMode(IDXGIOutput* output, const DEVMODE& devMode, DXGI_MODE_DESC* outCurrentDisplayMode)
+{
   DXGI_MODE_DESC current;
   current.Width = devMode.dmPelsWidth;
   current.Height = devMode.dmPelsHeight;
@@ -45,9 +74,10 @@ void Setup::getClosestDisplayModeToCurrent(IDXGIOutput* output, DXGI_MODE_DESC*
   //}
 }
 
-Setup::Setup(void)
+Setup::Setup(const DisplayProfile* displayProfile)
+  :mProfiledOutputCount(0)
 {
-  analizeSystem();
+  analizeSystem(displayProfile);
 }
 
 Setup::~Setup(void)
@@ -67,7 +97,55 @@ const Setup::Settings& Setup::getSettings() const
   return mSettings;
 }
 
-void Setup::analizeSystem()
+int Setup::getProfiledOutputCount() const
+{
+  return mProfiledOutputCount;
+}
+
+bool Setup::chooseDisplayMode(const DisplayProfile* displayProfile, OutputSetting* outputSettings)
+{
+  DisplayProfileOutputRecord& record = outputSettings->profileOutput;
+  DEVMODE devMode;
+  getDesktopMode(outputSettings->output, &devMode);
+
+  /* The profiled mode is only good for as long as the desktop is in the mode it was chosen for */
+  const DisplayProfileOutputRecord* profiled = displayProfile ? displayProfile->findOutput(record.identity) : NULL;
+  if(profiled
+    && profiled->desktopWidth == devMode.dmPelsWidth
+    && profiled->desktopHeight == devMode.dmPelsHeight
+    && profiled->desktopFrequency == devMode.dmDisplayFrequency)
+  {
+    record = *profiled;
+    DXGI_MODE_DESC& mode = outputSettings->bufferDesc;
+    mode.Width = record.width;
+    mode.Height = record.height;
+    mode.RefreshRate.Numerator = record.refreshNumerator;
+    mode.RefreshRate.Denominator = record.refreshDenominator;
+    mode.Format = static_cast<DXGI_FORMAT>(record.format);
+    mode.ScanlineOrdering = static_cast<DXGI_MODE_SCANLINE_ORDER>(record.scanlineOrdering);
+    mode.Scaling = static_cast<DXGI_MODE_SCALING>(record.scaling);
+    return true;
+  }
+
+  findClosestDisplayMode(outputSettings->output, devMode, &outputSettings->bufferDesc);
+
+  const DXGI_MODE_DESC& mode = outputSettings->bufferDesc;
+  record.desktopWidth = devMode.dmPelsWidth;
+  record.desktopHeight = devMode.dmPelsHeight;
+  record.desktopFrequency = devMode.dmDisplayFrequency;
+  record.width = mode.Width;
+  record.height = mode.Height;
+  record.refreshNumerator = mode.RefreshRate.Numerator;
+  record.refreshDenominator = mode.RefreshRate.Denominator;
+  record.format = mode.Format;
+  record.scanlineOrdering = mode.ScanlineOrdering;
+  record.scaling = mode.Scaling;
+  /* The mode may have changed, so the old measurement cannot be trusted */
+  record.refreshPeriod = 0.0;
+  return false;
+}
+
+void Setup::analizeSystem(const DisplayProfile* displayProfile)
 {
   IDXGIFactory* factory = NULL;
   CreateDXGIFactory(__uuidof(IDXGIFactory), (void**)(&factory));
@@ -88,7 +166,11 @@ void Setup::analizeSystem()
       ZeroMemory(&outputSettings, sizeof(OutputSetting));
 
       outputSettings.output = output;
-      getClosestDisplayModeToCurrent(output, &outputSettings.bufferDesc);
+      DisplayProfile::setIdentity(getOutputIdentity(adapter, output), &outputSettings.profileOutput);
+      if(chooseDisplayMode(displayProfile, &outputSettings))
+      {
+        ++mProfiledOutputCount;
+      }
 
       /* Find the desktop coordinates of the window: */
       DXGI_OUTPUT_DESC outputDesc;
@@ -1,5 +1,7 @@
 #pragma once
+#include <string>
 #include <vector>
+#include "DisplayProfile.h"
 
 class Setup
 {
@@ -10,6 +12,8 @@ public:
     DXGI_MODE_DESC bufferDesc;
     LONG windowPositionTop;
     LONG windowPositionLeft;
+    /** The output's identity, desktop mode and chosen mode, to be saved in the display profile */
+    DisplayProfileOutputRecord profileOutput;
   };
 
   struct AdapterSetting
@@ -25,18 +29,43 @@ public:
 
   static void getClosestDisplayModeToCurrent(IDXGIOutput* output, DXGI_MODE_DESC* outCurrentDisplayMode);
 
-  Setup(void);
+  /**
+   * @return a name for the output that stays the same between sessions: the adapter's PCI IDs,
+   * the output's device name and the ID of the monitor attached to it.
+   */
+  static std::string getOutputIdentity(IDXGIAdapter* adapter, IDXGIOutput* output);
+
+  /**
+   * @param displayProfile if not NULL, outputs whose desktop mode has not changed since they were
+   * profiled reuse the profiled display mode instead of searching the output's mode list.
+   */
+  Setup(const DisplayProfile* displayProfile);
   virtual ~Setup(void);
 
   const Settings& getSettings() const;
 
+  /**
+   * @return the number of outputs whose display mode came from the display profile.
+   */
+  int getProfiledOutputCount() const;
+
 protected:
+  static void getDesktopMode(IDXGIOutput* output, DEVMODE* outDevMode);
+  static void findClosestDisplayMode(IDXGIOutput* output, const DEVMODE& desktopMode, DXGI_MODE_DESC* outDisplayMode);
+
   /**
    * Analyses the system using a DXGI factory to enumerate adapters
    * and outputs. Chooses settings and fills in the mSettings structure.
    */
-  void analizeSystem();
+  void analizeSystem(const DisplayProfile* displayProfile);
+
+  /**
+   * Chooses the output's display mode, from the profile if the profile is still valid for it.
+   * @return true if the profile was used.
+   */
+  bool chooseDisplayMode(const DisplayProfile* displayProfile, OutputSetting* outputSettings);
 
   Settings mSettings;
+  int mProfiledOutputCount;
 };
 
@@ -0,0 +1,744 @@
+#include "SoftwareRasterizer.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "SpriteFontParser.h"
+
+#if defined(_MSC_VER)
+#pragma warning(disable : 4996)
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASTERIZER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+  const uint32_t FORMAT_R8G8B8A8 = 28;
+  const uint32_t FORMAT_BC2 = 74;
+  const uint32_t FORMAT_B4G4R4A4 = 115;
+
+  /** @return x * y / 255, rounded, for x and y from 0 to 255. The SSE2 path uses the same arithmetic. */
+  inline uint32_t mul255(uint32_t x, uint32_t y)
+  {
+    uint32_t t = x * y + 128;
+    return (t + (t >> 8)) >> 8;
+  }
+
+  uint32_t packChannel(float value)
+  {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return static_cast<uint32_t>(value * 255.0f + 0.5f);
+  }
+
+  uint32_t packColour(float r, float g, float b, float a)
+  {
+    return packChannel(r) | (packChannel(g) << 8) | (packChannel(b) << 16) | (packChannel(a) << 24);
+  }
+
+  /** @return the pixel multiplied by the colour, a channel at a time, as the sprite pixel shader does */
+  inline uint32_t modulate(uint32_t pixel, uint32_t colour)
+  {
+    uint32_t result = 0;
+    for(int shift = 0; shift < 32; shift += 8)
+    {
+      result |= mul255((pixel >> shift) & 0xFF, (colour >> shift) & 0xFF) << shift;
+    }
+    return result;
+  }
+
+  /** @return the premultiplied source drawn over the destination */
+  inline uint32_t blend(uint32_t source, uint32_t destination)
+  {
+    uint32_t inverseAlpha = 255 - (source >> 24);
+    uint32_t result = 0;
+    for(int shift = 0; shift < 32; shift += 8)
+    {
+      uint32_t value = ((source >> shift) & 0xFF) + mul255((destination >> shift) & 0xFF, inverseAlpha);
+      result |= (value > 255 ? 255 : value) << shift;
+    }
+    return result;
+  }
+
+#if defined(RASTERIZER_SSE2)
+  /** mul255 on eight 16 bit lanes */
+  inline __m128i mul255x8(__m128i x, __m128i y)
+  {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+  }
+
+  /** modulate on four pixels */
+  inline __m128i modulate4(__m128i pixels, __m128i colour)
+  {
+    __m128i zero = _mm_setzero_si128();
+    __m128i colourWide = _mm_unpacklo_epi8(colour, zero);
+    __m128i low = mul255x8(_mm_unpacklo_epi8(pixels, zero), colourWide);
+    __m128i high = mul255x8(_mm_unpackhi_epi8(pixels, zero), colourWide);
+    return _mm_packus_epi16(low, high);
+  }
+
+  /** blend on four pixels */
+  inline __m128i blend4(__m128i source, __m128i destination)
+  {
+    __m128i zero = _mm_setzero_si128();
+    /* 255 - alpha, in every channel of each pixel */
+    __m128i alpha = _mm_srli_epi32(source, 24);
+    alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+    alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+    __m128i inverseAlpha = _mm_xor_si128(alpha, _mm_set1_epi32(-1));
+    __m128i low = mul255x8(_mm_unpacklo_epi8(destination, zero), _mm_unpacklo_epi8(inverseAlpha, zero));
+    __m128i high = mul255x8(_mm_unpackhi_epi8(destination, zero), _mm_unpackhi_epi8(inverseAlpha, zero));
+    return _mm_adds_epu8(source, _mm_packus_epi16(low, high));
+  }
+#endif
+
+  /** @return the 5:6:5 colour expanded to 8 bits per channel, with red in the lowest byte */
+  uint32_t expand565(uint32_t colour)
+  {
+    uint32_t r = (colour >> 11) & 0x1F;
+    uint32_t g = (colour >> 5) & 0x3F;
+    uint32_t b = colour & 0x1F;
+    return ((r << 3) | (r >> 2)) | (((g << 2) | (g >> 4)) << 8) | (((b << 3) | (b >> 2)) << 16);
+  }
+
+  /** @return the channels of a and b mixed as (a * weightA + b * weightB) / 3 */
+  uint32_t mixThirds(uint32_t a, uint32_t b, uint32_t weightA, uint32_t weightB)
+  {
+    uint32_t result = 0;
+    for(int shift = 0; shift < 24; shift += 8)
+    {
+      result |= ((((a >> shift) & 0xFF) * weightA + ((b >> shift) & 0xFF) * weightB) / 3) << shift;
+    }
+    return result;
+  }
+
+  /**
+   * Edge function: positive on the inside of an edge from a to b, for a triangle wound so that its area is positive.
+   */
+  inline float edge(float ax, float ay, float bx, float by, float px, float py)
+  {
+    return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+  }
+
+  /** Whether pixel centres exactly on the edge are drawn, by D3D's top-left rule */
+  inline bool isTopLeft(float ax, float ay, float bx, float by)
+  {
+    return (by == ay && bx > ax) || by < ay;
+  }
+}
+
+SoftwareRasterizer::Texture::Texture(void)
+  :mWidth(0),
+  mHeight(0)
+{
+}
+
+bool SoftwareRasterizer::Texture::loadSpriteFont(const DirectX::SpriteFontView& font)
+{
+  mWidth = 0;
+  mHeight = 0;
+  mTexels.clear();
+
+  int width = static_cast<int>(font.textureWidth);
+  int height = static_cast<int>(font.textureHeight);
+  std::vector<uint32_t> texels(width * height, 0);
+
+  if(font.textureFormat == FORMAT_R8G8B8A8)
+  {
+    for(int y = 0; y < height; ++y)
+    {
+      memcpy(&texels[y * width], font.textureData + y * font.textureStride, width * sizeof(uint32_t));
+    }
+  }
+  else if(font.textureFormat == FORMAT_B4G4R4A4)
+  {
+    for(int y = 0; y < height; ++y)
+    {
+      const uint8_t* row = font.textureData + y * font.textureStride;
+      for(int x = 0; x < width; ++x)
+      {
+        uint32_t value = row[x * 2] | (row[x * 2 + 1] << 8);
+        uint32_t b = value & 0xF;
+        uint32_t g = (value >> 4) & 0xF;
+        uint32_t r = (value >> 8) & 0xF;
+        uint32_t a = (value >> 12) & 0xF;
+        texels[y * width + x] = (r * 17) | ((g * 17) << 8) | ((b * 17) << 16) | ((a * 17) << 24);
+      }
+    }
+  }
+  else if(font.textureFormat == FORMAT_BC2)
+  {
+    /* 16 byte blocks of 4x4 texels: 4 bit alphas, then a colour block that always has 4 colours */
+    for(int blockY = 0; blockY * 4 < height; ++blockY)
+    {
+      const uint8_t* block = font.textureData + blockY * font.textureStride;
+      for(int blockX = 0; blockX * 4 < width; ++blockX, block += 16)
+      {
+        uint32_t colours[4];
+        colours[0] = expand565(block[8] | (block[9] << 8));
+        colours[1] = expand565(block[10] | (block[11] << 8));
+        colours[2] = mixThirds(colours[0], colours[1], 2, 1);
+        colours[3] = mixThirds(colours[0], colours[1], 1, 2);
+        uint32_t indices = block[12] | (block[13] << 8) | (block[14] << 16) | (static_cast<uint32_t>(block[15]) << 24);
+
+        for(int i = 0; i < 16; ++i)
+        {
+          int x = blockX * 4 + (i & 3);
+          int y = blockY * 4 + (i >> 2);
+          if(x >= width || y >= height)
+          {
+            continue;
+          }
+          uint32_t alpha = (block[i >> 1] >> ((i & 1) * 4)) & 0xF;
+          texels[y * width + x] = colours[(indices >> (i * 2)) & 3] | ((alpha * 17) << 24);
+        }
+      }
+    }
+  }
+  else
+  {
+    return false;
+  }
+
+  mWidth = width;
+  mHeight = height;
+  mTexels.swap(texels);
+  return true;
+}
+
+int SoftwareRasterizer::Texture::getWidth() const
+{
+  return mWidth;
+}
+
+int SoftwareRasterizer::Texture::getHeight() const
+{
+  return mHeight;
+}
+
+const uint32_t* SoftwareRasterizer::Texture::getTexels() const
+{
+  return mTexels.data();
+}
+
+SoftwareRasterizer::SoftwareRasterizer(int width, int height, int threadCount)
+  :mWidth(width),
+  mHeight(height),
+  mTilesX((width + TILE_SIZE - 1) / TILE_SIZE),
+  mTilesY((height + TILE_SIZE - 1) / TILE_SIZE),
+  mPixels(width * height, 0),
+  mWorkGeneration(0),
+  mBusyWorkers(0),
+  mStopping(false),
+  mNextTile(0)
+{
+  mTilePrimitives.resize(mTilesX * mTilesY);
+  for(int i = 1; i < threadCount; ++i)
+  {
+    mWorkers.push_back(std::thread(&SoftwareRasterizer::workerMain, this));
+  }
+}
+
+SoftwareRasterizer::~SoftwareRasterizer(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(mWorkMutex);
+    mStopping = true;
+  }
+  mWorkStarted.notify_all();
+  for(auto iter = mWorkers.begin(); iter != mWorkers.end(); ++iter)
+  {
+    iter->join();
+  }
+}
+
+void SoftwareRasterizer::clear(const float colour[4])
+{
+  Primitive primitive;
+  memset(&primitive, 0, sizeof(primitive));
+  primitive.type = PRIMITIVE_CLEAR;
+  primitive.colour = packColour(colour[0], colour[1], colour[2], colour[3]);
+  primitive.right = mWidth;
+  primitive.bottom = mHeight;
+  binPrimitive(primitive);
+}
+
+void SoftwareRasterizer::drawSprites(const Texture* texture, const SpriteVertex* vertices, size_t spriteCount)
+{
+  for(size_t i = 0; i < spriteCount; ++i, vertices += 4)
+  {
+    Primitive primitive;
+    memset(&primitive, 0, sizeof(primitive));
+    primitive.texture = texture;
+    primitive.firstVertex = static_cast<uint32_t>(mSpriteVertices.size());
+    mSpriteVertices.insert(mSpriteVertices.end(), vertices, vertices + 4);
+
+    const SpriteVertex& v0 = vertices[0];
+    const SpriteVertex& v1 = vertices[1];
+    const SpriteVertex& v2 = vertices[2];
+    const SpriteVertex& v3 = vertices[3];
+    bool sameColour = true;
+    for(int corner = 1; corner < 4; ++corner)
+    {
+      sameColour = sameColour && vertices[corner].r == v0.r && vertices[corner].g == v0.g && vertices[corner].b == v0.b && vertices[corner].a == v0.a;
+    }
+    bool axisAligned = v0.y == v1.y && v2.y == v3.y && v0.x == v2.x && v1.x == v3.x && v1.x > v0.x && v2.y > v0.y
+      && v0.u == v2.u && v1.u == v3.u && v0.v == v1.v && v2.v == v3.v;
+
+    if(axisAligned && sameColour)
+    {
+      /* The pixels whose centres are inside, with the left and top edges inclusive */
+      primitive.type = PRIMITIVE_RECT;
+      primitive.colour = packColour(v0.r, v0.g, v0.b, v0.a);
+      primitive.left = static_cast<int>(ceilf(v0.x - 0.5f));
+      primitive.right = static_cast<int>(ceilf(v1.x - 0.5f));
+      primitive.top = static_cast<int>(ceilf(v0.y - 0.5f));
+      primitive.bottom = static_cast<int>(ceilf(v2.y - 0.5f));
+      binPrimitive(primitive);
+      continue;
+    }
+
+    /* SpriteBatch's index order: 0, 1, 2 and 1, 3, 2 */
+    primitive.type = PRIMITIVE_TEXTURED_TRIANGLE;
+    for(uint32_t triangle = 0; triangle < 2; ++triangle)
+    {
+      const SpriteVertex& a = triangle == 0 ? v0 : v1;
+      const SpriteVertex& b = triangle == 0 ? v1 : v3;
+      const SpriteVertex& c = v2;
+      primitive.triangle = triangle;
+      primitive.left = static_cast<int>(floorf(std::min(a.x, std::min(b.x, c.x))));
+      primitive.right = static_cast<int>(ceilf(std::max(a.x, std::max(b.x, c.x))));
+      primitive.top = static_cast<int>(floorf(std::min(a.y, std::min(b.y, c.y))));
+      primitive.bottom = static_cast<int>(ceilf(std::max(a.y, std::max(b.y, c.y))));
+      binPrimitive(primitive);
+    }
+  }
+}
+
+void SoftwareRasterizer::drawTriangles(const ColorVertex* vertices, size_t triangleCount)
+{
+  for(size_t i = 0; i < triangleCount; ++i, vertices += 3)
+  {
+    Primitive primitive;
+    memset(&primitive, 0, sizeof(primitive));
+    primitive.type = PRIMITIVE_TRIANGLE;
+    primitive.firstVertex = static_cast<uint32_t>(mColorVertices.size());
+    mColorVertices.insert(mColorVertices.end(), vertices, vertices + 3);
+
+    const ColorVertex& a = vertices[0];
+    const ColorVertex& b = vertices[1];
+    const ColorVertex& c = vertices[2];
+    primitive.left = static_cast<int>(floorf(std::min(a.x, std::min(b.x, c.x))));
+    primitive.right = static_cast<int>(ceilf(std::max(a.x, std::max(b.x, c.x))));
+    primitive.top = static_cast<int>(floorf(std::min(a.y, std::min(b.y, c.y))));
+    primitive.bottom = static_cast<int>(ceilf(std::max(a.y, std::max(b.y, c.y))));
+    binPrimitive(primitive);
+  }
+}
+
+void SoftwareRasterizer::binPrimitive(const Primitive& primitive)
+{
+  int left = std::max(primitive.left, 0);
+  int top = std::max(primitive.top, 0);
+  int right = std::min(primitive.right, mWidth);
+  int bottom = std::min(primitive.bottom, mHeight);
+  if(left >= right || top >= bottom)
+  {
+    return;
+  }
+
+  uint32_t index = static_cast<uint32_t>(mPrimitives.size());
+  mPrimitives.push_back(primitive);
+  for(int tileY = top / TILE_SIZE; tileY <= (bottom - 1) / TILE_SIZE; ++tileY)
+  {
+    for(int tileX = left / TILE_SIZE; tileX <= (right - 1) / TILE_SIZE; ++tileX)
+    {
+      mTilePrimitives[tileY * mTilesX + tileX].push_back(index);
+    }
+  }
+}
+
+void SoftwareRasterizer::flush()
+{
+  mNextTile.store(0);
+  if(!mWorkers.empty())
+  {
+    std::lock_guard<std::mutex> lock(mWorkMutex);
+    mBusyWorkers = static_cast<int>(mWorkers.size());
+    ++mWorkGeneration;
+  }
+  mWorkStarted.notify_all();
+
+  rasterizeTiles();
+
+  if(!mWorkers.empty())
+  {
+    std::unique_lock<std::mutex> lock(mWorkMutex);
+    while(mBusyWorkers > 0)
+    {
+      mWorkFinished.wait(lock);
+    }
+  }
+
+  for(auto iter = mTilePrimitives.begin(); iter != mTilePrimitives.end(); ++iter)
+  {
+    iter->clear();
+  }
+  mPrimitives.clear();
+  mSpriteVertices.clear();
+  mColorVertices.clear();
+}
+
+void SoftwareRasterizer::workerMain()
+{
+  unsigned int generation = 0;
+  std::unique_lock<std::mutex> lock(mWorkMutex);
+  while(true)
+  {
+    while(!mStopping && generation == mWorkGeneration)
+    {
+      mWorkStarted.wait(lock);
+    }
+    if(mStopping)
+    {
+      return;
+    }
+    generation = mWorkGeneration;
+
+    lock.unlock();
+    rasterizeTiles();
+    lock.lock();
+
+    if(--mBusyWorkers == 0)
+    {
+      mWorkFinished.notify_one();
+    }
+  }
+}
+
+void SoftwareRasterizer::rasterizeTiles()
+{
+  int tileCount = mTilesX * mTilesY;
+  for(int tile = mNextTile.fetch_add(1); tile < tileCount; tile = mNextTile.fetch_add(1))
+  {
+    rasterizeTile(tile);
+  }
+}
+
+void SoftwareRasterizer::rasterizeTile(int tile)
+{
+  int tileLeft = (tile % mTilesX) * TILE_SIZE;
+  int tileTop = (tile / mTilesX) * TILE_SIZE;
+  int tileRight = std::min(tileLeft + TILE_SIZE, mWidth);
+  int tileBottom = std::min(tileTop + TILE_SIZE, mHeight);
+
+  const std::vector<uint32_t>& primitives = mTilePrimitives[tile];
+  for(auto iter = primitives.begin(); iter != primitives.end(); ++iter)
+  {
+    const Primitive& primitive = mPrimitives[*iter];
+    int left = std::max(primitive.left, tileLeft);
+    int top = std::max(primitive.top, tileTop);
+    int right = std::min(primitive.right, tileRight);
+    int bottom = std::min(primitive.bottom, tileBottom);
+    if(left >= right || top >= bottom)
+    {
+      continue;
+    }
+
+    switch(primitive.type)
+    {
+    case PRIMITIVE_CLEAR:
+      for(int y = top; y < bottom; ++y)
+      {
+        std::fill(&mPixels[y * mWidth + left], &mPixels[y * mWidth + right], primitive.colour);
+      }
+      break;
+    case PRIMITIVE_RECT:
+      drawRect(primitive, left, top, right, bottom);
+      break;
+    case PRIMITIVE_TEXTURED_TRIANGLE:
+    case PRIMITIVE_TRIANGLE:
+      drawTriangle(primitive, left, top, right, bottom);
+      break;
+    }
+  }
+}
+
+void SoftwareRasterizer::drawRect(const Primitive& primitive, int left, int top, int right, int bottom)
+{
+  const SpriteVertex& topLeft = mSpriteVertices[primitive.firstVertex];
+  const SpriteVertex& bottomRight = mSpriteVertices[primitive.firstVertex + 3];
+  const Texture* texture = primitive.texture;
+  int textureWidth = texture->getWidth();
+  int textureHeight = texture->getHeight();
+  const uint32_t* texels = texture->getTexels();
+
+  /* Texture coordinates at pixel centres. Worked out from the absolute pixel, so any tile gets the same texels. */
+  float uPerPixel = (bottomRight.u - topLeft.u) / (bottomRight.x - topLeft.x);
+  float vPerPixel = (bottomRight.v - topLeft.v) / (bottomRight.y - topLeft.y);
+
+  int texelXs[TILE_SIZE];
+  for(int x = left; x < right; ++x)
+  {
+    float u = topLeft.u + (x + 0.5f - topLeft.x) * uPerPixel;
+    int texelX = static_cast<int>(floorf(u * textureWidth));
+    texelXs[x - left] = std::min(std::max(texelX, 0), textureWidth - 1);
+  }
+
+#if defined(RASTERIZER_SSE2)
+  __m128i colour = _mm_set1_epi32(static_cast<int>(primitive.colour));
+#endif
+  for(int y = top; y < bottom; ++y)
+  {
+    float v = topLeft.v + (y + 0.5f - topLeft.y) * vPerPixel;
+    int texelY = std::min(std::max(static_cast<int>(floorf(v * textureHeight)), 0), textureHeight - 1);
+    const uint32_t* texelRow = texels + texelY * textureWidth;
+    uint32_t* destination = &mPixels[y * mWidth];
+
+    int x = left;
+#if defined(RASTERIZER_SSE2)
+    for(; x + 4 <= right; x += 4)
+    {
+      const int* columns = &texelXs[x - left];
+      __m128i source = _mm_set_epi32(static_cast<int>(texelRow[columns[3]]), static_cast<int>(texelRow[columns[2]]),
+                                     static_cast<int>(texelRow[columns[1]]), static_cast<int>(texelRow[columns[0]]));
+      __m128i* pixels = reinterpret_cast<__m128i*>(destination + x);
+      _mm_storeu_si128(pixels, blend4(modulate4(source, colour), _mm_loadu_si128(pixels)));
+    }
+#endif
+    for(; x < right; ++x)
+    {
+      destination[x] = blend(modulate(texelRow[texelXs[x - left]], primitive.colour), destination[x]);
+    }
+  }
+}
+
+void SoftwareRasterizer::drawTriangle(const Primitive& primitive, int left, int top, int right, int bottom)
+{
+  /* Positions, colours and texture coordinates of the 3 corners */
+  float x[3], y[3], colours[3][4], u[3] = { 0, 0, 0 }, v[3] = { 0, 0, 0 };
+  if(primitive.type == PRIMITIVE_TEXTURED_TRIANGLE)
+  {
+    static const int corners[2][3] = { { 0, 1, 2 }, { 1, 3, 2 } };
+    for(int i = 0; i < 3; ++i)
+    {
+      const SpriteVertex& vertex = mSpriteVertices[primitive.firstVertex + corners[primitive.triangle][i]];
+      x[i] = vertex.x; y[i] = vertex.y; u[i] = vertex.u; v[i] = vertex.v;
+      colours[i][0] = vertex.r; colours[i][1] = vertex.g; colours[i][2] = vertex.b; colours[i][3] = vertex.a;
+    }
+  }
+  else
+  {
+    for(int i = 0; i < 3; ++i)
+    {
+      const ColorVertex& vertex = mColorVertices[primitive.firstVertex + i];
+      x[i] = vertex.x; y[i] = vertex.y;
+      colours[i][0] = vertex.r; colours[i][1] = vertex.g; colours[i][2] = vertex.b; colours[i][3] = vertex.a;
+    }
+  }
+
+  /* Wind the triangle so that its area is positive, which puts the inside on the positive side of each edge */
+  float area = edge(x[0], y[0], x[1], y[1], x[2], y[2]);
+  if(area == 0.0f)
+  {
+    return;
+  }
+  if(area < 0.0f)
+  {
+    std::swap(x[1], x[2]); std::swap(y[1], y[2]); std::swap(u[1], u[2]); std::swap(v[1], v[2]);
+    for(int channel = 0; channel < 4; ++channel)
+    {
+      std::swap(colours[1][channel], colours[2][channel]);
+    }
+    area = -area;
+  }
+
+  /* Edge i is opposite corner i, so its function is that corner's weight */
+  const int edgeStart[3] = { 1, 2, 0 };
+  const int edgeEnd[3] = { 2, 0, 1 };
+  bool topLeft[3];
+  for(int i = 0; i < 3; ++i)
+  {
+    topLeft[i] = isTopLeft(x[edgeStart[i]], y[edgeStart[i]], x[edgeEnd[i]], y[edgeEnd[i]]);
+  }
+
+  bool solid = primitive.type == PRIMITIVE_TRIANGLE
+    && memcmp(colours[0], colours[1], sizeof(colours[0])) == 0 && memcmp(colours[0], colours[2], sizeof(colours[0])) == 0;
+  uint32_t solidColour = packColour(colours[0][0], colours[0][1], colours[0][2], colours[0][3]);
+  const Texture* texture = primitive.texture;
+
+  for(int py = top; py < bottom; ++py)
+  {
+    float centreY = py + 0.5f;
+    uint32_t* destination = &mPixels[py * mWidth];
+    int px = left;
+
+#if defined(RASTERIZER_SSE2)
+    if(solid)
+    {
+      /* Four pixel centres at a time against all three edges */
+      __m128 zero = _mm_setzero_ps();
+      __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+      __m128i colour = _mm_set1_epi32(static_cast<int>(solidColour));
+      for(; px + 4 <= right; px += 4)
+      {
+        __m128 centreX = _mm_add_ps(_mm_set1_ps(static_cast<float>(px)), offsets);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(int i = 0; i < 3; ++i)
+        {
+          float ax = x[edgeStart[i]], ay = y[edgeStart[i]];
+          float dx = x[edgeEnd[i]] - ax, dy = y[edgeEnd[i]] - ay;
+          __m128 value = _mm_sub_ps(_mm_set1_ps(dx * (centreY - ay)), _mm_mul_ps(_mm_set1_ps(dy), _mm_sub_ps(centreX, _mm_set1_ps(ax))));
+          __m128 covered = topLeft[i] ? _mm_cmpge_ps(value, zero) : _mm_cmpgt_ps(value, zero);
+          inside = _mm_and_ps(inside, covered);
+        }
+        __m128i mask = _mm_castps_si128(inside);
+        __m128i* pixels = reinterpret_cast<__m128i*>(destination + px);
+        __m128i before = _mm_loadu_si128(pixels);
+        __m128i after = blend4(colour, before);
+        _mm_storeu_si128(pixels, _mm_or_si128(_mm_and_si128(mask, after), _mm_andnot_si128(mask, before)));
+      }
+    }
+#endif
+
+    for(; px < right; ++px)
+    {
+      float centreX = px + 0.5f;
+      float weights[3];
+      bool inside = true;
+      for(int i = 0; i < 3 && inside; ++i)
+      {
+        float ax = x[edgeStart[i]], ay = y[edgeStart[i]];
+        weights[i] = (x[edgeEnd[i]] - ax) * (centreY - ay) - (y[edgeEnd[i]] - ay) * (centreX - ax);
+        inside = weights[i] > 0.0f || (weights[i] == 0.0f && topLeft[i]);
+      }
+      if(!inside)
+      {
+        continue;
+      }
+
+      if(solid)
+      {
+        destination[px] = blend(solidColour, destination[px]);
+        continue;
+      }
+
+      for(int i = 0; i < 3; ++i)
+      {
+        weights[i] /= area;
+      }
+      uint32_t colour = packColour(
+        weights[0] * colours[0][0] + weights[1] * colours[1][0] + weights[2] * colours[2][0],
+        weights[0] * colours[0][1] + weights[1] * colours[1][1] + weights[2] * colours[2][1],
+        weights[0] * colours[0][2] + weights[1] * colours[1][2] + weights[2] * colours[2][2],
+        weights[0] * colours[0][3] + weights[1] * colours[1][3] + weights[2] * colours[2][3]);
+      if(texture)
+      {
+        float texelU = (weights[0] * u[0] + weights[1] * u[1] + weights[2] * u[2]) * texture->getWidth();
+        float texelV = (weights[0] * v[0] + weights[1] * v[1] + weights[2] * v[2]) * texture->getHeight();
+        int texelX = std::min(std::max(static_cast<int>(floorf(texelU)), 0), texture->getWidth() - 1);
+        int texelY = std::min(std::max(static_cast<int>(floorf(texelV)), 0), texture->getHeight() - 1);
+        colour = modulate(texture->getTexels()[texelY * texture->getWidth() + texelX], colour);
+      }
+      destination[px] = blend(colour, destination[px]);
+    }
+  }
+}
+
+int SoftwareRasterizer::getWidth() const
+{
+  return mWidth;
+}
+
+int SoftwareRasterizer::getHeight() const
+{
+  return mHeight;
+}
+
+int SoftwareRasterizer::getThreadCount() const
+{
+  return static_cast<int>(mWorkers.size()) + 1;
+}
+
+const uint32_t* SoftwareRasterizer::getPixels() const
+{
+  return mPixels.data();
+}
+
+bool SoftwareRasterizer::saveTGA(const std::string& path) const
+{
+  FILE* file = fopen(path.c_str(), "wb");
+  if(!file)
+  {
+    return false;
+  }
+
+  /* Uncompressed true colour, 8 bits of alpha, top row first */
+  uint8_t header[18];
+  memset(header, 0, sizeof(header));
+  header[2] = 2;
+  header[12] = static_cast<uint8_t>(mWidth & 0xFF);
+  header[13] = static_cast<uint8_t>(mWidth >> 8);
+  header[14] = static_cast<uint8_t>(mHeight & 0xFF);
+  header[15] = static_cast<uint8_t>(mHeight >> 8);
+  header[16] = 32;
+  header[17] = 0x28;
+  bool written = fwrite(header, sizeof(header), 1, file) == 1;
+
+  /* TGA is BGRA */
+  std::vector<uint8_t> row(mWidth * 4);
+  for(int y = 0; y < mHeight && written; ++y)
+  {
+    for(int x = 0; x < mWidth; ++x)
+    {
+      uint32_t pixel = mPixels[y * mWidth + x];
+      row[x * 4] = static_cast<uint8_t>(pixel >> 16);
+      row[x * 4 + 1] = static_cast<uint8_t>(pixel >> 8);
+      row[x * 4 + 2] = static_cast<uint8_t>(pixel);
+      row[x * 4 + 3] = static_cast<uint8_t>(pixel >> 24);
+    }
+    written = fwrite(row.data(), row.size(), 1, file) == 1;
+  }
+  return fclose(file) == 0 && written;
+}
+
+bool SoftwareRasterizer::loadTGA(const std::string& path, int* outWidth, int* outHeight, std::vector<uint32_t>* outPixels)
+{
+  FILE* file = fopen(path.c_str(), "rb");
+  if(!file)
+  {
+    return false;
+  }
+
+  uint8_t header[18];
+  bool valid = fread(header, sizeof(header), 1, file) == 1 && header[1] == 0 && header[2] == 2 && header[16] == 32
+    && fseek(file, header[0], SEEK_CUR) == 0;
+  int width = header[12] | (header[13] << 8);
+  int height = header[14] | (header[15] << 8);
+  bool topFirst = (header[17] & 0x20) != 0;
+
+  std::vector<uint8_t> row(width * 4);
+  outPixels->assign(width * height, 0);
+  for(int i = 0; i < height && valid; ++i)
+  {
+    valid = width == 0 || fread(row.data(), row.size(), 1, file) == 1;
+    int y = topFirst ? i : height - 1 - i;
+    for(int x = 0; x < width && valid; ++x)
+    {
+      (*outPixels)[y * width + x] = row[x * 4 + 2] | (row[x * 4 + 1] << 8) | (row[x * 4] << 16) | (static_cast<uint32_t>(row[x * 4 + 3]) << 24);
+    }
+  }
+  fclose(file);
+
+  if(!valid)
+  {
+    outPixels->clear();
+    return false;
+  }
+  *outWidth = width;
+  *outHeight = height;
+  return true;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "RenderBackend.h"
+
+namespace DirectX
+{
+  struct SpriteFontView;
+}
+
+/**
+ * Draws what SpriteBatch and PrimitiveBatch draw, on the CPU, into an RGBA image in memory, so that
+ * frames can be rendered and compared against golden images without a GPU, and their cost measured.
+ *
+ * Draws are queued until flush(), which splits the target into tiles and rasterizes the tiles on
+ * several threads, each tile drawing its primitives in the order they were queued. Blending is
+ * premultiplied alpha, as with SpriteBatch's and PrimitiveBatch's default blend state, done in
+ * 8 bits per channel with SSE2 where it is available. Results are the same with any number of threads.
+ *
+ * Textures are sampled at the nearest texel, which matches the linear sampling SpriteBatch uses
+ * for the unscaled, whole pixel text that InputLagTimer draws.
+ */
+class SoftwareRasterizer
+{
+public:
+  /** Positions are in pixels, as RenderBackend draws them */
+  typedef RenderBackend::SpriteVertex SpriteVertex;
+  typedef RenderBackend::ColorVertex ColorVertex;
+
+  /**
+   * A texture in premultiplied RGBA, 8 bits per channel, with red in the lowest byte.
+   */
+  class Texture
+  {
+  public:
+    Texture(void);
+
+    /**
+     * Decodes the font's texture. Handles every format MakeSpriteFont writes: R8G8B8A8, BC2 and B4G4R4A4.
+     * @return false, leaving the texture empty, if the format is not one of those.
+     */
+    bool loadSpriteFont(const DirectX::SpriteFontView& font);
+
+    int getWidth() const;
+    int getHeight() const;
+    const uint32_t* getTexels() const;
+
+  protected:
+    int mWidth;
+    int mHeight;
+    std::vector<uint32_t> mTexels;
+  };
+
+  /**
+   * @param threadCount the threads that rasterize tiles, including the one that calls flush().
+   */
+  SoftwareRasterizer(int width, int height, int threadCount);
+  virtual ~SoftwareRasterizer(void);
+
+  /**
+   * Clears the target before the draws queued after it.
+   * @param colour red, green, blue and alpha from 0 to 1.
+   */
+  void clear(const float colour[4]);
+
+  /**
+   * Queues sprites as SpriteBatch writes them: 4 vertices each, top left, top right, bottom left, bottom right.
+   * The texture must stay alive until flush().
+   */
+  void drawSprites(const Texture* texture, const SpriteVertex* vertices, size_t spriteCount);
+
+  /**
+   * Queues solid triangles, 3 vertices each, as PrimitiveBatch draws them for DrawTriangle and DrawQuad.
+   */
+  void drawTriangles(const ColorVertex* vertices, size_t triangleCount);
+
+  /**
+   * Rasterizes everything queued since the last flush.
+   */
+  void flush();
+
+  int getWidth() const;
+  int getHeight() const;
+  int getThreadCount() const;
+
+  /** @return the target, a row of getWidth() pixels at a time, in the same format as Texture. */
+  const uint32_t* getPixels() const;
+
+  /**
+   * Writes the target as an uncompressed 32 bit TGA.
+   * @return false if the file could not be written.
+   */
+  bool saveTGA(const std::string& path) const;
+
+  /**
+   * Reads a TGA written by saveTGA() into outPixels.
+   * @return false if the file could not be read or is not a 32 bit uncompressed TGA.
+   */
+  static bool loadTGA(const std::string& path, int* outWidth, int* outHeight, std::vector<uint32_t>* outPixels);
+
+  static const int TILE_SIZE = 64;
+
+protected:
+  enum PrimitiveType
+  {
+    PRIMITIVE_CLEAR,
+    /** A sprite whose corners make an axis aligned rectangle with one colour: filled a span at a time */
+    PRIMITIVE_RECT,
+    /** Half of a rotated sprite */
+    PRIMITIVE_TEXTURED_TRIANGLE,
+    PRIMITIVE_TRIANGLE,
+  };
+
+  struct Primitive
+  {
+    PrimitiveType type;
+    const Texture* texture;
+    /** Into mSpriteVertices or mColorVertices */
+    uint32_t firstVertex;
+    /** For a textured triangle, which 3 of the sprite's 4 vertices */
+    uint32_t triangle;
+    /** For a clear, the colour */
+    uint32_t colour;
+    /** The pixels that the primitive can touch: [left, right) and [top, bottom) */
+    int left, top, right, bottom;
+  };
+
+  /** Adds the primitive to the list of every tile it touches */
+  void binPrimitive(const Primitive& primitive);
+
+  void workerMain();
+
+  /** Takes tiles from mNextTile until there are none left */
+  void rasterizeTiles();
+  void rasterizeTile(int tile);
+
+  void drawRect(const Primitive& primitive, int left, int top, int right, int bottom);
+  void drawTriangle(const Primitive& primitive, int left, int top, int right, int bottom);
+
+  int mWidth;
+  int mHeight;
+  int mTilesX;
+  int mTilesY;
+  std::vector<uint32_t> mPixels;
+
+  std::vector<SpriteVertex> mSpriteVertices;
+  std::vector<ColorVertex> mColorVertices;
+  std::vector<Primitive> mPrimitives;
+  /** The primitives that touch each tile, in the order they were queued. Cleared, not freed, after each flush. */
+  std::vector<std::vector<uint32_t>> mTilePrimitives;
+
+  std::vector<std::thread> mWorkers;
+  std::mutex mWorkMutex;
+  std::condition_variable mWorkStarted;
+  std::condition_variable mWorkFinished;
+  /** Raised by flush() to start the workers on the next lot of tiles */
+  unsigned int mWorkGeneration;
+  int mBusyWorkers;
+  bool mStopping;
+  std::atomic<int> mNextTile;
+
+private:
+  SoftwareRasterizer(const SoftwareRasterizer&);
+  SoftwareRasterizer& operator=(const SoftwareRasterizer&);
+};
@@ -0,0 +1,61 @@
+#include "SoftwareRenderBackend.h"
+
+#define VERTICES_PER_SPRITE 4
+
+SoftwareRenderBackend::SoftwareRenderBackend(int width, int height, int threadCount)
+  :mRasterizer(width, height, threadCount),
+  mSpriteCount(0)
+{
+}
+
+SoftwareRenderBackend::~SoftwareRenderBackend(void)
+{
+}
+
+void SoftwareRenderBackend::beginFrame(const float clearColour[4])
+{
+  mSpriteCount = 0;
+  mRasterizer.clear(clearColour);
+}
+
+void SoftwareRenderBackend::clear(const float colour[4])
+{
+  mRasterizer.clear(colour);
+}
+
+void SoftwareRenderBackend::drawSprites(TextureHandle texture, size_t spriteCount, const SpriteWriter& writeVertices)
+{
+  if(spriteCount == 0)
+  {
+    return;
+  }
+
+  /* Grows to the largest draw, and then stays that size */
+  if(mSpriteVertices.size() < spriteCount * VERTICES_PER_SPRITE)
+  {
+    mSpriteVertices.resize(spriteCount * VERTICES_PER_SPRITE);
+  }
+  writeVertices(mSpriteVertices.data(), 0, spriteCount);
+  mRasterizer.drawSprites(static_cast<const SoftwareRasterizer::Texture*>(texture), mSpriteVertices.data(), spriteCount);
+  mSpriteCount += spriteCount;
+}
+
+void SoftwareRenderBackend::drawTriangles(const ColorVertex* vertices, size_t triangleCount)
+{
+  mRasterizer.drawTriangles(vertices, triangleCount);
+}
+
+void SoftwareRenderBackend::present()
+{
+  mRasterizer.flush();
+}
+
+const SoftwareRasterizer& SoftwareRenderBackend::getRasterizer() const
+{
+  return mRasterizer;
+}
+
+size_t SoftwareRenderBackend::getSpriteCount() const
+{
+  return mSpriteCount;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include "RenderBackend.h"
+#include "SoftwareRasterizer.h"
+
+/**
+ * A backend that draws on the CPU with SoftwareRasterizer, so that OutputRenderer's frames can be
+ * checked against golden images and their cost measured without a GPU.
+ *
+ * Texture handles are SoftwareRasterizer::Texture pointers: a font drawn through this backend is
+ * created with its decoded texture as the handle. Draws are queued with the rasterizer and drawn
+ * when the frame is presented.
+ */
+class SoftwareRenderBackend : public RenderBackend
+{
+public:
+  /**
+   * @param threadCount the threads that rasterize each frame, including the one that presents it.
+   */
+  SoftwareRenderBackend(int width, int height, int threadCount);
+  virtual ~SoftwareRenderBackend(void);
+
+  virtual void beginFrame(const float clearColour[4]);
+  virtual void clear(const float colour[4]);
+  virtual void drawSprites(TextureHandle texture, size_t spriteCount, const SpriteWriter& writeVertices);
+  virtual void drawTriangles(const ColorVertex* vertices, size_t triangleCount);
+  virtual void present();
+
+  /** @return the rasterizer, whose pixels are the last frame that was presented */
+  const SoftwareRasterizer& getRasterizer() const;
+
+  /** @return the sprites drawn since the last frame was begun */
+  size_t getSpriteCount() const;
+
+protected:
+  SoftwareRasterizer mRasterizer;
+  /** The sprites' vertices are written here, then copied into the rasterizer's queue */
+  std::vector<SpriteVertex> mSpriteVertices;
+  size_t mSpriteCount;
+
+private:
+  SoftwareRenderBackend(const SoftwareRenderBackend&);
+  SoftwareRenderBackend& operator=(const SoftwareRenderBackend&);
+};
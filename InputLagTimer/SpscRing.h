@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+/**
+ * A fixed-capacity, lock-free, single-producer/single-consumer ring buffer.
+ * push() and pop() never block or allocate: push() fails when the ring is full
+ * and pop() fails when it is empty. CAPACITY must be a power of two.
+ */
+template<typename T, size_t CAPACITY>
+class SpscRing
+{
+public:
+  SpscRing(void)
+    :mHead(0),
+    mTail(0)
+  {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SpscRing capacity must be a power of two");
+  }
+
+  /**
+   * Called only from the producer thread.
+   * @return false if the ring was full and the value was not added.
+   */
+  bool push(const T& value)
+  {
+    size_t head = mHead.load(std::memory_order_relaxed);
+    if(head - mTail.load(std::memory_order_acquire) >= CAPACITY)
+    {
+      return false;
+    }
+    mItems[head & (CAPACITY - 1)] = value;
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Called only from the consumer thread.
+   * @return false if the ring was empty and outValue was not written.
+   */
+  bool pop(T* outValue)
+  {
+    size_t tail = mTail.load(std::memory_order_relaxed);
+    if(tail == mHead.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    *outValue = mItems[tail & (CAPACITY - 1)];
+    mTail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+protected:
+  /* The producer and consumer indices are kept on separate cache lines so
+     that the two threads do not contend for the same line on every operation. */
+  std::atomic<size_t> mHead;
+  char mHeadPadding[64 - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> mTail;
+  char mTailPadding[64 - sizeof(std::atomic<size_t>)];
+
+  T mItems[CAPACITY];
+
+private:
+  SpscRing(const SpscRing&);
+  SpscRing& operator=(const SpscRing&);
+};
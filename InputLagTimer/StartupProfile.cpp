@@ -0,0 +1,45 @@
+#include "StartupProfile.h"
+
+StartupProfile::StartupProfile(Clock* clock)
+  :mClock(clock),
+  mStartCount(clock->getCount())
+{
+}
+
+void StartupProfile::endPhase(const wchar_t* name)
+{
+  Phase phase;
+  phase.name = name;
+  phase.endCount = mClock->getCount();
+  mPhases.push_back(phase);
+}
+
+int StartupProfile::getPhaseCount() const
+{
+  return static_cast<int>(mPhases.size());
+}
+
+const wchar_t* StartupProfile::getPhaseName(int phase) const
+{
+  return mPhases[phase].name;
+}
+
+double StartupProfile::getPhaseSeconds(int phase) const
+{
+  uint64_t startCount = phase == 0 ? mStartCount : mPhases[phase - 1].endCount;
+  return static_cast<double>(mPhases[phase].endCount - startCount) / mClock->getFrequency();
+}
+
+double StartupProfile::getTotalSeconds() const
+{
+  if(mPhases.empty())
+  {
+    return 0.0;
+  }
+  return static_cast<double>(mPhases.back().endCount - mStartCount) / mClock->getFrequency();
+}
+
+double StartupProfile::getElapsedSeconds() const
+{
+  return static_cast<double>(mClock->getCount() - mStartCount) / mClock->getFrequency();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "Clock.h"
+
+/**
+ * Times the phases of startup, from launch to the first frame on every output.
+ * Each call to endPhase() closes the phase that began at the previous call, or at construction.
+ */
+class StartupProfile
+{
+public:
+  StartupProfile(Clock* clock);
+
+  /**
+   * Ends the current phase and starts the next one.
+   * @param name must outlive the profile; string literals are expected.
+   */
+  void endPhase(const wchar_t* name);
+
+  int getPhaseCount() const;
+  const wchar_t* getPhaseName(int phase) const;
+  double getPhaseSeconds(int phase) const;
+
+  /**
+   * @return the seconds from construction until the last phase ended.
+   */
+  double getTotalSeconds() const;
+
+  /**
+   * @return the seconds since construction, for timing work that overlaps the phases.
+   */
+  double getElapsedSeconds() const;
+
+protected:
+  struct Phase
+  {
+    const wchar_t* name;
+    uint64_t endCount;
+  };
+
+  Clock* mClock;
+  uint64_t mStartCount;
+  std::vector<Phase> mPhases;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * The binary timing log written by TelemetryRecorder.
+ * A TelemetryFileHeader is followed by a TelemetryOutputInfo for each output,
+ * then fixed-size TelemetryRecords, one per output per frame, in the order
+ * they were flushed. Records from different outputs are interleaved but each
+ * output's records are in frame order. All values are little-endian.
+ */
+
+#define TELEMETRY_MAGIC "ILTIMING"
+#define TELEMETRY_VERSION 3
+
+#pragma pack(push, 1)
+
+struct TelemetryFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  /** Bytes from the start of the file to the first record, including the output infos */
+  uint32_t headerSize;
+  uint32_t recordSize;
+  uint32_t outputCount;
+  /** Counter ticks per second */
+  uint64_t frequency;
+  /** The count at which the timer read zero */
+  uint64_t startingCount;
+};
+
+struct TelemetryOutputInfo
+{
+  /** The refresh period the output's model used to advance columns, in counter ticks */
+  uint64_t countsPerRefresh;
+};
+
+struct TelemetryRecord
+{
+  /** The counter value that the displayed timer value was computed from */
+  uint64_t startCount;
+  /** The counter value directly after Present returned */
+  uint64_t renderCompleteCount;
+  /** The loop this frame belonged to. Equal across outputs for the same loop. */
+  uint32_t frameIndex;
+  uint16_t outputIndex;
+  uint8_t column;
+  /** A Model::ErrorType */
+  uint8_t error;
+  /** Heap allocations made by the thread that rendered the frame, from the timer value being sampled to the record */
+  uint32_t allocations;
+};
+
+#pragma pack(pop)
+
+static_assert(sizeof(TelemetryFileHeader) == 40, "TelemetryFileHeader layout is part of the file format");
+static_assert(sizeof(TelemetryOutputInfo) == 8, "TelemetryOutputInfo layout is part of the file format");
+static_assert(sizeof(TelemetryRecord) == 28, "TelemetryRecord layout is part of the file format");
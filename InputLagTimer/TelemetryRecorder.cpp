@@ -0,0 +1,110 @@
+#include "TelemetryRecorder.h"
+#include <string.h>
+#include <chrono>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
+#if defined(_MSC_VER)
+#pragma warning(disable : 4996)
+#endif
+
+/* How long the flusher sleeps between drains */
+#define FLUSH_INTERVAL_MS 10
+
+TelemetryRecorder::TelemetryRecorder(const std::string& path, uint64_t frequency, uint64_t startingCount, const std::vector<uint64_t>& countsPerRefresh)
+  :mFile(NULL),
+  mDroppedCount(0),
+  mStopping(false)
+{
+  uint32_t outputCount = static_cast<uint32_t>(countsPerRefresh.size());
+  for(uint32_t i = 0; i < outputCount; ++i)
+  {
+    mRings.push_back(new Ring());
+  }
+  mWriteBuffer.reserve(RING_CAPACITY);
+
+  mFile = fopen(path.c_str(), "wb");
+  if(mFile)
+  {
+    TelemetryFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TELEMETRY_MAGIC, sizeof(header.magic));
+    header.version = TELEMETRY_VERSION;
+    header.headerSize = sizeof(TelemetryFileHeader) + outputCount * sizeof(TelemetryOutputInfo);
+    header.recordSize = sizeof(TelemetryRecord);
+    header.outputCount = outputCount;
+    header.frequency = frequency;
+    header.startingCount = startingCount;
+    fwrite(&header, sizeof(header), 1, mFile);
+
+    for(auto iter = countsPerRefresh.begin(); iter != countsPerRefresh.end(); ++iter)
+    {
+      TelemetryOutputInfo info;
+      info.countsPerRefresh = *iter;
+      fwrite(&info, sizeof(info), 1, mFile);
+    }
+  }
+
+  mFlusher = std::thread(&TelemetryRecorder::flusherMain, this);
+#if defined(_WIN32)
+  SetThreadPriority(mFlusher.native_handle(), THREAD_PRIORITY_BELOW_NORMAL);
+#endif
+}
+
+TelemetryRecorder::~TelemetryRecorder(void)
+{
+  mStopping.store(true);
+  mFlusher.join();
+
+  /* Anything recorded after the flusher's last pass */
+  drain();
+
+  if(mFile)
+  {
+    fclose(mFile);
+  }
+  for(auto iter = mRings.begin(); iter != mRings.end(); ++iter)
+  {
+    delete *iter;
+  }
+}
+
+bool TelemetryRecorder::isOpen() const
+{
+  return NULL != mFile;
+}
+
+uint64_t TelemetryRecorder::getDroppedCount() const
+{
+  return mDroppedCount.load();
+}
+
+void TelemetryRecorder::flusherMain()
+{
+  while(!mStopping.load())
+  {
+    drain();
+    std::this_thread::sleep_for(std::chrono::milliseconds(FLUSH_INTERVAL_MS));
+  }
+}
+
+void TelemetryRecorder::drain()
+{
+  for(auto iter = mRings.begin(); iter != mRings.end(); ++iter)
+  {
+    TelemetryRecord record;
+    while(mWriteBuffer.size() < mWriteBuffer.capacity() && (*iter)->pop(&record))
+    {
+      mWriteBuffer.push_back(record);
+    }
+
+    if(mFile && !mWriteBuffer.empty())
+    {
+      fwrite(&mWriteBuffer[0], sizeof(TelemetryRecord), mWriteBuffer.size(), mFile);
+    }
+    mWriteBuffer.clear();
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdio.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscRing.h"
+#include "TelemetryFormat.h"
+
+/**
+ * Keeps every frame's timing so that camera captures can be correlated offline.
+ * Render threads push records into a lock-free ring per output and a
+ * low-priority flusher thread drains the rings into a binary log file
+ * (see TelemetryFormat.h). Recording never blocks or allocates: if the
+ * flusher falls behind, records are dropped and counted instead.
+ */
+class TelemetryRecorder
+{
+public:
+  /** Per output. At 2000 FPS this holds eight seconds of frames. */
+  static const size_t RING_CAPACITY = 16384;
+
+  /**
+   * @param countsPerRefresh the refresh period of each output in counter ticks. There is one ring per output.
+   */
+  TelemetryRecorder(const std::string& path, uint64_t frequency, uint64_t startingCount, const std::vector<uint64_t>& countsPerRefresh);
+  virtual ~TelemetryRecorder(void);
+
+  /**
+   * @return false if the log file could not be created. Records are discarded in that case.
+   */
+  bool isOpen() const;
+
+  /**
+   * Called from the render thread of the record's output.
+   */
+  void record(const TelemetryRecord& record)
+  {
+    if(!mRings[record.outputIndex]->push(record))
+    {
+      mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @return the number of records that were lost because a ring was full.
+   */
+  uint64_t getDroppedCount() const;
+
+protected:
+  typedef SpscRing<TelemetryRecord, RING_CAPACITY> Ring;
+
+  void flusherMain();
+  void drain();
+
+  std::vector<Ring*> mRings;
+  FILE* mFile;
+  std::vector<TelemetryRecord> mWriteBuffer;
+  std::atomic<uint64_t> mDroppedCount;
+  std::atomic<bool> mStopping;
+  std::thread mFlusher;
+
+private:
+  TelemetryRecorder(const TelemetryRecorder&);
+  TelemetryRecorder& operator=(const TelemetryRecorder&);
+};
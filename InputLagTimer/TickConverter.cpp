@@ -0,0 +1,42 @@
+#include "TickConverter.h"
+
+TickConverter::TickConverter(uint64_t frequency)
+  :mFrequency(frequency),
+  mSecondsPerTick(1.0 / frequency),
+  mUseMultiplier(false),
+  mMultiplierHigh(0),
+  mMultiplierLow(0)
+{
+  /* The rounded-up multiplier overshoots by less than frequency / 2^64 units, which must stay
+     below the smallest distance to a rounding boundary: 1 / (2 * frequency). */
+  if(frequency > UNITS_PER_SECOND && frequency < 3000000000ull)
+  {
+    /* ceil(UNITS_PER_SECOND * 2^64 / frequency), one 32 bit digit at a time */
+    uint64_t numerator = static_cast<uint64_t>(UNITS_PER_SECOND) << 32;
+    uint64_t high = numerator / frequency;
+    numerator = (numerator % frequency) << 32;
+    uint64_t low = numerator / frequency;
+    if(numerator % frequency != 0)
+    {
+      ++low;
+      if(low > 0xFFFFFFFFu)
+      {
+        low = 0;
+        ++high;
+      }
+    }
+    mMultiplierHigh = static_cast<uint32_t>(high);
+    mMultiplierLow = static_cast<uint32_t>(low);
+    mUseMultiplier = true;
+  }
+}
+
+uint64_t TickConverter::getFrequency() const
+{
+  return mFrequency;
+}
+
+double TickConverter::getSecondsPerTick() const
+{
+  return mSecondsPerTick;
+}
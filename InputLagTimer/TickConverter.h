@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Converts counter ticks into the timer's display units of 10 microseconds
+ * using integer fixed-point math instead of floating point divisions.
+ *
+ * The frequency is read once and turned into a 64.64 fixed-point
+ * ticks-to-10us multiplier, so each conversion is a multiply and a shift.
+ * The multiplier is rounded up, which keeps results identical to exact
+ * round-half-up division for any frequency below 3 GHz. Clocks faster than
+ * that fall back to an integer division.
+ *
+ * This is not bit-identical to the double conversion the timer used before.
+ * A tick count exactly half way between two units always rounds up here, but
+ * the double conversion rounded it whichever way its floating point error fell,
+ * as it also did for counts within that error of half way. Over a day at 10MHz,
+ * that changes about 1 in 1200 timer values by one unit.
+ */
+class TickConverter
+{
+public:
+  /** Display units per second: the timer shows 1/100ths of a millisecond. */
+  static const uint32_t UNITS_PER_SECOND = 100000;
+
+  explicit TickConverter(uint64_t frequency);
+
+  /**
+   * @param ticks must be less than the frequency (less than one second).
+   * @return ticks in units of 10us, rounded to nearest. This will be UNITS_PER_SECOND
+   * if ticks is within half a unit of a full second.
+   */
+  uint32_t toUnits(uint64_t ticks) const
+  {
+    if(mUseMultiplier)
+    {
+      /* ticks < frequency < 2^32, so the 96 bit product only needs two 32x32 multiplies. */
+      uint32_t t = static_cast<uint32_t>(ticks);
+      uint64_t low = static_cast<uint64_t>(t) * mMultiplierLow;
+      uint64_t high = static_cast<uint64_t>(t) * mMultiplierHigh;
+      return static_cast<uint32_t>((high + (low >> 32) + 0x80000000u) >> 32); /* Add 0.5 to round */
+    }
+    return static_cast<uint32_t>((ticks * (2 * UNITS_PER_SECOND) + mFrequency) / (2 * mFrequency));
+  }
+
+  /**
+   * Splits a value in units of 10us (less than UNITS_PER_SECOND) into whole milliseconds and hundredths.
+   */
+  static void splitUnits(uint32_t units, unsigned int* outHigh, unsigned int* outLow)
+  {
+    /* units / 100 as a multiply and shift. Exact for all 32 bit values. */
+    unsigned int high = static_cast<unsigned int>((static_cast<uint64_t>(units) * 1374389535u) >> 37);
+    *outHigh = high;
+    *outLow = units - high * 100;
+  }
+
+  uint64_t getFrequency() const;
+
+  /**
+   * @return the reciprocal of the frequency, for converting tick counts to seconds with a multiply.
+   */
+  double getSecondsPerTick() const;
+
+protected:
+  uint64_t mFrequency;
+  double mSecondsPerTick;
+
+  bool mUseMultiplier;
+  /** The fractional part of UNITS_PER_SECOND / frequency as a 64.64 fixed-point value.
+      The integer part is always zero because the frequency is above UNITS_PER_SECOND. */
+  uint32_t mMultiplierHigh;
+  uint32_t mMultiplierLow;
+};
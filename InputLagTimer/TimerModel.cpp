@@ -1,250 +1,188 @@
-#include "stdafx.h"
 #include "TimerModel.h"
+#include "TimingSession.h"
+#include "AllocationTracker.h"
 #include "Config.h"
+#include "TelemetryRecorder.h"
+#include "TraceZones.h"
+
+/* A measured refresh period in seconds is held as a fraction of ticks with this denominator */
+#define MEASURED_PERIOD_DENOMINATOR 65536
+
+Model::Model(TimingSession* session, int slot, unsigned int refreshNumerator, unsigned int refreshDenominator)
+  :mSession(session),
+  mClock(session->getClock()),
+  mFrequency(mClock->getFrequency()),
+  mTickConverter(mFrequency),
+  mRefreshTicksNumerator(mFrequency * refreshDenominator),
+  mRefreshTicksDenominator(refreshNumerator),
+  mRefreshPhase(0),
+  mRefreshEstimator(static_cast<double>(mFrequency) * refreshDenominator / refreshNumerator),
+  mSecondStartCount(session->getStartingCount()),
+  mLastCount(session->getStartingCount()),
+  mColumn(0),
+  mTelemetry(NULL),
+  mOutputIndex(0),
+  mUpdateAllocationCount(0)
+{
+  const TimingSession::OutputTable& table = session->getTable();
+  mSecondsSinceEpoch = table.secondsSinceEpoch + slot;
+  mTimeValue = table.timeValues + slot;
+  mFrameTime = table.frameTimes + slot;
+  mRenderTime = table.renderTimes + slot;
+}
 
-Model::ErrorType Model::mCurrerntError = Model::ERROR_TYPE_NONE;
-bool Model::mIsCurrentErrorPermanent = false;
-
-double Model::mLastRenderTimeVariance = 0.0;
-double Model::mMaxRenderTimeVariance = 0.0;
-double Model::mDisplayRenderTimeVariance = 0.0;
-
-int Model::mFrameCount = 0;
-int Model::mFPS = 0;
-double Model::mPreviousTimeValue = 0;
-double Model::mFPSTime = 0;
 
-double Model::mLongestFrameTime = 0.0;
-double Model::mDisplayLongestFrameTime = 0.0;
+Model::~Model(void)
+{
+}
 
-double Model::mLastTimeValue = 0.0;
-double Model::mLastReportedErrorTime = 0.0;
+void Model::update()
+{
+  /* QUERY THE PERFORMANCE COUNTER!
+     The remaining of this function must be consistent between
+     models to ensure that the same latency to display occurs for
+     each output. */
+  update(mClock->getCount());
+}
 
-void Model::loopStarted(const std::vector<Model*>& models)
+void Model::update(uint64_t currentCount)
 {
-  /* Render time variance calculations and reporting */
-  auto renderTimeIter = models.begin();
-  double firstRenderTime = (*renderTimeIter)->mLastRenderTime;
-  double highRenderTime = firstRenderTime;
-  double lowRenderTime = firstRenderTime;
-  ++renderTimeIter;
-  while(renderTimeIter != models.end())
+  TRACE_ZONE("Model::update");
+  /* Counts are only ever subtracted, and unsigned subtraction is modular, so the deltas are
+     right even when the counter wraps around between the two counts. A count from before the
+     last one, which only a misbehaving counter gives, is treated as no time passing. */
+  if(static_cast<int64_t>(currentCount - mLastCount) < 0)
   {
-    double renderTime = (*renderTimeIter)->mLastRenderTime;
-    if(renderTime < lowRenderTime)
-    {
-      lowRenderTime = renderTime;
-    }
-    if(renderTime > highRenderTime)
-    {
-      highRenderTime = renderTime;
-    }
-    ++renderTimeIter;
+    currentCount = mLastCount;
   }
-  mLastRenderTimeVariance = highRenderTime - lowRenderTime;
-
-  if(mLastRenderTimeVariance > Config::highestRenderVariance)
+  mUpdateAllocationCount = AllocationTracker::getThreadAllocationCount();
+
+  /* Whole seconds are counted off by moving the start of the current second forward,
+     so only the ticks into the current second need converting. Every model starts from
+     the same count and steps by the same frequency, so they all agree on the second. */
+  uint64_t countSinceSecond = currentCount - mSecondStartCount;
+  uint32_t secondsSinceEpoch = *mSecondsSinceEpoch;
+  while(countSinceSecond >= mFrequency)
   {
-    Model::reportError(ERROR_TYPE_RENDER_TIME_VARIANCE_TOO_HIGH, false);
+    mSecondStartCount += mFrequency;
+    countSinceSecond -= mFrequency;
+    ++secondsSinceEpoch;
   }
+  *mSecondsSinceEpoch = secondsSinceEpoch;
 
-  if(mLastRenderTimeVariance > mMaxRenderTimeVariance)
-  {
-    mMaxRenderTimeVariance = mLastRenderTimeVariance;
-  }
+  double secondsPerTick = mTickConverter.getSecondsPerTick();
+  *mTimeValue = secondsSinceEpoch + countSinceSecond * secondsPerTick;
+  uint64_t countSinceLast = currentCount - mLastCount;
 
-  /* FrameTime reporting */
-  auto frameTimeIter = models.begin();
-  double firstFrameTime = (*frameTimeIter)->mLastFrameTime;
-  double longestFrameTime = firstFrameTime;
-  ++frameTimeIter;
-  while(frameTimeIter != models.end())
+  *mFrameTime = countSinceLast * secondsPerTick;
+
+  /* Timer Value */
+  uint32_t timerUnits = mTickConverter.toUnits(countSinceSecond);
+  if(timerUnits == TickConverter::UNITS_PER_SECOND)
   {
-    double frameTime = (*frameTimeIter)->mLastFrameTime;
-    if(frameTime > longestFrameTime)
-    {
-      longestFrameTime = frameTime;
-    }
-    ++frameTimeIter;
+    /* Rounded up to the next second */
+    timerUnits = 0;
   }
+  TickConverter::splitUnits(timerUnits, &mTimerValue.high, &mTimerValue.low); /* ms and sub-milliseconds */
 
-  if(longestFrameTime > Config::longestFrameTime)
+  /* Column & once-per-refresh stuff. The nominal rate is counted exactly, in fractions of a tick,
+     so that it does not drift from the rate the output was set to. */
+  mRefreshPhase += countSinceLast * mRefreshTicksDenominator;
+  if(mRefreshPhase >= mRefreshTicksNumerator)
   {
-    reportError(ERROR_TYPE_FRAME_TIME_TOO_LONG, false);
+    uint64_t refreshes = mRefreshPhase / mRefreshTicksNumerator;
+    mRefreshPhase -= refreshes * mRefreshTicksNumerator;
+    mColumn += static_cast<int>(refreshes % Config::numColumns);
   }
-
-  if(longestFrameTime > mLongestFrameTime)
+  if(mRefreshEstimator.isLocked())
   {
-    mLongestFrameTime = longestFrameTime;
+    /* The output's real vblanks drift from any nominal rate, so follow the ones the estimator predicts */
+    mColumn = static_cast<int>(mRefreshEstimator.getRefreshIndex(currentCount) % Config::numColumns);
   }
-
-  recordRecordValuesForHUD();
-  resetErrors();
-}
-
-void Model::loopComplete()
-{
-  ++mFrameCount;
-}
-
-void Model::reportError(Model::ErrorType error, bool isPermanent)
-{
-  if(!mIsCurrentErrorPermanent)
+  /* Checked every frame, because a config reload can lower the number of columns at any time */
+  if(mColumn > Config::numColumns - 1)
   {
-    mIsCurrentErrorPermanent = isPermanent;
-    mCurrerntError = error;
-    mLastReportedErrorTime = mLastTimeValue;
+    mColumn %= Config::numColumns;
   }
-}
 
-Model::ErrorType Model::getCurrentError()
-{
-  return mCurrerntError;
+  mLastCount = currentCount;
 }
 
-double Model::getFrameTime()
+void Model::renderComplete()
 {
-  return mDisplayLongestFrameTime;
-}
+  TRACE_ZONE("Model::renderComplete");
+  uint64_t currentCount = mClock->getCount();
 
-double Model::getRenderVariance()
-{
-  return mDisplayRenderTimeVariance;
-}
+  uint64_t renderCount = currentCount - mLastCount;
 
-int Model::getFPS()
-{
-  return mFPS;
-}
+  *mRenderTime = renderCount * mTickConverter.getSecondsPerTick();
 
-void Model::recordRecordValuesForHUD()
-{
-  mFPSTime += mLastTimeValue - mPreviousTimeValue;
-  
-  if(mFPSTime >= 1.0)
+  if(mTelemetry)
   {
-    mFPS = mFrameCount;
-    mFrameCount = 0;
-    mFPSTime -= 1.0;
-
-    mDisplayRenderTimeVariance = mMaxRenderTimeVariance;
-    mMaxRenderTimeVariance = 0.0;
-
-    mDisplayLongestFrameTime = mLongestFrameTime;
-    mLongestFrameTime = 0.0;
+    TelemetryRecord record;
+    record.startCount = mLastCount;
+    record.renderCompleteCount = currentCount;
+    record.frameIndex = mSession->getLoopCount();
+    record.outputIndex = static_cast<uint16_t>(mOutputIndex);
+    record.column = static_cast<uint8_t>(mColumn);
+    record.error = static_cast<uint8_t>(mSession->getCurrentError());
+    record.allocations = static_cast<uint32_t>(AllocationTracker::getThreadAllocationCount() - mUpdateAllocationCount);
+    mTelemetry->record(record);
   }
-
-  mPreviousTimeValue = mLastTimeValue;
 }
 
-void Model::resetErrors()
+void Model::setTelemetry(TelemetryRecorder* recorder, int outputIndex)
 {
-  double timeSinseLastError = mLastTimeValue - mLastReportedErrorTime;
-  /* Reset if it's been 0.5 seconds */
-  if(!mIsCurrentErrorPermanent && timeSinseLastError > 0.5)
-  {
-    mCurrerntError = ERROR_TYPE_NONE;
-  }
+  mTelemetry = recorder;
+  mOutputIndex = outputIndex;
 }
 
-Model::Model(LARGE_INTEGER startingCount, IDXGISwapChain* swapChain)
-  :mStartingCount(startingCount),
-  mLastCount(startingCount),
-  mLastRenderTime(0.0),
-  mColumn(0),
-  mLastFrameTime(0.0)
+Model::TimerValue Model::getTimerValue() const
 {
-  mCountsSinceRefresh.QuadPart = 0;
-
-  ZeroMemory(&mSwapChainDesc, sizeof(mSwapChainDesc));
-  swapChain->GetDesc(&mSwapChainDesc);
-
-  /* Refresh rate calculations */
-  LARGE_INTEGER performanceFrequency;
-  QueryPerformanceFrequency(&performanceFrequency);
-  mCountsPerRefresh.QuadPart = performanceFrequency.QuadPart * mSwapChainDesc.BufferDesc.RefreshRate.Denominator / mSwapChainDesc.BufferDesc.RefreshRate.Numerator;
+  return mTimerValue;
 }
 
-
-Model::~Model(void)
+int Model::getColumn() const
 {
+  return mColumn;
 }
 
-union uFloat
+Model::ErrorType Model::getCurrentError() const
 {
-  float value;
-  unsigned __int32 iValue;
-};
+  return mSession->getCurrentError();
+}
 
-void Model::update()
+TimingSession* Model::getSession() const
 {
-  LARGE_INTEGER performanceFrequency;
-  QueryPerformanceFrequency(&performanceFrequency);
-
-  /* QUERY THE PERFORMANCE COUNTER!
-     The remaining of this function must be consistent between
-     models to ensure that the same latency to display occurs for
-     each output. */
-  LARGE_INTEGER currentCount;
-  QueryPerformanceCounter(&currentCount);
-
-  if(currentCount.QuadPart < mStartingCount.QuadPart)
-  {
-    reportError(ERROR_TYPE_COUNTER_OVERFLOW, true);
-  }
-
-  LARGE_INTEGER countSinceStart, countSinceLast;
-  countSinceStart.QuadPart = currentCount.QuadPart - mStartingCount.QuadPart;
-  double secondsSinceStart = ((double)countSinceStart.QuadPart) / performanceFrequency.QuadPart;
-  mLastTimeValue = secondsSinceStart;
-  countSinceLast.QuadPart = currentCount.QuadPart - mLastCount.QuadPart;
-  double secondsSinceLast = ((double)countSinceLast.QuadPart) / performanceFrequency.QuadPart;
-
-  mLastFrameTime = secondsSinceLast;
+  return mSession;
+}
 
-  /* Timer Value */
-  ULONGLONG fullTimerValue = secondsSinceStart * 100000.0 + 0.5; /* Add 0.5 to round */
-  ULONGLONG trimmedHigh = (fullTimerValue / 100000) * 100000;
-  unsigned int iTimerValue = fullTimerValue - trimmedHigh;
-  mTimerValue.high = iTimerValue / 100; /* Convert to ms */
-  mTimerValue.low = iTimerValue - (mTimerValue.high * 100); /* Sub-milliseconds */
-
-  /* Column & once-per-refresh stuff */
-  mCountsSinceRefresh.QuadPart += countSinceLast.QuadPart;
-  if(mCountsSinceRefresh.QuadPart >= mCountsPerRefresh.QuadPart)
+uint64_t Model::getCountsPerRefresh() const
+{
+  if(mRefreshEstimator.isLocked())
   {
-    mCountsSinceRefresh.QuadPart -= mCountsPerRefresh.QuadPart;
-    mColumn++;
-    if(mColumn > Config::numColumns - 1)
-    {
-      mColumn = 0;
-    }
+    return static_cast<uint64_t>(mRefreshEstimator.getPeriod() + 0.5);
   }
-
-  mLastCount = currentCount;
+  return (mRefreshTicksNumerator + mRefreshTicksDenominator / 2) / mRefreshTicksDenominator;
 }
 
-void Model::renderComplete()
+void Model::setRefreshPeriod(double seconds)
 {
-  LARGE_INTEGER currentCount;
-  QueryPerformanceCounter(&currentCount);
-
-  LARGE_INTEGER renderCount;
-  renderCount.QuadPart = currentCount.QuadPart - mLastCount.QuadPart;
-
-  LARGE_INTEGER performanceFrequency;
-  QueryPerformanceFrequency(&performanceFrequency);
-
-  mLastRenderTime = ((double)renderCount.QuadPart) / performanceFrequency.QuadPart;
+  double period = seconds * mFrequency;
+  /* Keeps the time since the last refresh, in the new denominator */
+  mRefreshPhase = mRefreshPhase / mRefreshTicksDenominator * MEASURED_PERIOD_DENOMINATOR;
+  mRefreshTicksNumerator = static_cast<uint64_t>(period * MEASURED_PERIOD_DENOMINATOR + 0.5);
+  mRefreshTicksDenominator = MEASURED_PERIOD_DENOMINATOR;
+  mRefreshEstimator.reset(period);
 }
 
-Model::TimerValue Model::getTimerValue() const
+void Model::observeRefresh(uint32_t refreshCount, uint64_t count)
 {
-  return mTimerValue;
+  mRefreshEstimator.observe(refreshCount, count);
 }
 
-int Model::getColumn() const
+const RefreshEstimator& Model::getRefreshEstimator() const
 {
-  return mColumn;
+  return mRefreshEstimator;
 }
 
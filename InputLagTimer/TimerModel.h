@@ -1,6 +1,11 @@
 #pragma once
 
-#include <vector>
+#include "Clock.h"
+#include "TickConverter.h"
+#include "RefreshEstimator.h"
+
+class TelemetryRecorder;
+class TimingSession;
 
 class Model
 {
@@ -11,41 +16,41 @@ public:
     unsigned int low;
   };
 
+  /** Every error clears itself once it has not been reported for half a second */
   enum ErrorType
   {
-    ERROR_TYPE_NONE,
-    ERROR_TYPE_COUNTER_OVERFLOW, /* Program needs restart because the performance counter has no defined maximum and has wrapped around. */
-    ERROR_TYPE_RENDER_TIME_VARIANCE_TOO_HIGH,
-    ERROR_TYPE_FRAME_TIME_TOO_LONG
+    ERROR_TYPE_NONE = 0,
+    /* 1 was a permanent error for the counter wrapping around, which the timer now runs through.
+       It is left unused so that the errors in telemetry logs keep their values. */
+    ERROR_TYPE_RENDER_TIME_VARIANCE_TOO_HIGH = 2,
+    ERROR_TYPE_FRAME_TIME_TOO_LONG = 3
   };
 
-  static void loopStarted(const std::vector<Model*>& models);
-
-  static void loopComplete();
-
-  static void reportError(ErrorType error, bool isPermanent);
-
-  static ErrorType getCurrentError();
-
   /**
-   * @return The longest frame time reported over the last second.
+   * Models are made by their TimingSession, which they sample the clock of and write their timings to.
+   * @param slot the model's slot in the session's table.
+   * @param refreshNumerator the numerator of the output's refresh rate in Hz.
+   * @param refreshDenominator the denominator of the output's refresh rate in Hz.
    */
-  static double getFrameTime();
+  Model(TimingSession* session, int slot, unsigned int refreshNumerator, unsigned int refreshDenominator);
+  virtual ~Model(void);
 
   /**
-   * @return The maximum render time variance in seconds that has been reported over the last second.
+   * Samples the clock and updates the timer value, column and frame time.
    */
-  static double getRenderVariance();
+  void update();
 
   /**
-   * @return The frames counted over the last second.
+   * Every frame's timing will be pushed to recorder from renderComplete(). Pass NULL to stop recording.
+   * @param outputIndex identifies this model's output in the records.
    */
-  static int getFPS();
+  void setTelemetry(TelemetryRecorder* recorder, int outputIndex);
 
-  Model(LARGE_INTEGER startingCount, IDXGISwapChain* swapChain);
-  virtual ~Model(void);
-
-  void update();
+  /**
+   * Updates the timer value, column and frame time from a count that was sampled once
+   * for every output, so that all outputs show the same value for the frame.
+   */
+  void update(uint64_t currentCount);
   /**
    * Should be called directly after the buffer is flipped.
    * This function will calculate the render time for the last frame
@@ -64,43 +69,71 @@ public:
    */
   int getColumn() const;
 
+  /**
+   * @return the session's current error, which every output shows.
+   */
+  ErrorType getCurrentError() const;
+
+  TimingSession* getSession() const;
+
+  /**
+   * @return the refresh period of the output in counter ticks, which is how often the column advances.
+   * This is the refresh estimator's period once it has locked, and the nominal period before that.
+   */
+  uint64_t getCountsPerRefresh() const;
+
+  /**
+   * Advances the column at a measured refresh period instead of the nominal refresh rate,
+   * and starts the refresh estimator from it.
+   */
+  void setRefreshPeriod(double seconds);
+
+  /**
+   * Gives the refresh estimator a vblank the output reported. Once the estimator has locked on,
+   * the column advances at the vblanks it predicts rather than at the nominal refresh rate.
+   * Call from the thread that calls update().
+   * @param refreshCount the number of the refresh, as the swap chain counts them.
+   * @param count the counter value at which that refresh started.
+   */
+  void observeRefresh(uint32_t refreshCount, uint64_t count);
+
+  const RefreshEstimator& getRefreshEstimator() const;
+
 protected:
-  static void recordRecordValuesForHUD();
-  static void resetErrors();
-
-  static ErrorType mCurrerntError;
-  static bool mIsCurrentErrorPermanent;
-  
-  static double mLastRenderTimeVariance;
-  static double mMaxRenderTimeVariance;
-  static double mDisplayRenderTimeVariance;
-  
-  static int mFrameCount;
-  static int mFPS;
-  static double mPreviousTimeValue;
-  static double mFPSTime;
-  
-  static double mLongestFrameTime;
-  static double mDisplayLongestFrameTime;
-
-  /** In seconds. Timer models write to this for use in static error checking and update
-      functions so they do not need to make another queryPerofrmanceCounter call. */
-  static double mLastTimeValue;
-  static double mLastReportedErrorTime;
-
-  DXGI_SWAP_CHAIN_DESC mSwapChainDesc;
-  
-  LARGE_INTEGER mCountsPerRefresh;
-  LARGE_INTEGER mCountsSinceRefresh;
-
-  LARGE_INTEGER mStartingCount;
-  LARGE_INTEGER mLastCount;
+  TimingSession* mSession;
+  Clock* mClock;
+  uint64_t mFrequency;
+  TickConverter mTickConverter;
+
+  /** The refresh period is mRefreshTicksNumerator / mRefreshTicksDenominator ticks, kept as a fraction
+      so that the nominal rate is exact. mRefreshPhase is the ticks since the last refresh, times the denominator. */
+  uint64_t mRefreshTicksNumerator;
+  uint64_t mRefreshTicksDenominator;
+  uint64_t mRefreshPhase;
+  RefreshEstimator mRefreshEstimator;
+
+  /** The count at which the current whole second since the session epoch began.
+      Counts are only ever subtracted from each other, so they may wrap around. */
+  uint64_t mSecondStartCount;
+  uint64_t mLastCount;
   TimerValue mTimerValue;
 
   int mColumn;
 
-  double mLastRenderTime;
-  /** The last frame time in seconds */
-  double mLastFrameTime;
+  TelemetryRecorder* mTelemetry;
+  int mOutputIndex;
+  /** The thread's allocation count when update() sampled the counter, for the telemetry record */
+  uint64_t mUpdateAllocationCount;
+
+  /** This output's cells in the session's table: its whole seconds since the session epoch,
+      and its last timer value, frame time and render time in seconds */
+  uint32_t* mSecondsSinceEpoch;
+  double* mTimeValue;
+  double* mFrameTime;
+  double* mRenderTime;
+
+private:
+  Model(const Model&);
+  Model& operator=(const Model&);
 };
 
@@ -0,0 +1,73 @@
+#include "TimerReplay.h"
+#include "TimingSession.h"
+
+TimerReplay::Result TimerReplay::run(ReplayClock* clock, int outputCount, unsigned int refreshNumerator, unsigned int refreshDenominator,
+                                     std::vector<Sample>* outSamples)
+{
+  /* One writer, since every output is replayed on this thread */
+  std::vector<TimingSession::OutputSetting> outputs;
+  for(int i = 0; i < outputCount; ++i)
+  {
+    TimingSession::OutputSetting output;
+    output.refreshNumerator = refreshNumerator;
+    output.refreshDenominator = refreshDenominator;
+    output.writer = 0;
+    outputs.push_back(output);
+  }
+  TimingSession session(clock, clock->getCount(), outputs);
+
+  Clock* systemClock = Clock::getSystemClock();
+  Result result;
+  result.frames = 0;
+
+  uint64_t replayStart = systemClock->getCount();
+  while(!clock->isFinished())
+  {
+    session.loopStarted();
+    for(int i = 0; i < outputCount; ++i)
+    {
+      Model* model = session.getModel(i);
+      model->update();
+      model->renderComplete();
+      if(outSamples)
+      {
+        Sample sample;
+        sample.timerValue = model->getTimerValue();
+        sample.column = model->getColumn();
+        outSamples->push_back(sample);
+      }
+    }
+    session.loopComplete();
+    ++result.frames;
+  }
+  uint64_t replayEnd = systemClock->getCount();
+
+  result.seconds = ((double)(replayEnd - replayStart)) / systemClock->getFrequency();
+  result.nanosecondsPerFrame = result.frames > 0 ? result.seconds * 1000000000.0 / result.frames : 0.0;
+  return result;
+}
+
+std::vector<uint64_t> TimerReplay::generateTrace(uint64_t frequency, uint64_t startingCount, int outputCount,
+                                                 double frameSeconds, double renderSeconds, uint64_t frameCount)
+{
+  std::vector<uint64_t> trace;
+  trace.reserve(1 + frameCount * outputCount * 2);
+  trace.push_back(startingCount);
+
+  uint64_t frameCounts = static_cast<uint64_t>(frameSeconds * frequency + 0.5);
+  uint64_t renderCounts = static_cast<uint64_t>(renderSeconds * frequency + 0.5);
+  uint64_t frameStart = startingCount;
+  for(uint64_t frame = 0; frame < frameCount; ++frame)
+  {
+    /* Outputs render one after another, just like WindowManager::render() */
+    uint64_t count = frameStart;
+    for(int output = 0; output < outputCount; ++output)
+    {
+      trace.push_back(count);
+      count += renderCounts;
+      trace.push_back(count);
+    }
+    frameStart += frameCounts > count - frameStart ? frameCounts : count - frameStart;
+  }
+  return trace;
+}
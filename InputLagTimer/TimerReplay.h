@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Clock.h"
+#include "TimerModel.h"
+
+/**
+ * Drives a recorded counter trace through the timer, column and error logic
+ * of Model with no rendering, so that the per-frame cost of the model can be
+ * measured and its output reproduced off the target machine.
+ *
+ * A trace holds counts in the order the program samples them: the starting
+ * count, then for every frame and every output, the update() count followed
+ * by the renderComplete() count.
+ */
+class TimerReplay
+{
+public:
+  struct Result
+  {
+    uint64_t frames;
+    /** Wall time taken by the replay, measured on the system clock. */
+    double seconds;
+    double nanosecondsPerFrame;
+  };
+
+  /** What one output showed for one frame */
+  struct Sample
+  {
+    Model::TimerValue timerValue;
+    int column;
+  };
+
+  /**
+   * Replays the clock's trace through outputCount models until the trace runs out.
+   * @param outSamples if not NULL, every output's sample for every frame is appended to it,
+   * in the order the trace holds them. Recording them is counted in the replay's time.
+   */
+  static Result run(ReplayClock* clock, int outputCount, unsigned int refreshNumerator, unsigned int refreshDenominator,
+                    std::vector<Sample>* outSamples = NULL);
+
+  /**
+   * @return a synthetic trace of frameCount frames for outputCount outputs,
+   * where every output renders in renderSeconds and frames start every frameSeconds.
+   */
+  static std::vector<uint64_t> generateTrace(uint64_t frequency, uint64_t startingCount, int outputCount,
+                                             double frameSeconds, double renderSeconds, uint64_t frameCount);
+};
@@ -0,0 +1,201 @@
+#include "TimerTextRenderer.h"
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TIMER_TEXT_SSE 1
+#include <xmmintrin.h>
+#endif
+
+static_assert(sizeof(RenderBackend::SpriteVertex) * 4 == sizeof(float) * 4 * 9, "A quad of sprite vertices must be a whole number of SIMD vectors");
+
+TimerTextRenderer::TimerTextRenderer(const FontFace* font)
+  :mFont(font)
+{
+  float inverseWidth = font->getInverseTextureWidth();
+  float inverseHeight = font->getInverseTextureHeight();
+
+  /* The same corner order as SpriteBatch */
+  static const float corners[VERTICES_PER_QUAD][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+
+  const wchar_t characters[GLYPH_COUNT + 1] = L"0123456789.";
+  for(int i = 0; i < GLYPH_COUNT; ++i)
+  {
+    GlyphQuad& quad = mGlyphs[i];
+    memset(&quad, 0, sizeof(quad));
+
+    /* Falls back to the font's default character, as drawString would */
+    const FontFace::Glyph* glyph = font->findGlyph(characters[i]);
+    if(!glyph)
+    {
+      continue;
+    }
+
+    float width = static_cast<float>(glyph->Subrect.right - glyph->Subrect.left);
+    float height = static_cast<float>(glyph->Subrect.bottom - glyph->Subrect.top);
+    quad.valid = true;
+    quad.xOffset = glyph->XOffset;
+    quad.advance = width + glyph->XAdvance;
+    for(int corner = 0; corner < VERTICES_PER_QUAD; ++corner)
+    {
+      RenderBackend::SpriteVertex& vertex = quad.vertices[corner];
+      vertex.x = corners[corner][0] * width;
+      vertex.y = glyph->YOffset + corners[corner][1] * height;
+      vertex.u = (glyph->Subrect.left + corners[corner][0] * width) * inverseWidth;
+      vertex.v = (glyph->Subrect.top + corners[corner][1] * height) * inverseHeight;
+    }
+  }
+}
+
+TimerTextRenderer::~TimerTextRenderer(void)
+{
+}
+
+bool TimerTextRenderer::draw(RenderBackend* backend, const wchar_t* text, const Position* positions, size_t positionCount, const float colour[4])
+{
+  size_t length = wcslen(text);
+  if(length > MAX_LENGTH)
+  {
+    return false;
+  }
+  if(length == 0 || positionCount == 0)
+  {
+    return true;
+  }
+
+  /* Lay the string out once, with the same rules as FontFace::drawString, relative to the row's position */
+#if defined(TIMER_TEXT_SSE)
+  __m128 stringVectors[MAX_LENGTH * VECTORS_PER_QUAD];
+  float* stringQuads = reinterpret_cast<float*>(stringVectors);
+#else
+  float stringQuads[MAX_LENGTH * FLOATS_PER_QUAD];
+#endif
+  float x = 0.0f;
+  for(size_t i = 0; i < length; ++i)
+  {
+    const GlyphQuad* glyph = findGlyph(text[i]);
+    if(!glyph)
+    {
+      return false;
+    }
+
+    x += glyph->xOffset;
+    if(x < 0.0f)
+    {
+      x = 0.0f;
+    }
+
+    RenderBackend::SpriteVertex vertices[VERTICES_PER_QUAD];
+    for(int corner = 0; corner < VERTICES_PER_QUAD; ++corner)
+    {
+      vertices[corner] = glyph->vertices[corner];
+      vertices[corner].x += x;
+      vertices[corner].r = colour[0];
+      vertices[corner].g = colour[1];
+      vertices[corner].b = colour[2];
+      vertices[corner].a = colour[3];
+    }
+    memcpy(&stringQuads[i * FLOATS_PER_QUAD], vertices, sizeof(vertices));
+
+    x += glyph->advance;
+  }
+
+  /* Copy the string to every row. Batches can end part way through a row.
+     The writer only holds a pointer to the copy, so that std::function can hold it without allocating. */
+  StringCopy copy = { stringQuads, length, positions };
+  const StringCopy* copyPointer = &copy;
+  backend->drawSprites(mFont->getTexture(), length * positionCount, [copyPointer](RenderBackend::SpriteVertex* vertices, size_t firstSprite, size_t spriteCount)
+  {
+    copyRows(*copyPointer, vertices, firstSprite, spriteCount);
+  });
+  return true;
+}
+
+void TimerTextRenderer::copyRows(const StringCopy& copy, RenderBackend::SpriteVertex* vertices, size_t firstSprite, size_t spriteCount)
+{
+  float* destination = reinterpret_cast<float*>(vertices);
+#if defined(TIMER_TEXT_SSE)
+  /* A quad is 144 bytes, a whole number of vectors, so if the first quad is aligned then they all are.
+     D3D11 maps buffers 16 byte aligned, but other backends' memory might not be. */
+  bool aligned = (reinterpret_cast<uintptr_t>(destination) & 15) == 0;
+#endif
+  size_t row = firstSprite / copy.length;
+  size_t glyph = firstSprite % copy.length;
+  size_t written = 0;
+  while(written < spriteCount)
+  {
+    /* The row's position, lined up with the position of each of the quad's 4 vertices.
+       Every ninth float of a quad is a vertex's x, so they fall in different lanes of each vector. */
+    float rowX = copy.positions[row].x;
+    float rowY = copy.positions[row].y;
+    const float offsets[FLOATS_PER_QUAD] =
+    {
+      rowX, rowY, 0, 0,   0, 0, 0, 0,   0, rowX, rowY, 0,
+      0, 0, 0, 0,         0, 0, rowX, rowY,   0, 0, 0, 0,
+      0, 0, 0, rowX,      rowY, 0, 0, 0,     0, 0, 0, 0,
+    };
+
+#if defined(TIMER_TEXT_SSE)
+    __m128 offsetVectors[VECTORS_PER_QUAD];
+    for(int i = 0; i < VECTORS_PER_QUAD; ++i)
+    {
+      offsetVectors[i] = _mm_loadu_ps(offsets + i * 4);
+    }
+#endif
+
+    for(; glyph < copy.length && written < spriteCount; ++glyph, ++written)
+    {
+      const float* source = &copy.quads[glyph * FLOATS_PER_QUAD];
+#if defined(TIMER_TEXT_SSE)
+      /* The string's quads are always aligned, as draw() lays them out in vectors */
+      if(aligned)
+      {
+        for(int i = 0; i < VECTORS_PER_QUAD; ++i)
+        {
+          _mm_store_ps(destination + i * 4, _mm_add_ps(_mm_load_ps(source + i * 4), offsetVectors[i]));
+        }
+      }
+      else
+      {
+        for(int i = 0; i < VECTORS_PER_QUAD; ++i)
+        {
+          _mm_storeu_ps(destination + i * 4, _mm_add_ps(_mm_load_ps(source + i * 4), offsetVectors[i]));
+        }
+      }
+#else
+      for(int i = 0; i < FLOATS_PER_QUAD; ++i)
+      {
+        destination[i] = source[i] + offsets[i];
+      }
+#endif
+      destination += FLOATS_PER_QUAD;
+    }
+
+    ++row;
+    glyph = 0;
+  }
+}
+
+const FontFace* TimerTextRenderer::getFont() const
+{
+  return mFont;
+}
+
+const TimerTextRenderer::GlyphQuad* TimerTextRenderer::findGlyph(wchar_t character) const
+{
+  int index;
+  if(character >= L'0' && character <= L'9')
+  {
+    index = character - L'0';
+  }
+  else if(character == L'.')
+  {
+    index = GLYPH_COUNT - 1;
+  }
+  else
+  {
+    return NULL;
+  }
+  return mGlyphs[index].valid ? &mGlyphs[index] : NULL;
+}
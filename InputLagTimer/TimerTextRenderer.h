@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stddef.h>
+#include "FontFace.h"
+#include "RenderBackend.h"
+
+/**
+ * Draws a font's timer strings straight into the backend's vertex buffer.
+ * Timer strings only use the digits and '.', so the quad of each of those glyphs is worked out
+ * once. Each frame the string is laid out once from those quads, and then copied to every row
+ * with SIMD adds of the row's position, instead of laying out every glyph of every row.
+ *
+ * The vertices match what FontFace::drawString, and SpriteFont::DrawString, give for the same string.
+ */
+class TimerTextRenderer
+{
+public:
+  /** The longest string that can be drawn */
+  static const size_t MAX_LENGTH = 16;
+
+  /** The top left of a row's text */
+  struct Position
+  {
+    float x;
+    float y;
+  };
+
+  /**
+   * @param font is not owned, and must outlive this.
+   */
+  explicit TimerTextRenderer(const FontFace* font);
+  virtual ~TimerTextRenderer(void);
+
+  /**
+   * Draws the string at each position, which is the top left of the text as for FontFace::drawString.
+   * @param colour red, green, blue and alpha from 0 to 1.
+   * @return false, having drawn nothing, if the string is longer than MAX_LENGTH or has a character
+   * that is not a digit or '.', or that the font does not have.
+   */
+  bool draw(RenderBackend* backend, const wchar_t* text, const Position* positions, size_t positionCount, const float colour[4]);
+
+  const FontFace* getFont() const;
+
+protected:
+  static const int VERTICES_PER_QUAD = 4;
+  /** A quad is 4 vertices of 9 floats, which is exactly 9 SIMD vectors */
+  static const int VECTORS_PER_QUAD = 9;
+  static const int FLOATS_PER_QUAD = VECTORS_PER_QUAD * 4;
+  static const int GLYPH_COUNT = 11;
+
+  /**
+   * A glyph's quad, with the pen at x = 0 and the top of the line at y = 0.
+   */
+  struct GlyphQuad
+  {
+    bool valid;
+    float xOffset;
+    /** The glyph's width plus its XAdvance */
+    float advance;
+    RenderBackend::SpriteVertex vertices[VERTICES_PER_QUAD];
+  };
+
+  /** What draw() was asked to draw, laid out once for the backend's writer to copy */
+  struct StringCopy
+  {
+    const float* quads;
+    size_t length;
+    const Position* positions;
+  };
+
+  /** @return NULL if the character is not one that timer strings use, or the font does not have it. */
+  const GlyphQuad* findGlyph(wchar_t character) const;
+
+  /** Copies the string's quads for the sprites numbered firstSprite to firstSprite + spriteCount, a row at a time */
+  static void copyRows(const StringCopy& copy, RenderBackend::SpriteVertex* vertices, size_t firstSprite, size_t spriteCount);
+
+  const FontFace* mFont;
+  /** '0' to '9', then '.' */
+  GlyphQuad mGlyphs[GLYPH_COUNT];
+
+private:
+  TimerTextRenderer(const TimerTextRenderer&);
+  TimerTextRenderer& operator=(const TimerTextRenderer&);
+};
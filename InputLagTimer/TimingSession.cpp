@@ -0,0 +1,355 @@
+#include "TimingSession.h"
+#include "Config.h"
+#include "TraceZones.h"
+#include <algorithm>
+#include <limits>
+#include <new>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TIMING_SESSION_SSE2 1
+#endif
+
+/* SLOTS_PER_WRITER is the number of the narrowest column's slots that fill one of these */
+#define CACHE_LINE_SIZE 64
+
+static char* alignToCacheLine(char* address)
+{
+  uintptr_t aligned = (reinterpret_cast<uintptr_t>(address) + CACHE_LINE_SIZE - 1) & ~static_cast<uintptr_t>(CACHE_LINE_SIZE - 1);
+  return reinterpret_cast<char*>(aligned);
+}
+
+TimingSession::TimingSession(Clock* clock, uint64_t startingCount, const std::vector<OutputSetting>& outputs)
+  :mClock(clock),
+  mStartingCount(startingCount),
+  mCurrentError(Model::ERROR_TYPE_NONE),
+  mLastRenderTimeVariance(0.0),
+  mDisplayRenderTimeVariance(0.0),
+  mFrameCount(0),
+  mFPS(0),
+  mPreviousTimeValue(0.0),
+  mFPSTime(0.0),
+  mDisplayLongestFrameTime(0.0),
+  mPacingInterval(0.0),
+  mHUDGeneration(0),
+  mFrameTimeHistogram(HISTOGRAM_WINDOW_SECONDS),
+  mRenderTimeHistogram(HISTOGRAM_WINDOW_SECONDS),
+  mRenderVarianceHistogram(HISTOGRAM_WINDOW_SECONDS),
+  mLastTimeValue(0.0),
+  mLastReportedErrorTime(0.0),
+  mLoopCount(0)
+{
+  Percentiles none = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+  mFrameTimePercentiles = none;
+  mRenderTimePercentiles = none;
+  mRenderVariancePercentiles = none;
+
+  /* Each writer's outputs take the slots after the last writer's, starting from the next cache line */
+  std::vector<int> writers;
+  for(auto iter = outputs.begin(); iter != outputs.end(); ++iter)
+  {
+    if(std::find(writers.begin(), writers.end(), iter->writer) == writers.end())
+    {
+      writers.push_back(iter->writer);
+    }
+  }
+  mSlots.resize(outputs.size());
+  int slotCount = 0;
+  for(auto writerIter = writers.begin(); writerIter != writers.end(); ++writerIter)
+  {
+    for(size_t i = 0; i < outputs.size(); ++i)
+    {
+      if(outputs[i].writer == *writerIter)
+      {
+        mSlots[i] = slotCount++;
+      }
+    }
+    slotCount = (slotCount + SLOTS_PER_WRITER - 1) / SLOTS_PER_WRITER * SLOTS_PER_WRITER;
+  }
+
+  /* Every column's size is a multiple of the cache line, so each one starts on a boundary */
+  size_t doubleColumnSize = slotCount * sizeof(double);
+  mTableStorage.resize(doubleColumnSize * 4 + slotCount * sizeof(uint32_t) + CACHE_LINE_SIZE);
+  char* column = alignToCacheLine(&mTableStorage[0]);
+  mTable.renderTimes = reinterpret_cast<double*>(column);
+  mTable.frameTimes = reinterpret_cast<double*>(column + doubleColumnSize);
+  mTable.timeValues = reinterpret_cast<double*>(column + doubleColumnSize * 2);
+  mTable.emptyFill = reinterpret_cast<double*>(column + doubleColumnSize * 3);
+  mTable.secondsSinceEpoch = reinterpret_cast<uint32_t*>(column + doubleColumnSize * 4);
+  mTable.slotCount = slotCount;
+  for(int slot = 0; slot < slotCount; ++slot)
+  {
+    mTable.emptyFill[slot] = std::numeric_limits<double>::infinity();
+  }
+  for(auto iter = mSlots.begin(); iter != mSlots.end(); ++iter)
+  {
+    mTable.emptyFill[*iter] = 0.0;
+  }
+
+  /* The models are made in one block, each starting on a cache line of its own */
+  size_t modelSize = (sizeof(Model) + CACHE_LINE_SIZE - 1) & ~static_cast<size_t>(CACHE_LINE_SIZE - 1);
+  mModelStorage.resize(modelSize * outputs.size() + CACHE_LINE_SIZE);
+  char* model = alignToCacheLine(&mModelStorage[0]);
+  for(size_t i = 0; i < outputs.size(); ++i)
+  {
+    mModels.push_back(new (model + modelSize * i) Model(this, mSlots[i], outputs[i].refreshNumerator, outputs[i].refreshDenominator));
+  }
+}
+
+TimingSession::~TimingSession(void)
+{
+  for(auto iter = mModels.begin(); iter != mModels.end(); ++iter)
+  {
+    (*iter)->~Model();
+  }
+}
+
+int TimingSession::getOutputCount() const
+{
+  return static_cast<int>(mModels.size());
+}
+
+Model* TimingSession::getModel(int output)
+{
+  return mModels[output];
+}
+
+Clock* TimingSession::getClock() const
+{
+  return mClock;
+}
+
+uint64_t TimingSession::getStartingCount() const
+{
+  return mStartingCount;
+}
+
+const TimingSession::OutputTable& TimingSession::getTable() const
+{
+  return mTable;
+}
+
+void TimingSession::loopStarted()
+{
+  TRACE_ZONE("TimingSession::loopStarted");
+  if(mModels.empty())
+  {
+    return;
+  }
+  rebaseEpoch();
+  mLastTimeValue = findMax(mTable.timeValues, mTable.emptyFill, mTable.slotCount);
+
+  /* Render time variance calculations and reporting */
+  double lowRenderTime = 0.0;
+  double highRenderTime = 0.0;
+  findRange(mTable.renderTimes, mTable.emptyFill, mTable.slotCount, &lowRenderTime, &highRenderTime);
+  mLastRenderTimeVariance = highRenderTime - lowRenderTime;
+
+  if(mLastRenderTimeVariance > Config::highestRenderVariance)
+  {
+    reportError(Model::ERROR_TYPE_RENDER_TIME_VARIANCE_TOO_HIGH);
+  }
+
+  mRenderVarianceHistogram.record(toNanoseconds(mLastRenderTimeVariance));
+
+  /* FrameTime reporting */
+  double longestFrameTime = findMax(mTable.frameTimes, mTable.emptyFill, mTable.slotCount);
+  if(longestFrameTime - mPacingInterval > Config::longestFrameTime)
+  {
+    reportError(Model::ERROR_TYPE_FRAME_TIME_TOO_LONG);
+  }
+
+  for(auto iter = mSlots.begin(); iter != mSlots.end(); ++iter)
+  {
+    mRenderTimeHistogram.record(toNanoseconds(mTable.renderTimes[*iter]));
+    mFrameTimeHistogram.record(toNanoseconds(mTable.frameTimes[*iter]));
+  }
+
+  recordValuesForHUD();
+  resetErrors();
+}
+
+void TimingSession::loopComplete()
+{
+  ++mFrameCount;
+  ++mLoopCount;
+}
+
+void TimingSession::reportError(Model::ErrorType error)
+{
+  mCurrentError = error;
+  mLastReportedErrorTime = mLastTimeValue;
+}
+
+Model::ErrorType TimingSession::getCurrentError() const
+{
+  return mCurrentError;
+}
+
+double TimingSession::getFrameTime() const
+{
+  return mDisplayLongestFrameTime;
+}
+
+double TimingSession::getRenderVariance() const
+{
+  return mDisplayRenderTimeVariance;
+}
+
+int TimingSession::getFPS() const
+{
+  return mFPS;
+}
+
+const Percentiles& TimingSession::getFrameTimePercentiles() const
+{
+  return mFrameTimePercentiles;
+}
+
+const Percentiles& TimingSession::getRenderTimePercentiles() const
+{
+  return mRenderTimePercentiles;
+}
+
+const Percentiles& TimingSession::getRenderVariancePercentiles() const
+{
+  return mRenderVariancePercentiles;
+}
+
+uint32_t TimingSession::getHUDGeneration() const
+{
+  return mHUDGeneration;
+}
+
+uint32_t TimingSession::getLoopCount() const
+{
+  return mLoopCount;
+}
+
+void TimingSession::seedBaseline(const Percentiles& frameTime, const Percentiles& renderVariance)
+{
+  mFrameTimePercentiles = frameTime;
+  mRenderVariancePercentiles = renderVariance;
+  mDisplayLongestFrameTime = frameTime.max;
+  mDisplayRenderTimeVariance = renderVariance.max;
+  ++mHUDGeneration;
+}
+
+void TimingSession::setPacingInterval(double seconds)
+{
+  mPacingInterval = seconds;
+}
+
+uint64_t TimingSession::toNanoseconds(double seconds)
+{
+  return static_cast<uint64_t>(seconds * 1000000000.0 + 0.5);
+}
+
+void TimingSession::findRange(const double* column, const double* emptyFill, int count, double* outMin, double* outMax)
+{
+#if TIMING_SESSION_SSE2
+  /* Columns are aligned and count is even, so every load is an aligned pair of slots */
+  __m128d low = _mm_set1_pd(std::numeric_limits<double>::infinity());
+  __m128d high = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+  for(int i = 0; i < count; i += 2)
+  {
+    __m128d value = _mm_load_pd(column + i);
+    __m128d fill = _mm_load_pd(emptyFill + i);
+    low = _mm_min_pd(low, _mm_add_pd(value, fill));
+    high = _mm_max_pd(high, _mm_sub_pd(value, fill));
+  }
+  _mm_store_sd(outMin, _mm_min_sd(low, _mm_unpackhi_pd(low, low)));
+  _mm_store_sd(outMax, _mm_max_sd(high, _mm_unpackhi_pd(high, high)));
+#else
+  double low = std::numeric_limits<double>::infinity();
+  double high = -std::numeric_limits<double>::infinity();
+  for(int i = 0; i < count; ++i)
+  {
+    double lowValue = column[i] + emptyFill[i];
+    double highValue = column[i] - emptyFill[i];
+    low = lowValue < low ? lowValue : low;
+    high = highValue > high ? highValue : high;
+  }
+  *outMin = low;
+  *outMax = high;
+#endif
+}
+
+double TimingSession::findMax(const double* column, const double* emptyFill, int count)
+{
+#if TIMING_SESSION_SSE2
+  __m128d high = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+  for(int i = 0; i < count; i += 2)
+  {
+    high = _mm_max_pd(high, _mm_sub_pd(_mm_load_pd(column + i), _mm_load_pd(emptyFill + i)));
+  }
+  double result;
+  _mm_store_sd(&result, _mm_max_sd(high, _mm_unpackhi_pd(high, high)));
+  return result;
+#else
+  double high = -std::numeric_limits<double>::infinity();
+  for(int i = 0; i < count; ++i)
+  {
+    double value = column[i] - emptyFill[i];
+    high = value > high ? value : high;
+  }
+  return high;
+#endif
+}
+
+void TimingSession::recordValuesForHUD()
+{
+  mFPSTime += mLastTimeValue - mPreviousTimeValue;
+
+  if(mFPSTime >= 1.0)
+  {
+    mFPS = mFrameCount;
+    mFrameCount = 0;
+    mFPSTime -= 1.0;
+
+    mFrameTimeHistogram.advance();
+    mRenderTimeHistogram.advance();
+    mRenderVarianceHistogram.advance();
+
+    mDisplayRenderTimeVariance = mRenderVarianceHistogram.getLastWindow().getMax() / 1000000000.0;
+    mDisplayLongestFrameTime = mFrameTimeHistogram.getLastWindow().getMax() / 1000000000.0;
+
+    mFrameTimePercentiles.fromNanoseconds(mFrameTimeHistogram.getAllWindows());
+    mRenderTimePercentiles.fromNanoseconds(mRenderTimeHistogram.getAllWindows());
+    mRenderVariancePercentiles.fromNanoseconds(mRenderVarianceHistogram.getAllWindows());
+    ++mHUDGeneration;
+  }
+
+  mPreviousTimeValue = mLastTimeValue;
+}
+
+void TimingSession::rebaseEpoch()
+{
+  for(auto iter = mSlots.begin(); iter != mSlots.end(); ++iter)
+  {
+    if(mTable.secondsSinceEpoch[*iter] < EPOCH_REBASE_SECONDS)
+    {
+      return;
+    }
+  }
+
+  /* Nothing is rendering, so every model and every value measured from the epoch moves together */
+  for(auto iter = mSlots.begin(); iter != mSlots.end(); ++iter)
+  {
+    mTable.secondsSinceEpoch[*iter] -= EPOCH_REBASE_SECONDS;
+    mTable.timeValues[*iter] -= EPOCH_REBASE_SECONDS;
+  }
+  mLastTimeValue -= EPOCH_REBASE_SECONDS;
+  mPreviousTimeValue -= EPOCH_REBASE_SECONDS;
+  mLastReportedErrorTime -= EPOCH_REBASE_SECONDS;
+}
+
+void TimingSession::resetErrors()
+{
+  double timeSinceLastError = mLastTimeValue - mLastReportedErrorTime;
+  /* Reset if it's been 0.5 seconds */
+  if(timeSinceLastError > 0.5)
+  {
+    mCurrentError = Model::ERROR_TYPE_NONE;
+  }
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "Clock.h"
+#include "Histogram.h"
+#include "TimerModel.h"
+
+/**
+ * One run of the timer across all of its outputs: a Model for each output, a table of the
+ * per-output timings that are combined every loop, and the values combined from them that the
+ * failsafes and the HUD show. Nothing is static, so sessions are independent and can run at the same time.
+ *
+ * The table is a structure of arrays, with a column for each timing and a slot in every column for
+ * each output, so loopStarted() combines a timing across all outputs with SIMD instead of visiting
+ * each model. Outputs that are written by different threads are given slots on different cache lines,
+ * and every model is on cache lines of its own, so render threads never write to the same cache line.
+ */
+class TimingSession
+{
+public:
+  /** The span of time covered by the percentiles. */
+  static const int HISTOGRAM_WINDOW_SECONDS = 10;
+
+  /**
+   * The timer's seconds are counted from a session epoch that is moved forward by this many seconds,
+   * for every model at once, whenever every model has counted this far from it. The seconds that
+   * are converted to floating point every frame therefore stay small however long the timer runs.
+   */
+  static const uint32_t EPOCH_REBASE_SECONDS = 3600;
+
+  struct OutputSetting
+  {
+    /** The output's refresh rate in Hz, as a fraction */
+    unsigned int refreshNumerator;
+    unsigned int refreshDenominator;
+    /** Identifies the thread that renders the output. Outputs rendered by different threads must have different writers. */
+    int writer;
+  };
+
+  /**
+   * The per-output columns, each indexed by an output's slot and aligned to a cache line.
+   * Slots that no output has are left out of every combined value.
+   */
+  struct OutputTable
+  {
+    /** The time each output's last frame took to render and present, in seconds */
+    double* renderTimes;
+    /** The time between each output's last two frames, in seconds */
+    double* frameTimes;
+    /** Each output's last timer value, in seconds since the session epoch */
+    double* timeValues;
+    uint32_t* secondsSinceEpoch;
+    /** 0 for a slot with an output and infinity for an empty one. Adding it to a timing leaves an
+        empty slot out of a minimum, and subtracting it leaves one out of a maximum. */
+    double* emptyFill;
+    /** A multiple of SLOTS_PER_WRITER */
+    int slotCount;
+  };
+
+  /**
+   * @param clock the counter that the models sample.
+   * @param startingCount the count at which the timer reads zero, and the first session epoch.
+   * The counter may wrap around past 2^64 at any point after it.
+   * @param outputs one for each model, in the order getModel() gives them.
+   */
+  TimingSession(Clock* clock, uint64_t startingCount, const std::vector<OutputSetting>& outputs);
+  virtual ~TimingSession(void);
+
+  int getOutputCount() const;
+
+  /**
+   * @return the model of an output. Owned by the session.
+   */
+  Model* getModel(int output);
+
+  Clock* getClock() const;
+  uint64_t getStartingCount() const;
+
+  /**
+   * @return the columns that the models write their timings to.
+   */
+  const OutputTable& getTable() const;
+
+  /**
+   * Combines every output's timings from the last loop, and reports the errors that they
+   * call for. Called between frames, before any model is updated for the loop.
+   */
+  void loopStarted();
+
+  void loopComplete();
+
+  void reportError(Model::ErrorType error);
+
+  /** Every error clears itself once it has not been reported for half a second */
+  Model::ErrorType getCurrentError() const;
+
+  /**
+   * @return The longest frame time reported over the last second.
+   */
+  double getFrameTime() const;
+
+  /**
+   * @return The maximum render time variance in seconds that has been reported over the last second.
+   */
+  double getRenderVariance() const;
+
+  /**
+   * @return The frames counted over the last second.
+   */
+  int getFPS() const;
+
+  /**
+   * @return the distribution of every output's frame time over the last HISTOGRAM_WINDOW_SECONDS.
+   */
+  const Percentiles& getFrameTimePercentiles() const;
+
+  /**
+   * @return the distribution of every output's render time over the last HISTOGRAM_WINDOW_SECONDS.
+   */
+  const Percentiles& getRenderTimePercentiles() const;
+
+  /**
+   * @return the distribution of the render time variance between outputs over the last HISTOGRAM_WINDOW_SECONDS.
+   */
+  const Percentiles& getRenderVariancePercentiles() const;
+
+  /**
+   * @return a number that changes whenever any of the values above that the HUD shows change,
+   * which is at most once a second, so that the HUD is only laid out again when it would look different.
+   */
+  uint32_t getHUDGeneration() const;
+
+  /**
+   * @return the loops completed so far, so records from different outputs can be matched by frame.
+   */
+  uint32_t getLoopCount() const;
+
+  /**
+   * Shows the frame time and render variance from an earlier session on the HUD
+   * until the first second of this session has been measured.
+   */
+  void seedBaseline(const Percentiles& frameTime, const Percentiles& renderVariance);
+
+  /**
+   * The time that frames are deliberately held apart by frame pacing, which does not count
+   * towards the frame time failsafe. 0 when frames are not paced.
+   */
+  void setPacingInterval(double seconds);
+
+protected:
+  void recordValuesForHUD();
+  void resetErrors();
+
+  /**
+   * Moves the session epoch forward by EPOCH_REBASE_SECONDS for every model and every time value
+   * measured from it, once every model has passed that many seconds. Called between frames.
+   */
+  void rebaseEpoch();
+
+  static uint64_t toNanoseconds(double seconds);
+
+  /**
+   * Finds the smallest and largest timing in a column, leaving out the empty slots.
+   * @param count a multiple of SLOTS_PER_WRITER.
+   */
+  static void findRange(const double* column, const double* emptyFill, int count, double* outMin, double* outMax);
+
+  /**
+   * Finds the largest timing in a column, leaving out the empty slots.
+   * @param count a multiple of SLOTS_PER_WRITER.
+   */
+  static double findMax(const double* column, const double* emptyFill, int count);
+
+  /** Every writer's slots start on a multiple of this, so that no cache line of any column holds two writers' slots */
+  static const int SLOTS_PER_WRITER = 16;
+
+  Clock* mClock;
+  uint64_t mStartingCount;
+
+  /** The columns, and the models, are laid out in these, from the first cache line boundary in each */
+  std::vector<char> mTableStorage;
+  std::vector<char> mModelStorage;
+  OutputTable mTable;
+  /** Each output's slot in the table */
+  std::vector<int> mSlots;
+  std::vector<Model*> mModels;
+
+  Model::ErrorType mCurrentError;
+
+  double mLastRenderTimeVariance;
+  double mDisplayRenderTimeVariance;
+
+  int mFrameCount;
+  int mFPS;
+  double mPreviousTimeValue;
+  double mFPSTime;
+
+  double mDisplayLongestFrameTime;
+  double mPacingInterval;
+  uint32_t mHUDGeneration;
+
+  /** One window per second, recorded every frame. Fixed size, so recording never allocates. */
+  SlidingHistogram mFrameTimeHistogram;
+  SlidingHistogram mRenderTimeHistogram;
+  SlidingHistogram mRenderVarianceHistogram;
+  Percentiles mFrameTimePercentiles;
+  Percentiles mRenderTimePercentiles;
+  Percentiles mRenderVariancePercentiles;
+
+  /** In seconds since the session epoch. The latest of the outputs' timer values as of the last loop. */
+  double mLastTimeValue;
+  double mLastReportedErrorTime;
+
+  uint32_t mLoopCount;
+
+private:
+  TimingSession(const TimingSession&);
+  TimingSession& operator=(const TimingSession&);
+};
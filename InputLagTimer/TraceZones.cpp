@@ -0,0 +1,167 @@
+#include "TraceZones.h"
+#include <stdio.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Clock.h"
+
+#if defined(_MSC_VER)
+#pragma warning(disable : 4996)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+std::atomic<bool> TraceZones::recording(false);
+
+namespace
+{
+  struct Event
+  {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+  };
+
+  /**
+   * A registered thread's zones. Only the thread writes to it, and only while recording;
+   * everything else reads and resets it between traces.
+   */
+  struct ThreadBuffer
+  {
+    std::string name;
+    int id;
+    /** Allocated by the first trace that the thread is registered for */
+    std::unique_ptr<Event[]> events;
+    std::atomic<size_t> eventCount;
+    uint64_t droppedCount;
+  };
+
+  THREAD_LOCAL ThreadBuffer* threadBuffer = NULL;
+
+  std::mutex buffersMutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+  /* The timestamp counter and the system clock, read together at the start and end of the
+     last trace, to convert timestamps to time: the counter's frequency is not otherwise known */
+  uint64_t startTimestamp = 0;
+  uint64_t startCount = 0;
+  uint64_t stopTimestamp = 0;
+  uint64_t stopCount = 0;
+
+  void allocateEvents(ThreadBuffer* buffer)
+  {
+    if(!buffer->events)
+    {
+      buffer->events.reset(new Event[TraceZones::EVENTS_PER_THREAD]);
+    }
+    buffer->eventCount.store(0, std::memory_order_relaxed);
+    buffer->droppedCount = 0;
+  }
+}
+
+void TraceZones::registerThread(const char* name)
+{
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  ThreadBuffer* buffer = new ThreadBuffer();
+  buffer->name = name;
+  buffer->id = static_cast<int>(buffers.size()) + 1;
+  buffer->eventCount.store(0, std::memory_order_relaxed);
+  buffer->droppedCount = 0;
+  if(isRecording())
+  {
+    allocateEvents(buffer);
+  }
+  buffers.push_back(std::unique_ptr<ThreadBuffer>(buffer));
+  threadBuffer = buffer;
+}
+
+void TraceZones::start()
+{
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  for(auto iter = buffers.begin(); iter != buffers.end(); ++iter)
+  {
+    allocateEvents(iter->get());
+  }
+
+  Clock* clock = Clock::getSystemClock();
+  startCount = clock->getCount();
+  startTimestamp = readTimestamp();
+  /* Release, so that a thread that sees the trace recording also sees its buffer */
+  recording.store(true, std::memory_order_release);
+}
+
+void TraceZones::stop()
+{
+  recording.store(false, std::memory_order_relaxed);
+  stopCount = Clock::getSystemClock()->getCount();
+  stopTimestamp = readTimestamp();
+}
+
+void TraceZones::record(const char* name, uint64_t start, uint64_t end)
+{
+  ThreadBuffer* buffer = threadBuffer;
+  if(!buffer || !buffer->events)
+  {
+    return;
+  }
+  size_t index = buffer->eventCount.load(std::memory_order_relaxed);
+  if(index >= EVENTS_PER_THREAD)
+  {
+    ++buffer->droppedCount;
+    return;
+  }
+  Event& event = buffer->events[index];
+  event.name = name;
+  event.start = start;
+  event.end = end;
+  buffer->eventCount.store(index + 1, std::memory_order_release);
+}
+
+uint64_t TraceZones::getDroppedCount()
+{
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  uint64_t droppedCount = 0;
+  for(auto iter = buffers.begin(); iter != buffers.end(); ++iter)
+  {
+    droppedCount += (*iter)->droppedCount;
+  }
+  return droppedCount;
+}
+
+bool TraceZones::exportChromeTrace(const std::string& path)
+{
+  FILE* file = fopen(path.c_str(), "wb");
+  if(!file)
+  {
+    return false;
+  }
+
+  /* Microseconds, which is what the format's timestamps are in */
+  Clock* clock = Clock::getSystemClock();
+  double traceSeconds = static_cast<double>(stopCount - startCount) / clock->getFrequency();
+  double microsecondsPerTick = traceSeconds > 0.0 ? traceSeconds * 1000000.0 / (stopTimestamp - startTimestamp) : 0.0;
+
+  std::lock_guard<std::mutex> lock(buffersMutex);
+  fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  bool first = true;
+  for(auto iter = buffers.begin(); iter != buffers.end(); ++iter)
+  {
+    const ThreadBuffer* buffer = iter->get();
+    fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+      first ? "" : ",\n", buffer->id, buffer->name.c_str());
+    first = false;
+
+    size_t eventCount = buffer->eventCount.load(std::memory_order_acquire);
+    for(size_t i = 0; i < eventCount; ++i)
+    {
+      const Event& event = buffer->events[i];
+      fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+        event.name, buffer->id,
+        static_cast<int64_t>(event.start - startTimestamp) * microsecondsPerTick,
+        (event.end - event.start) * microsecondsPerTick);
+    }
+  }
+  fprintf(file, "\n]}\n");
+  return fclose(file) == 0;
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#define TRACE_ZONES_RDTSC 1
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#define TRACE_ZONES_RDTSC 1
+#else
+#include "Clock.h"
+#endif
+
+/* Define TRACE_ZONES as 0 for the build to compile every zone out */
+#if !defined(TRACE_ZONES)
+#define TRACE_ZONES 1
+#endif
+
+/**
+ * Named zones of the frame loop, timed while a trace is recording and exported as a Chrome trace,
+ * which chrome://tracing and ui.perfetto.dev both open.
+ *
+ * A zone is timed with the CPU's timestamp counter from its TRACE_ZONE() to the end of its scope,
+ * and recorded into a buffer that belongs to the thread, so recording takes no locks and never
+ * allocates. Only threads that have called registerThread() record zones, and a thread's buffer
+ * holds EVENTS_PER_THREAD zones per trace, after which zones are counted as dropped.
+ * While no trace is recording, a zone costs a load and a branch.
+ */
+class TraceZones
+{
+public:
+  static const size_t EVENTS_PER_THREAD = 65536;
+
+  /**
+   * Times a zone from construction to destruction, if a trace is recording when it is constructed.
+   */
+  class Zone
+  {
+  public:
+    /** @param name must be a string literal, and is written to the trace as it is. */
+    explicit Zone(const char* name)
+      :mName(NULL),
+      mStart(0)
+    {
+      if(isRecording())
+      {
+        mName = name;
+        mStart = readTimestamp();
+      }
+    }
+
+    ~Zone(void)
+    {
+      if(mName)
+      {
+        record(mName, mStart, readTimestamp());
+      }
+    }
+
+  private:
+    const char* mName;
+    uint64_t mStart;
+
+    Zone(const Zone&);
+    Zone& operator=(const Zone&);
+  };
+
+  /**
+   * Gives the calling thread a buffer to record zones into, named as the thread is in the trace.
+   * Called once by each thread whose zones should be traced, before it is timed.
+   */
+  static void registerThread(const char* name);
+
+  /**
+   * Discards the zones from any earlier trace and starts recording on every registered thread.
+   * Called between frames, while no zones are open.
+   */
+  static void start();
+
+  /**
+   * Stops recording. The zones stay in the buffers until the next start().
+   */
+  static void stop();
+
+  static bool isRecording()
+  {
+    return recording.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Writes the zones of the last trace, from every thread, as Chrome trace event JSON. Called after stop().
+   * @return false if the file could not be written.
+   */
+  static bool exportChromeTrace(const std::string& path);
+
+  /**
+   * @return the zones of the last trace that did not fit in their thread's buffer.
+   */
+  static uint64_t getDroppedCount();
+
+  static uint64_t readTimestamp()
+  {
+#if defined(TRACE_ZONES_RDTSC)
+    return __rdtsc();
+#else
+    return Clock::getSystemClock()->getCount();
+#endif
+  }
+
+protected:
+  static void record(const char* name, uint64_t start, uint64_t end);
+
+  static std::atomic<bool> recording;
+};
+
+#if TRACE_ZONES
+#define TRACE_ZONE_JOIN(a, b) a##b
+#define TRACE_ZONE_NAME(line) TRACE_ZONE_JOIN(traceZone, line)
+/** Times the rest of the enclosing scope as a zone */
+#define TRACE_ZONE(name) TraceZones::Zone TRACE_ZONE_NAME(__LINE__)(name)
+#else
+#define TRACE_ZONE(name)
+#endif
@@ -1,11 +1,15 @@
 #include "stdafx.h"
 #include "Window.h"
-#include <assert.h>
-#include "Config.h"
+#include <math.h>
 #include <stdio.h>
 
-#define TIMER_VALUE_PADDING 10
-#define COLUMN_SEPARATOR_WIDTH 15
+/* Frame statistics are sampled once every this many presents. Must be a power of two.
+   Often enough for the model's refresh estimator to lock on within a few seconds even when frames are paced. */
+#define FRAME_STATISTICS_INTERVAL 128
+/* Fewer vblanks than this are too few to measure the refresh period from */
+#define MIN_MEASURED_REFRESHES 600
+/* A profiled refresh period further than this fraction from the mode's refresh rate is not used */
+#define MAX_REFRESH_PERIOD_DEVIATION 0.01
 
 /* TODO: make these static class variables you dummie. >_> */
 TCHAR Window::windowClassName[] = _T("InputLagTimerWindowClassName");
@@ -38,6 +42,7 @@ LRESULT CALLBACK Window::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 {
   PAINTSTRUCT ps;
   HDC hdc;
+  Window* window;
 
   // TODO: Handle ESC key?
   switch (message)
@@ -51,6 +56,31 @@ LRESULT CALLBACK Window::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
     SetCursor(NULL);
     return true;
     break;
+  case WM_SIZE:
+    /* Only known once the swap chain has been created. Minimizing gives a size of 0, which no buffer can be. */
+    window = reinterpret_cast<Window*>(GetWindowLongPtr(hWnd, GWLP_USERDATA));
+    if(window && SIZE_MINIMIZED != wParam && LOWORD(lParam) > 0 && HIWORD(lParam) > 0)
+    {
+      WindowManager::RenderCommand command;
+      command.type = WindowManager::RenderCommand::TYPE_RESIZE;
+      command.window = window;
+      command.width = LOWORD(lParam);
+      command.height = HIWORD(lParam);
+      WindowManager::postCommand(command);
+    }
+    break;
+  case WM_KEYDOWN:
+    /* T starts and stops a trace of the frame loop. A held key repeats, which would toggle it again. */
+    if('T' == wParam && 0 == (lParam & (1 << 30)))
+    {
+      WindowManager::RenderCommand command;
+      command.type = WindowManager::RenderCommand::TYPE_TOGGLE_TRACE;
+      command.window = NULL;
+      command.width = 0;
+      command.height = 0;
+      WindowManager::postCommand(command);
+    }
+    break;
   case WM_DESTROY:
     PostQuitMessage(0);
     break;
@@ -75,14 +105,6 @@ UINT Window::getMaxHeight()
   return mMaxHeight;
 }
 
-struct InsensitiveCompare
-{ 
-  bool operator() (const std::wstring& a, const std::wstring& b) const
-  {
-    return _wcsnicmp(a.c_str(), b.c_str(), 100) < 0;
-  }
-};
-
 std::set<std::wstring, InsensitiveCompare>* Window::getFontPaths(const std::wstring& rootPath, bool* outError)
 {
   std::set<std::wstring, InsensitiveCompare>* result = new std::set<std::wstring, InsensitiveCompare>();
@@ -128,9 +150,12 @@ std::set<std::wstring, InsensitiveCompare>* Window::getFontPaths(const std::wstr
 }
 
 Window::Window(HINSTANCE hInstance, const Setup::OutputSetting& outputSettings, const WindowManager::Device& device)
-  :mModel(nullptr)
+  :mModel(nullptr),
+  mHasFirstFrameStatistics(false),
+  mPresentCount(0)
 {
   mBufferDesc = outputSettings.bufferDesc;
+  mProfileOutput = outputSettings.profileOutput;
   mDXGIOutput = outputSettings.output;
   mDXGIOutput->AddRef();
 
@@ -155,6 +180,7 @@ Window::Window(HINSTANCE hInstance, const Setup::OutputSetting& outputSettings,
     NULL,
     hInstance,
     NULL);
+  mWindowHandle = hWnd;
 
   // TODO: Could do something like this if I want, but I don't think it's necessary
   //if(windowCount == 1)
@@ -165,14 +191,6 @@ Window::Window(HINSTANCE hInstance, const Setup::OutputSetting& outputSettings,
   ShowWindow(hWnd, SW_SHOWNORMAL);
   UpdateWindow(hWnd);
 
-  /* Create the full-screen viewport */
-  mViewport.Width = mBufferDesc.Width;
-  mViewport.Height = mBufferDesc.Height;
-  mViewport.MinDepth = 0.0f;
-  mViewport.MaxDepth = 1.0f;
-  mViewport.TopLeftX = 0;
-  mViewport.TopLeftY = 0;
-  
   /* Create the Swap Chain */
   IDXGIDevice* dxgiDevice = NULL;
   device.d3DDevice->QueryInterface(IID_IDXGIDevice, (void**)&dxgiDevice);
@@ -214,37 +232,18 @@ Window::Window(HINSTANCE hInstance, const Setup::OutputSetting& outputSettings,
     mMaxHeight = swapChainDesc.BufferDesc.Height;
   }
 
-  /* DirectX Toolkit setup */
-  mSpriteBatch.reset( new DirectX::SpriteBatch( device.d3DDeviceConext ) );
-  
-  mPrimitiveBatch.reset(new DirectX::PrimitiveBatch<DirectX::VertexPositionColor>(device.d3DDeviceConext));
-  mBasicEffect.reset(new DirectX::BasicEffect(device.d3DDevice));
+  /* DirectX Toolkit setup. The fonts, effect and batches are shared by every window on the device. */
+  mDeviceResources = DeviceResources::getForDevice(device.d3DDevice);
+  mRenderBackend.reset(new D3D11RenderBackend(device.d3DDeviceConext,
+                                              mDeviceResources->getSpriteBatch(),
+                                              mDeviceResources->getPrimitiveBatch(),
+                                              mDeviceResources->getBasicEffect(),
+                                              mDeviceResources->getInputLayout()));
+  mRenderBackend->setTarget(mRenderTargetView, mSwapChain, mBufferDesc.Width, mBufferDesc.Height);
+  mOutputRenderer.reset(new OutputRenderer(mRenderBackend.get(), mDeviceResources->getTimerTextRenderers(), mDeviceResources->getNormalFont()));
 
-  mBasicEffect->SetProjection(DirectX::XMMatrixOrthographicOffCenterRH(0, mBufferDesc.Width, mBufferDesc.Height, 0, 0, 1));
-  mBasicEffect->SetVertexColorEnabled(true);
-
-  void const* shaderByteCode;
-  size_t byteCodeLength;
-  mBasicEffect->GetVertexShaderBytecode(&shaderByteCode, &byteCodeLength);
-  
-  device.d3DDevice->CreateInputLayout(DirectX::VertexPositionColor::InputElements,
-                            DirectX::VertexPositionColor::InputElementCount,
-                            shaderByteCode, byteCodeLength,
-                            &mInputLayout);
-
-  /* Load fonts */
-  std::wstring path = L"res/fonts/timer/";
-  bool error;
-  std::set<std::wstring, InsensitiveCompare>* fontPaths = getFontPaths(path.c_str(), &error);
-  for(auto iter = fontPaths->begin(); iter != fontPaths->end(); ++iter)
-  {
-    std::wstring fullPath = path;
-    fullPath.append(*iter);
-    DirectX::SpriteFont* spriteFont = new DirectX::SpriteFont( device.d3DDevice, fullPath.c_str() );
-    mSpriteFonts.push_back(spriteFont);
-  }
-  delete fontPaths;
-  mSpriteFontNormal = new DirectX::SpriteFont( device.d3DDevice, L"res/fonts/normal.spritefont" );
+  /* Let WndProc find this window, now that there is a swap chain for it to resize */
+  SetWindowLongPtr(hWnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
 
   /* Maybe I want this in the future? Texture loading: */
   //CreateDDSTextureFromFile( device.d3DDevice, L"seafloor.dds", nullptr, &g_pTextureRV1 );
@@ -253,19 +252,11 @@ Window::Window(HINSTANCE hInstance, const Setup::OutputSetting& outputSettings,
 
 Window::~Window(void)
 {
-  if(mModel)
-  {
-    delete mModel;
-  }
+  SetWindowLongPtr(mWindowHandle, GWLP_USERDATA, 0);
   mSwapChain->SetFullscreenState(FALSE, NULL);
   mSwapChain->Release();
   mRenderTargetView->Release();
   mDXGIOutput->Release();
-  for(auto iter = mSpriteFonts.begin(); iter != mSpriteFonts.end(); ++iter)
-  {
-    delete *iter;
-  }
-  delete mSpriteFontNormal;
   delete mWindowName;
 }
 
@@ -274,163 +265,96 @@ void Window::setFullscreen(BOOL fullscreen)
   mSwapChain->SetFullscreenState(fullscreen, mDXGIOutput);
 }
 
-void Window::initializeModel(const LARGE_INTEGER& startingCount, IDXGISwapChain* swapChain)
+void Window::resizeBuffers(const WindowManager::Device& device, UINT width, UINT height)
 {
-  mModel = new Model(startingCount, swapChain);
-}
+  if(width == mBufferDesc.Width && height == mBufferDesc.Height)
+  {
+    return;
+  }
 
-void Window::render(const WindowManager::Device& device)
-{
-  device.d3DDeviceConext->RSSetViewports(1, &mViewport);
-  device.d3DDeviceConext->OMSetRenderTargets(1, &mRenderTargetView, NULL);
+  /* Every reference to the back buffer must be released before it can be resized */
+  device.d3DDeviceConext->OMSetRenderTargets(0, NULL, NULL);
+  mRenderTargetView->Release();
+  mRenderTargetView = NULL;
 
-  device.d3DDeviceConext->ClearRenderTargetView( mRenderTargetView, Config::backgroundColour );
-  
-  mModel->update();
-  renderModel(mModel, device);
-  mSwapChain->Present( 0, 0 );
-  mModel->renderComplete();
+  HRESULT result = mSwapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, 0);
+  if(SUCCEEDED(result))
+  {
+    mBufferDesc.Width = width;
+    mBufferDesc.Height = height;
+    if(width > mMaxWidth)
+    {
+      mMaxWidth = width;
+    }
+    if(height > mMaxHeight)
+    {
+      mMaxHeight = height;
+    }
+  }
+  else
+  {
+    wchar_t report[128];
+    _snwprintf_s(report, 128, _TRUNCATE, L"Output %i: could not resize to %ux%u (0x%08x)\n", mWindowNumber, width, height, result);
+    OutputDebugString(report);
+  }
+
+  /* The old buffers are kept if resizing failed, so there is always a render target */
+  ID3D11Texture2D* backBuffer = NULL;
+  mSwapChain->GetBuffer(0, IID_ID3D11Texture2D, (void**)&backBuffer);
+  device.d3DDevice->CreateRenderTargetView(backBuffer, NULL, &mRenderTargetView);
+  backBuffer->Release();
+  mRenderBackend->setTarget(mRenderTargetView, mSwapChain, mBufferDesc.Width, mBufferDesc.Height);
 }
 
-void Window::renderModel(Model* model, const WindowManager::Device& device)
+DXGI_RATIONAL Window::getRefreshRate() const
 {
-  /* Generate strings */
-  Model::TimerValue timerValue = model->getTimerValue();
-  assert(timerValue.high < 1000 && timerValue.low < 100); /* Current design of display expects to always have less than a second */
-  wchar_t timerString[7];
-  swprintf_s(timerString, L"%03d.%02d", timerValue);
-
-  /* Render sprites */
-  // TODO: Determine which of deferred or immediate gives the least latency.
-  mSpriteBatch->Begin( DirectX::SpriteSortMode_Deferred );
-  auto fontIter = mSpriteFonts.begin();
-  unsigned int x = TIMER_VALUE_PADDING;
-  while(x < mMaxWidth && fontIter != mSpriteFonts.end())
-  {
-    int column = model->getColumn();
-    x = drawColumn(timerString, x, column, *fontIter);
+  DXGI_SWAP_CHAIN_DESC swapChainDesc;
+  ZeroMemory(&swapChainDesc, sizeof(swapChainDesc));
+  mSwapChain->GetDesc(&swapChainDesc);
+  return swapChainDesc.BufferDesc.RefreshRate;
+}
 
-    ++fontIter;
-  }
-  mSpriteBatch->End();
+void Window::setModel(Model* model)
+{
+  mModel = model;
 
-  drawHUD(device);
+  DXGI_RATIONAL refreshRate = getRefreshRate();
 
-  /* Render error if there is one */
-  Model::ErrorType currentError = mModel->getCurrentError();
-  if(Model::ERROR_TYPE_NONE != currentError)
+  /* Start from the refresh period that was measured last session, as long as it is for this refresh rate */
+  if(mProfileOutput.refreshPeriod > 0.0 && refreshRate.Numerator > 0)
   {
-    float ClearColor[4] = { 1.0, 0.0, 0.0, 1.0f };
-    device.d3DDeviceConext->ClearRenderTargetView( mRenderTargetView, ClearColor );
-    
-    mSpriteBatch->Begin( DirectX::SpriteSortMode_Deferred );
-    std::wstring errorMessage;
-    switch (currentError)
+    double nominalPeriod = static_cast<double>(refreshRate.Denominator) / refreshRate.Numerator;
+    if(fabs(mProfileOutput.refreshPeriod - nominalPeriod) < nominalPeriod * MAX_REFRESH_PERIOD_DEVIATION)
     {
-    case Model::ERROR_TYPE_NONE:
-      break;
-    case Model::ERROR_TYPE_COUNTER_OVERFLOW:
-      errorMessage = L"Performance counter has overflowed.\nPlease close and re-open this program.";
-      break;
-    case Model::ERROR_TYPE_RENDER_TIME_VARIANCE_TOO_HIGH:
-      errorMessage = L"Render time variance too high.\nWaiting for stability...";
-      break;
-    case Model::ERROR_TYPE_FRAME_TIME_TOO_LONG:
-      errorMessage = L"Timer frame time too long.\nWaiting for stability...";
-      break;
+      mModel->setRefreshPeriod(mProfileOutput.refreshPeriod);
     }
-    mSpriteFontNormal->DrawString( mSpriteBatch.get(), errorMessage.c_str(), DirectX::XMFLOAT2(10 , 10), DirectX::Colors::White);
-    mSpriteBatch->End();
   }
 }
 
-int Window::drawColumn(const wchar_t* timerString, int x, int column, DirectX::SpriteFont* font, bool drawHeader)
+void Window::render(const WindowManager::Device& device)
 {
-  unsigned int y = TIMER_VALUE_PADDING;
-  DirectX::XMVECTOR textSize = font->MeasureString(L"888.88");
-  int textWidth = static_cast<int>(ceilf(textSize.m128_f32[0])); // TODO: figure out how to access stuff via .x property. :S
-  int lineHeight = static_cast<int>(ceilf(textSize.m128_f32[1]));
-
-  /* Draw header */
-  if(drawHeader)
-  {
-    font->DrawString( mSpriteBatch.get(), L"12345.67890", DirectX::XMFLOAT2(static_cast<float>(x) , static_cast<float>(y)), Config::fontColour);
-    y += lineHeight + TIMER_VALUE_PADDING;
-  }
-  
-  /* Draw Timer Values */
-  int textX = x + (textWidth * column);
-  while(y < getMaxHeight())
-  {
-    font->DrawString( mSpriteBatch.get(), timerString, DirectX::XMFLOAT2(static_cast<float>(textX) , static_cast<float>(y)), Config::fontColour);
-    y += lineHeight + TIMER_VALUE_PADDING;
-  }
-  
-  /* Draw Column Separator */
-  int separatorX = x + (textWidth * Config::numColumns) + COLUMN_SEPARATOR_WIDTH;
+  mOutputRenderer->renderFrame(mModel, getOutput());
+  sampleFrameStatistics();
+}
 
-  return separatorX;
+void Window::render(const WindowManager::Device& device, uint64_t sharedCount)
+{
+  mOutputRenderer->renderFrame(mModel, getOutput(), sharedCount);
+  sampleFrameStatistics();
 }
 
-void Window::drawHUD(const WindowManager::Device& device)
+OutputRenderer::Output Window::getOutput() const
 {
-  wchar_t buffer[250];
-  /*
-  output1/2
-  1920x1080
-  59.97Hz
-
-  542FPS
-
-  frame
-  time(max)
-  5.23ms
-  error at
-  10.0ms
-
-  render
-  variance
-  2.45ms
-  error at
-  2.0ms
-
-  inputlag
-  .allenwp
-  .com
-
-  FUTURE:
-  time drift
-  0.00045ms/1ms
-  shortest
-  frame time
-  +/-0.01ms
-  */
-  _snwprintf_s(buffer, 250, L"output%d/%d\n%dx%d\n%.2fHz\n\n%dFPS\n\nframe\ntime(max)\n%.2fms\nerror at\n%.1fms\n\nrender\nvariance\n%.2fms\nerror at\n%.1fms\n\nv0.8.1\n\ninputlag\n.allenwp\n.com",
-    mWindowNumber, windowCount, mBufferDesc.Width, mBufferDesc.Height, static_cast<float>(mBufferDesc.RefreshRate.Numerator / mBufferDesc.RefreshRate.Denominator),
-    mModel->getFPS(),
-    static_cast<float>(mModel->getFrameTime() * 1000.0f), static_cast<float>(Config::longestFrameTime * 1000.0f),
-    static_cast<float>(mModel->getRenderVariance() * 1000.0f), static_cast<float>(Config::highestRenderVariance * 1000.0f));
-  DirectX::XMVECTOR textSize = mSpriteFontNormal->MeasureString(buffer);
-
-  mBasicEffect->Apply(device.d3DDeviceConext);
-  device.d3DDeviceConext->IASetInputLayout(mInputLayout);
-
-  float left = mBufferDesc.Width - textSize.m128_f32[0];
-  float right = mBufferDesc.Width;
-  float top = 0.0f;
-  float bottom = textSize.m128_f32[1];
-  DirectX::VertexPositionColor v1(DirectX::XMFLOAT3(left, top, 0.0), DirectX::XMFLOAT4(0.0,0.0,0.0,1.0));
-  DirectX::VertexPositionColor v2(DirectX::XMFLOAT3(right, top, 0.0), DirectX::XMFLOAT4(0.0,0.0,0.0,1.0));
-  DirectX::VertexPositionColor v3(DirectX::XMFLOAT3(right, bottom, 0.0), DirectX::XMFLOAT4(0.0,0.0,0.0,1.0));
-  DirectX::VertexPositionColor v4(DirectX::XMFLOAT3(left, bottom, 0.0), DirectX::XMFLOAT4(0.0,0.0,0.0,1.0));
-
-  mPrimitiveBatch->Begin();
-  mPrimitiveBatch->DrawQuad(v1, v2, v3, v4);
-  mPrimitiveBatch->End();
-
-  mSpriteBatch->Begin( DirectX::SpriteSortMode_Deferred );
-  mSpriteFontNormal->DrawString( mSpriteBatch.get(), buffer, DirectX::XMFLOAT2(left , top), DirectX::Colors::White);
-  mSpriteBatch->End();
+  OutputRenderer::Output output;
+  output.number = mWindowNumber;
+  output.count = windowCount;
+  output.width = mBufferDesc.Width;
+  output.height = mBufferDesc.Height;
+  output.refreshNumerator = mBufferDesc.RefreshRate.Numerator;
+  output.refreshDenominator = mBufferDesc.RefreshRate.Denominator;
+  output.layoutWidth = mMaxWidth;
+  output.layoutHeight = mMaxHeight;
+  return output;
 }
 
 IDXGISwapChain* Window::getSwapChain()
@@ -442,3 +366,54 @@ Model* Window::getModel()
 {
   return mModel;
 }
+
+DisplayProfileOutputRecord Window::getProfileOutput(Clock* clock)
+{
+  DisplayProfileOutputRecord result = mProfileOutput;
+  double refreshPeriod = measureRefreshPeriod(clock);
+  if(refreshPeriod > 0.0)
+  {
+    result.refreshPeriod = refreshPeriod;
+  }
+  return result;
+}
+
+void Window::sampleFrameStatistics()
+{
+  /* Statistics are only available once the output is fullscreen */
+  if(!mHasFirstFrameStatistics)
+  {
+    mHasFirstFrameStatistics = SUCCEEDED(mSwapChain->GetFrameStatistics(&mFirstFrameStatistics));
+    mLastFrameStatistics = mFirstFrameStatistics;
+    if(mHasFirstFrameStatistics)
+    {
+      mModel->observeRefresh(mFirstFrameStatistics.SyncRefreshCount, mFirstFrameStatistics.SyncQPCTime.QuadPart);
+    }
+  }
+  else if((++mPresentCount & (FRAME_STATISTICS_INTERVAL - 1)) == 0)
+  {
+    DXGI_FRAME_STATISTICS frameStatistics;
+    if(SUCCEEDED(mSwapChain->GetFrameStatistics(&frameStatistics)))
+    {
+      mLastFrameStatistics = frameStatistics;
+      mModel->observeRefresh(frameStatistics.SyncRefreshCount, frameStatistics.SyncQPCTime.QuadPart);
+    }
+  }
+}
+
+double Window::measureRefreshPeriod(Clock* clock) const
+{
+  if(!mHasFirstFrameStatistics)
+  {
+    return 0.0;
+  }
+
+  /* SyncQPCTime is a QueryPerformanceCounter value, which is what the system clock counts */
+  UINT refreshes = mLastFrameStatistics.SyncRefreshCount - mFirstFrameStatistics.SyncRefreshCount;
+  if(refreshes < MIN_MEASURED_REFRESHES)
+  {
+    return 0.0;
+  }
+  uint64_t counts = mLastFrameStatistics.SyncQPCTime.QuadPart - mFirstFrameStatistics.SyncQPCTime.QuadPart;
+  return static_cast<double>(counts) / clock->getFrequency() / refreshes;
+}
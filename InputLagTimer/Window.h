@@ -2,16 +2,20 @@
 #include "Setup.h"
 #include "WindowManager.h"
 #include "TimerModel.h"
+#include "DeviceResources.h"
+#include "D3D11RenderBackend.h"
+#include "OutputRenderer.h"
 #include <memory>
 #include <set>
+#include <string>
 
-#include "SpriteBatch.h"
-#include "SpriteFont.h"
-#include "PrimitiveBatch.h"
-#include "VertexTypes.h"
-#include "Effects.h"
-
-struct InsensitiveCompare;
+struct InsensitiveCompare
+{ 
+  bool operator() (const std::wstring& a, const std::wstring& b) const
+  {
+    return _wcsnicmp(a.c_str(), b.c_str(), 100) < 0;
+  }
+};
 
 class Window
 {
@@ -31,25 +35,57 @@ public:
   virtual ~Window(void);
 
   void setFullscreen(BOOL fullscreen);
-  void initializeModel(const LARGE_INTEGER& startingCount, IDXGISwapChain* swapChain);
+
+  /**
+   * Resizes the swap chain's buffers, if they are not already the size given. Called from
+   * WindowManager::render() between frames, for the resize commands queued by WndProc.
+   */
+  void resizeBuffers(const WindowManager::Device& device, UINT width, UINT height);
+
+  /**
+   * @return the refresh rate of the swap chain's display mode.
+   */
+  DXGI_RATIONAL getRefreshRate() const;
+
+  /**
+   * Gives the window the model of its output, and starts the model from the refresh period
+   * measured last session if there is one. The model belongs to the WindowManager's timing session.
+   */
+  void setModel(Model* model);
+
   void render(const WindowManager::Device& device);
 
+  /**
+   * Renders the output using a counter value that was sampled once for all outputs.
+   */
+  void render(const WindowManager::Device& device, uint64_t sharedCount);
+
   IDXGISwapChain* getSwapChain();
   Model* getModel();
 
+  /**
+   * @return the output's display profile record, with the refresh period measured over this
+   * session if the output has been fullscreen long enough to measure it.
+   */
+  DisplayProfileOutputRecord getProfileOutput(Clock* clock);
+
 protected:
-  void renderModel(Model* model, const WindowManager::Device& device);
+  /**
+   * @return what the output renderer needs to know about this window for the frame.
+   */
+  OutputRenderer::Output getOutput() const;
 
   /**
-   * @return the new x coordinate of the right of the column that was just drawn
-   * @param drawHeader will draw "12345.67890" as reference digits at the top of the column.
-   * The header was an old feature that was designed to help reability, but after the discovery
-   * of varaible latancy displays, it was decided that the header would take away from otherwise
-   * important values at the top of the column.
+   * Samples the swap chain's frame statistics every so often, for measuring the refresh period
+   * and for the model to lock its columns on to the vblanks.
    */
-  int drawColumn(const wchar_t* timerString, int x, int column, DirectX::SpriteFont* font, bool drawHeader = false);
+  void sampleFrameStatistics();
 
-  void drawHUD(const WindowManager::Device& device);
+  /**
+   * @return the seconds between vblanks from the first to the last frame statistics sampled,
+   * or 0 if fewer than MIN_MEASURED_REFRESHES were between them.
+   */
+  double measureRefreshPeriod(Clock* clock) const;
 
   static TCHAR windowClassName[];
   static int windowCount;
@@ -58,18 +94,23 @@ protected:
 
   DXGI_MODE_DESC mBufferDesc;
   TCHAR* mWindowName;
+  HWND mWindowHandle;
   int mWindowNumber;
   IDXGIOutput* mDXGIOutput;
-  D3D11_VIEWPORT mViewport;
   IDXGISwapChain* mSwapChain;
   ID3D11RenderTargetView* mRenderTargetView;
+  /** Not owned */
   Model* mModel;
+  DisplayProfileOutputRecord mProfileOutput;
+  /** The first and latest frame statistics that the swap chain gave, which the refresh period is measured between.
+      Sampled while running, because the swap chain has left fullscreen by the time the window is closed. */
+  DXGI_FRAME_STATISTICS mFirstFrameStatistics;
+  DXGI_FRAME_STATISTICS mLastFrameStatistics;
+  bool mHasFirstFrameStatistics;
+  unsigned int mPresentCount;
 
-  std::unique_ptr<DirectX::SpriteBatch> mSpriteBatch;
-  std::vector<DirectX::SpriteFont*> mSpriteFonts;
-  DirectX::SpriteFont* mSpriteFontNormal;
-
-  std::unique_ptr<DirectX::PrimitiveBatch<DirectX::VertexPositionColor>> mPrimitiveBatch;
-  std::unique_ptr<DirectX::BasicEffect> mBasicEffect;
-  ID3D11InputLayout* mInputLayout;
+  /** Shared with the other windows on this device */
+  std::shared_ptr<DeviceResources> mDeviceResources;
+  std::unique_ptr<D3D11RenderBackend> mRenderBackend;
+  std::unique_ptr<OutputRenderer> mOutputRenderer;
 };
@@ -1,11 +1,22 @@
 #include "stdafx.h"
 #include "WindowManager.h"
 #include "Window.h"
+#include "TimingSession.h"
+#include "DeviceResources.h"
+#include "Config.h"
+#include "TraceZones.h"
+#include <stdio.h>
 
-WindowManager::WindowManager(const Setup::Settings& settings, HINSTANCE hInstance)
+SpscRing<WindowManager::RenderCommand, 64> WindowManager::commandQueue;
+int WindowManager::droppedCommandCount = 0;
+
+WindowManager::WindowManager(const Setup::Settings& settings, HINSTANCE hInstance, FontLoader* fontLoader, StartupProfile* startupProfile, DisplayProfile* displayProfile)
+  :mDisplayProfile(displayProfile)
 {
   Window::registerWindow(hInstance);
 
+  /* Create every device before any window, so the fonts have as long as possible to finish parsing */
+  std::vector<std::pair<Device, const Setup::AdapterSetting*>> devices;
   for(auto iter = settings.adapterSettings.begin(); iter != settings.adapterSettings.end(); ++iter)
   {
     Device device;
@@ -38,16 +49,32 @@ WindowManager::WindowManager(const Setup::Settings& settings, HINSTANCE hInstanc
     {
       mReferencedObj.insert(device.d3DDevice);
       mReferencedObj.insert(device.d3DDeviceConext);
-      for(auto outputIter = iter->outputSettings.begin(); outputIter != iter->outputSettings.end(); ++outputIter)
-      {
-        Window* window = new Window(hInstance, *outputIter, device);
-        DeviceWindowPair pair;
-        pair.device = device;
-        pair.window = window;
-        mWindows.push_back(pair);
-      }
+      devices.push_back(std::make_pair(device, &*iter));
+    }
+  }
+  startupProfile->endPhase(L"devices");
+
+  DeviceResources::setFontLoader(fontLoader);
+  for(auto iter = devices.begin(); iter != devices.end(); ++iter)
+  {
+    const Setup::AdapterSetting* adapterSetting = iter->second;
+    for(auto outputIter = adapterSetting->outputSettings.begin(); outputIter != adapterSetting->outputSettings.end(); ++outputIter)
+    {
+      Window* window = new Window(hInstance, *outputIter, iter->first);
+      DeviceWindowPair pair;
+      pair.device = iter->first;
+      pair.window = window;
+      mWindows.push_back(pair);
     }
   }
+  DeviceResources::setFontLoader(nullptr);
+  startupProfile->endPhase(L"windows");
+
+  wchar_t report[160];
+  _snwprintf_s(report, 160, L"Device resources: created for %d devices, reused by %d windows, saving %.2fMB of fonts and %.1fms of startup\n",
+    DeviceResources::getCreatedCount(), DeviceResources::getReusedCount(),
+    DeviceResources::getSavedBytes() / (1024.0 * 1024.0), DeviceResources::getSavedSeconds() * 1000.0);
+  OutputDebugString(report);
 
   /* Go fullscreen after creating swap chains.
      http://msdn.microsoft.com/en-us/library/windows/desktop/ee417025(v=vs.85).aspx#multiple_monitors */
@@ -55,17 +82,109 @@ WindowManager::WindowManager(const Setup::Settings& settings, HINSTANCE hInstanc
   {
     iter->window->setFullscreen(true);
   }
+  startupProfile->endPhase(L"fullscreen");
 
-  LARGE_INTEGER startingCount;
-  QueryPerformanceCounter(&startingCount);
+  /* With a render thread per device, each device's outputs are written by its own thread */
+  std::vector<TimingSession::OutputSetting> outputs;
+  std::map<ID3D11Device*, int> writers;
   for(auto iter = mWindows.begin(); iter != mWindows.end(); ++iter)
   {
-    iter->window->initializeModel(startingCount, iter->window->getSwapChain());
+    DXGI_RATIONAL refreshRate = iter->window->getRefreshRate();
+    TimingSession::OutputSetting output;
+    output.refreshNumerator = refreshRate.Numerator;
+    output.refreshDenominator = refreshRate.Denominator;
+    output.writer = 0;
+    if(Config::renderThreadPerDevice)
+    {
+      output.writer = writers.insert(std::make_pair(iter->device.d3DDevice, static_cast<int>(writers.size()))).first->second;
+    }
+    outputs.push_back(output);
+  }
+  Clock* clock = Clock::getSystemClock();
+  uint64_t startingCount = clock->getCount();
+  mSession.reset(new TimingSession(clock, startingCount, outputs));
+  mFrameLoop.reset(new FrameLoop(mSession.get(), this));
+  for(size_t i = 0; i < mWindows.size(); ++i)
+  {
+    mWindows[i].window->setModel(mSession->getModel(static_cast<int>(i)));
+  }
+
+  /* Start from what the last session measured rather than waiting for it to be measured again */
+  if(mDisplayProfile && mDisplayProfile->hasBaseline())
+  {
+    Config::applyBaseline(mDisplayProfile->getFrameTime().p99, mDisplayProfile->getRenderVariance().p99);
+    mSession->seedBaseline(mDisplayProfile->getFrameTime(), mDisplayProfile->getRenderVariance());
+  }
+  else
+  {
+    Config::applyBaseline(0.0, 0.0);
+  }
+
+  if(Config::telemetryEnabled)
+  {
+    std::vector<uint64_t> countsPerRefresh;
+    for(auto iter = mWindows.begin(); iter != mWindows.end(); ++iter)
+    {
+      countsPerRefresh.push_back(iter->window->getModel()->getCountsPerRefresh());
+    }
+    mTelemetry.reset(new TelemetryRecorder(Config::telemetryPath, clock->getFrequency(), startingCount, countsPerRefresh));
+    for(size_t i = 0; i < mWindows.size(); ++i)
+    {
+      mWindows[i].window->getModel()->setTelemetry(mTelemetry.get(), static_cast<int>(i));
+    }
+  }
+
+  if(Config::renderThreadPerDevice)
+  {
+    createFrameScheduler(clock);
   }
+  startupProfile->endPhase(L"models");
 }
 
 WindowManager::~WindowManager(void)
 {
+  if(TraceZones::isRecording())
+  {
+    toggleTrace();
+  }
+
+  if(mFrameScheduler)
+  {
+    wchar_t report[128];
+    _snwprintf_s(report, 128, L"Frame scheduler: %.4fms max release spread over %llu frames\n",
+      mFrameScheduler->getMaxReleaseSpread() * 1000.0, (unsigned long long)mFrameScheduler->getFrameCount());
+    OutputDebugString(report);
+    /* Join the render threads before anything they use is released */
+    mFrameScheduler.reset();
+  }
+
+  double msPerCount = 1000.0 / Clock::getSystemClock()->getFrequency();
+  for(size_t i = 0; i < mWindows.size(); ++i)
+  {
+    const RefreshEstimator& estimator = mWindows[i].window->getModel()->getRefreshEstimator();
+    wchar_t report[192];
+    _snwprintf_s(report, 192, _TRUNCATE,
+      L"Refresh estimator: output %d %s, period %.5fms, last error %.1fus, %llu observations, %llu rejected, %d resyncs\n",
+      static_cast<int>(i), estimator.isLocked() ? L"locked" : L"not locked", estimator.getPeriod() * msPerCount,
+      estimator.getLastError() * msPerCount * 1000.0, (unsigned long long)estimator.getObservationCount(),
+      (unsigned long long)estimator.getRejectedCount(), estimator.getResyncCount());
+    OutputDebugString(report);
+  }
+
+  if(mTelemetry)
+  {
+    wchar_t report[128];
+    _snwprintf_s(report, 128, L"Telemetry: %llu records dropped\n", (unsigned long long)mTelemetry->getDroppedCount());
+    OutputDebugString(report);
+    /* Flushes the remaining records */
+    mTelemetry.reset();
+  }
+
+  if(mDisplayProfile)
+  {
+    saveDisplayProfile();
+  }
+
   for(auto iter = mReferencedObj.begin(); iter != mReferencedObj.end(); ++iter)
   {
     (*iter)->Release();
@@ -77,17 +196,147 @@ WindowManager::~WindowManager(void)
   }
 }
 
-void WindowManager::render()
+void WindowManager::saveDisplayProfile()
 {
-  std::vector<Model*> models;
+  Clock* clock = Clock::getSystemClock();
   for(auto iter = mWindows.begin(); iter != mWindows.end(); ++iter)
   {
-    models.push_back(iter->window->getModel());
+    mDisplayProfile->setOutput(iter->window->getProfileOutput(clock));
+  }
+
+  /* Only a session that ran long enough to fill the percentiles replaces the baseline */
+  if(mSession->getFrameTimePercentiles().max > 0.0)
+  {
+    mDisplayProfile->setBaseline(mSession->getFrameTimePercentiles(), mSession->getRenderVariancePercentiles());
+  }
+
+  if(!mDisplayProfile->save(Config::profilePath))
+  {
+    OutputDebugString(L"Display profile: could not be saved\n");
   }
-  Model::loopStarted(models);
+}
+
+void WindowManager::createFrameScheduler(Clock* clock)
+{
+  std::map<ID3D11Device*, std::vector<DeviceWindowPair>> windowsByDevice;
   for(auto iter = mWindows.begin(); iter != mWindows.end(); ++iter)
   {
-    iter->window->render(iter->device);
+    windowsByDevice[iter->device.d3DDevice].push_back(*iter);
+  }
+
+  std::vector<FrameScheduler::Lane> lanes;
+  for(auto iter = windowsByDevice.begin(); iter != windowsByDevice.end(); ++iter)
+  {
+    std::vector<DeviceWindowPair> deviceWindows = iter->second;
+    lanes.push_back([deviceWindows](uint64_t sharedCount)
+    {
+      for(auto windowIter = deviceWindows.begin(); windowIter != deviceWindows.end(); ++windowIter)
+      {
+        windowIter->window->render(windowIter->device, sharedCount);
+      }
+    });
+  }
+
+  mFrameScheduler.reset(new FrameScheduler(clock, lanes));
+}
+
+uint64_t WindowManager::getCountsPerRefresh() const
+{
+  uint64_t shortest = 0;
+  for(auto iter = mWindows.begin(); iter != mWindows.end(); ++iter)
+  {
+    uint64_t countsPerRefresh = iter->window->getModel()->getCountsPerRefresh();
+    if(shortest == 0 || countsPerRefresh < shortest)
+    {
+      shortest = countsPerRefresh;
+    }
+  }
+  return shortest;
+}
+
+void WindowManager::setPacingInterval(double seconds)
+{
+  mSession->setPacingInterval(seconds);
+}
+
+bool WindowManager::postCommand(const RenderCommand& command)
+{
+  if(!commandQueue.push(command))
+  {
+    ++droppedCommandCount;
+    return false;
+  }
+  return true;
+}
+
+int WindowManager::getDroppedCommandCount()
+{
+  return droppedCommandCount;
+}
+
+int WindowManager::processCommands()
+{
+  int processedCount = 0;
+  RenderCommand command;
+  while(commandQueue.pop(&command))
+  {
+    ++processedCount;
+    if(command.type == RenderCommand::TYPE_TOGGLE_TRACE)
+    {
+      toggleTrace();
+      continue;
+    }
+    for(auto iter = mWindows.begin(); iter != mWindows.end(); ++iter)
+    {
+      if(iter->window != command.window)
+      {
+        continue;
+      }
+      switch(command.type)
+      {
+      case RenderCommand::TYPE_RESIZE:
+        iter->window->resizeBuffers(iter->device, command.width, command.height);
+        break;
+      default:
+        break;
+      }
+    }
+  }
+  return processedCount;
+}
+
+void WindowManager::toggleTrace()
+{
+  if(!TraceZones::isRecording())
+  {
+    TraceZones::start();
+    return;
+  }
+
+  TraceZones::stop();
+  wchar_t report[128];
+  bool written = TraceZones::exportChromeTrace(Config::tracePath);
+  _snwprintf_s(report, 128, _TRUNCATE, L"Trace: %s, %llu zones dropped\n",
+    written ? L"written" : L"could not be written", (unsigned long long)TraceZones::getDroppedCount());
+  OutputDebugString(report);
+}
+
+void WindowManager::render()
+{
+  mFrameLoop->run();
+}
+
+void WindowManager::renderOutputs()
+{
+  if(mFrameScheduler)
+  {
+    mFrameScheduler->runFrame();
+  }
+  else
+  {
+    for(auto iter = mWindows.begin(); iter != mWindows.end(); ++iter)
+    {
+      iter->window->render(iter->device);
+    }
   }
-  Model::loopComplete();
 }
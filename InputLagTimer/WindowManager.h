@@ -1,11 +1,20 @@
 #pragma once
 #include "Setup.h"
+#include "FrameLoop.h"
+#include "FrameScheduler.h"
+#include "TelemetryRecorder.h"
+#include "StartupProfile.h"
+#include "SpscRing.h"
 #include <map>
+#include <memory>
 #include <unordered_set>
 
 class Window;
+class Model;
+class TimingSession;
+class FontLoader;
 
-class WindowManager
+class WindowManager : public FrameLoop::Outputs
 {
 public:
   struct Device
@@ -20,12 +29,102 @@ public:
     Window* window;
   };
 
-  WindowManager(const Setup::Settings& settings, HINSTANCE hInstance);
+  /**
+   * A change to render state asked for by a window message. Messages are handled on the thread
+   * that owns the windows, which is not the render thread when rendering runs on its own thread,
+   * so the change is queued and made by render() between frames.
+   */
+  struct RenderCommand
+  {
+    enum Type
+    {
+      /** The window's client area changed size, so its swap chain buffers should too */
+      TYPE_RESIZE,
+      /** Starts a trace of the frame loop's zones, or stops it and writes it to Config::tracePath. For no window in particular. */
+      TYPE_TOGGLE_TRACE
+    };
+
+    Type type;
+    Window* window;
+    UINT width;
+    UINT height;
+  };
+
+  /**
+   * @param fontLoader should have been started before the settings were worked out, so that the fonts
+   * are parsed while the devices are being created. It is only used during construction.
+   * @param startupProfile has a phase ended for each step of creating the devices, windows and models.
+   * @param displayProfile seeds the failsafes and HUD, and is updated with this session's measurements
+   * and saved on destruction. NULL if profiles are disabled. Not owned.
+   */
+  WindowManager(const Setup::Settings& settings, HINSTANCE hInstance, FontLoader* fontLoader, StartupProfile* startupProfile, DisplayProfile* displayProfile);
   virtual ~WindowManager(void);
 
+  /**
+   * Runs one loop of the frame loop, rendering a frame on every window.
+   */
   void render();
 
+  /**
+   * @return the refresh period of the fastest output, in counts.
+   */
+  uint64_t getCountsPerRefresh() const;
+
+  /**
+   * The time that frames are deliberately held apart by frame pacing, which does not count
+   * towards the frame time failsafe. 0 when frames are not paced. Called between frames.
+   */
+  void setPacingInterval(double seconds);
+
+  /**
+   * Queues a command for the next call to render(). Only called from the thread that owns the windows.
+   * Never blocks: the command is dropped if the queue is full.
+   * @return false if the command was dropped.
+   */
+  static bool postCommand(const RenderCommand& command);
+
+  /**
+   * @return the number of commands dropped because the queue was full.
+   */
+  static int getDroppedCommandCount();
+
 protected:
+  /**
+   * Records each output's measured refresh period and this session's frame time baseline in the display profile, and saves it.
+   */
+  void saveDisplayProfile();
+
+  /**
+   * Gives each device its own render thread. Outputs on the same device render in turn on that thread.
+   */
+  void createFrameScheduler(Clock* clock);
+
+  /**
+   * Makes the changes queued by postCommand() since the last frame.
+   * @return the number of commands made
+   */
+  virtual int processCommands();
+
+  /**
+   * Renders every window, on the frame scheduler's lanes if there is one.
+   */
+  virtual void renderOutputs();
+
+  /**
+   * Starts a trace, or stops the one that is recording and writes it out.
+   */
+  void toggleTrace();
+
+  /** Filled by the thread that owns the windows and emptied by the thread that renders */
+  static SpscRing<RenderCommand, 64> commandQueue;
+  static int droppedCommandCount;
+
   std::vector<DeviceWindowPair> mWindows;
+  /** Owns every window's model, in the same order */
+  std::unique_ptr<TimingSession> mSession;
+  std::unique_ptr<FrameLoop> mFrameLoop;
+  std::unique_ptr<FrameScheduler> mFrameScheduler;
+  std::unique_ptr<TelemetryRecorder> mTelemetry;
   std::unordered_set<IUnknown*> mReferencedObj;
+  DisplayProfile* mDisplayProfile;
 };
@@ -0,0 +1,269 @@
+/*
+ * Checks that RefreshEstimator locks on to synthetic vblank traces with drift, jitter, dropped and
+ * glitched observations, and compares the columns it picks with the nominal refresh rate counted
+ * the old way, truncated to whole ticks, and the new way, as an exact fraction.
+ * Usage: RefreshEstimatorBenchmark [seconds per trace]
+ * Returns 1 if the estimator did not lock on to every trace or picked the wrong refresh too often.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Clock.h"
+#include "RefreshEstimator.h"
+
+static const int DEFAULT_SECONDS = 600;
+/* The simulated counter, which is QueryPerformanceCounter's usual frequency */
+static const uint64_t FREQUENCY = 10000000;
+/* Window samples the frame statistics once every this many presents */
+static const int PRESENTS_PER_OBSERVATION = 128;
+/* Both counters start close to wrapping around, so the traces cross it */
+static const uint64_t STARTING_COUNT = 0ULL - 60 * FREQUENCY;
+static const uint32_t STARTING_REFRESH = 0xFFFFFF00u;
+/* Once locked, a trace fails if more frames than this fraction are given the wrong refresh */
+static const double MAX_WRONG_FRACTION = 0.01;
+/* or if a predicted vblank is further than this fraction of the period from the true one */
+static const double MAX_PHASE_ERROR = 0.05;
+static const int TIMING_ITERATIONS = 10000000;
+
+struct Trace
+{
+  const char* name;
+  /** The refresh rate the output reports, in Hz */
+  unsigned int numerator;
+  unsigned int denominator;
+  /** How far the panel's true period is from the reported rate's, at the start */
+  double offsetPpm;
+  /** and how much further it moves every minute, as the panel warms up */
+  double driftPpmPerMinute;
+  /** The standard deviation of the error in each reported vblank time */
+  double jitterUs;
+  double framesPerSecond;
+  /** The fraction of observations that fail, and that are late by a few milliseconds */
+  double dropFraction;
+  double glitchFraction;
+  /** The vblanks move by half a period halfway through, as when the output resynchronises */
+  bool phaseJump;
+};
+
+static const Trace TRACES[] =
+{
+  { "60Hz",                60, 1,       0.0,  0.0,  20.0, 2000.0, 0.0,  0.0,   false },
+  { "60Hz +150ppm",        60, 1,     150.0,  0.0,  50.0, 2000.0, 0.0,  0.0,   false },
+  { "59.94Hz drifting",    60000, 1001, -80.0, 5.0,  50.0, 2000.0, 0.0,  0.0,   false },
+  { "144Hz noisy",         144, 1,    300.0,  2.0, 200.0, 3000.0, 0.1,  0.01,  false },
+  { "60Hz paced to 60fps", 60, 1,     100.0,  1.0,  50.0,   60.0, 0.0,  0.0,   false },
+  { "60Hz phase jump",     60, 1,      50.0,  0.0,  50.0, 2000.0, 0.0,  0.0,   true },
+};
+
+/** xorshift64*, so every run sees the same traces */
+static uint64_t randomState = 0x9E3779B97F4A7C15ULL;
+
+static double uniformRandom()
+{
+  randomState ^= randomState >> 12;
+  randomState ^= randomState << 25;
+  randomState ^= randomState >> 27;
+  return ((randomState * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double normalRandom()
+{
+  double u = uniformRandom();
+  double v = uniformRandom();
+  return sqrt(-2.0 * log(u + 1e-300)) * cos(6.283185307179586 * v);
+}
+
+struct TraceResult
+{
+  double lockSeconds;
+  double periodErrorPpm;
+  double phaseRmsUs;
+  double phaseMaxUs;
+  /** Fractions of frames given the wrong refresh */
+  double truncatedWrong;
+  double exactWrong;
+  double estimatorWrong;
+  uint64_t rejected;
+  int resyncs;
+  bool passed;
+};
+
+/**
+ * Renders frames against a simulated output for the given time. The true vblanks are at a period that
+ * drifts from the nominal one, and the frame statistics report them with jitter every PRESENTS_PER_OBSERVATION
+ * frames, as Window does. Every frame, each way of counting refreshes is checked against the true refresh.
+ */
+static TraceResult runTrace(const Trace& trace, int seconds)
+{
+  double nominalPeriod = static_cast<double>(FREQUENCY) * trace.denominator / trace.numerator;
+  /* What the model used to count: the period truncated to whole ticks */
+  uint64_t truncatedPeriod = FREQUENCY * trace.denominator / trace.numerator;
+  RefreshEstimator estimator(nominalPeriod);
+
+  /* Times are in ticks since the first vblank, which is where the nominal counts are started from */
+  double frameInterval = FREQUENCY / trace.framesPerSecond;
+  double duration = static_cast<double>(FREQUENCY) * seconds;
+  uint64_t trueRefresh = 0;
+  double vblank = 0.0;
+  double nextVblank = nominalPeriod * (1.0 + trace.offsetPpm / 1000000.0);
+  bool jumped = false;
+
+  TraceResult result = { -1.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0, 0, true };
+  uint64_t frames = 0;
+  uint64_t truncatedWrong = 0;
+  uint64_t exactWrong = 0;
+  uint64_t lockedFrames = 0;
+  uint64_t estimatorWrong = 0;
+  double phaseSquares = 0.0;
+  uint64_t phaseSamples = 0;
+  uint64_t lastPhaseRefresh = 0;
+  double truePeriod = nextVblank;
+
+  for(double frameTime = 0.0; frameTime < duration; frameTime += frameInterval * (0.5 + uniformRandom()))
+  {
+    while(nextVblank <= frameTime)
+    {
+      vblank = nextVblank;
+      ++trueRefresh;
+      double minutes = vblank / FREQUENCY / 60.0;
+      truePeriod = nominalPeriod * (1.0 + (trace.offsetPpm + trace.driftPpmPerMinute * minutes) / 1000000.0);
+      nextVblank += truePeriod;
+      if(trace.phaseJump && !jumped && vblank > duration / 2)
+      {
+        nextVblank += truePeriod / 2;
+        jumped = true;
+      }
+    }
+    uint64_t ticks = static_cast<uint64_t>(frameTime);
+    if(ticks < vblank)
+    {
+      continue; /* Rounded down to before the vblank, so it is not clear which refresh it is in */
+    }
+    ++frames;
+
+    /* The nominal counts were started at the first vblank, which is the best they could do */
+    if(ticks / truncatedPeriod != trueRefresh)
+    {
+      ++truncatedWrong;
+    }
+    if(ticks * trace.numerator / (FREQUENCY * trace.denominator) != trueRefresh)
+    {
+      ++exactWrong;
+    }
+
+    uint64_t count = STARTING_COUNT + ticks;
+    if(estimator.isLocked())
+    {
+      if(result.lockSeconds < 0.0)
+      {
+        result.lockSeconds = frameTime / FREQUENCY;
+      }
+      ++lockedFrames;
+      if(estimator.getRefreshIndex(count) - STARTING_REFRESH != trueRefresh)
+      {
+        ++estimatorWrong;
+      }
+      if(trueRefresh != lastPhaseRefresh)
+      {
+        double phaseError = static_cast<double>(static_cast<int64_t>(estimator.getRefreshStart(trueRefresh + STARTING_REFRESH) - STARTING_COUNT)) - vblank;
+        phaseError = fabs(phaseError);
+        phaseSquares += phaseError * phaseError;
+        ++phaseSamples;
+        if(phaseError > result.phaseMaxUs)
+        {
+          result.phaseMaxUs = phaseError;
+        }
+        lastPhaseRefresh = trueRefresh;
+      }
+    }
+
+    if(frames % PRESENTS_PER_OBSERVATION == 0 && uniformRandom() >= trace.dropFraction)
+    {
+      double reported = vblank + normalRandom() * trace.jitterUs * FREQUENCY / 1000000.0;
+      if(uniformRandom() < trace.glitchFraction)
+      {
+        reported += 0.004 * FREQUENCY;
+      }
+      estimator.observe(static_cast<uint32_t>(STARTING_REFRESH + trueRefresh), STARTING_COUNT + static_cast<int64_t>(floor(reported + 0.5)));
+    }
+  }
+
+  double usPerTick = 1000000.0 / FREQUENCY;
+  result.periodErrorPpm = (estimator.getPeriod() - truePeriod) / truePeriod * 1000000.0;
+  result.phaseRmsUs = phaseSamples > 0 ? sqrt(phaseSquares / phaseSamples) * usPerTick : 0.0;
+  result.phaseMaxUs *= usPerTick;
+  result.truncatedWrong = static_cast<double>(truncatedWrong) / frames;
+  result.exactWrong = static_cast<double>(exactWrong) / frames;
+  result.estimatorWrong = lockedFrames > 0 ? static_cast<double>(estimatorWrong) / lockedFrames : 1.0;
+  result.rejected = estimator.getRejectedCount();
+  result.resyncs = estimator.getResyncCount();
+
+  /* The phase jump is the one trace where vblanks are meant to be missed until the estimator resyncs */
+  double maxPhaseUs = truePeriod * MAX_PHASE_ERROR * usPerTick;
+  result.passed = estimator.isLocked() && result.estimatorWrong <= MAX_WRONG_FRACTION
+    && (trace.phaseJump || result.phaseMaxUs <= maxPhaseUs);
+  return result;
+}
+
+/**
+ * @return nanoseconds per call of observe() and of getRefreshIndex(), which both happen inside the frame loop.
+ */
+static void timeEstimator(double* outObserveNs, double* outIndexNs)
+{
+  Clock* clock = Clock::getSystemClock();
+  double nsPerCount = 1000000000.0 / clock->getFrequency();
+  double period = static_cast<double>(FREQUENCY) / 60.0;
+  RefreshEstimator estimator(period);
+
+  uint64_t start = clock->getCount();
+  for(int i = 0; i < TIMING_ITERATIONS; ++i)
+  {
+    estimator.observe(static_cast<uint32_t>(i * 4), static_cast<uint64_t>(i * 4 * period + (i & 7) * 10.0));
+  }
+  *outObserveNs = (clock->getCount() - start) * nsPerCount / TIMING_ITERATIONS;
+
+  uint64_t sum = 0;
+  start = clock->getCount();
+  for(int i = 0; i < TIMING_ITERATIONS; ++i)
+  {
+    sum += estimator.getRefreshIndex(static_cast<uint64_t>(i) * 997);
+  }
+  *outIndexNs = (clock->getCount() - start) * nsPerCount / TIMING_ITERATIONS;
+  if(sum == 1)
+  {
+    printf(" "); /* Keeps the loop from being optimised away */
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  int seconds = argc > 1 ? atoi(argv[1]) : DEFAULT_SECONDS;
+  if(seconds <= 0)
+  {
+    fprintf(stderr, "Usage: RefreshEstimatorBenchmark [seconds per trace]\n");
+    return 1;
+  }
+
+  printf("%d simulated seconds per trace. Wrong refresh is the fraction of frames that each way of counting put in the wrong refresh:\n", seconds);
+  printf("the nominal rate truncated to whole ticks, the nominal rate as an exact fraction, and the estimator once locked.\n\n");
+  printf("%-20s %7s %9s %9s %9s %9s %9s %9s %8s %7s\n", "trace", "lock s", "period", "phase", "phase", "wrong", "wrong", "wrong", "rejected", "resyncs");
+  printf("%-20s %7s %9s %9s %9s %9s %9s %9s %8s %7s\n", "", "", "err ppm", "rms us", "max us", "truncated", "exact", "estimator", "", "");
+
+  bool passed = true;
+  int traceCount = sizeof(TRACES) / sizeof(TRACES[0]);
+  for(int i = 0; i < traceCount; ++i)
+  {
+    TraceResult result = runTrace(TRACES[i], seconds);
+    printf("%-20s %7.1f %9.2f %9.1f %9.1f %8.2f%% %8.2f%% %8.3f%% %8llu %7d %s\n",
+      TRACES[i].name, result.lockSeconds, result.periodErrorPpm, result.phaseRmsUs, result.phaseMaxUs,
+      result.truncatedWrong * 100.0, result.exactWrong * 100.0, result.estimatorWrong * 100.0,
+      (unsigned long long)result.rejected, result.resyncs, result.passed ? "" : "FAILED");
+    passed = passed && result.passed;
+  }
+
+  double observeNs = 0.0;
+  double indexNs = 0.0;
+  timeEstimator(&observeNs, &indexNs);
+  printf("\nobserve() %.1fns, getRefreshIndex() %.1fns per call\n", observeNs, indexNs);
+  return passed ? 0 : 1;
+}
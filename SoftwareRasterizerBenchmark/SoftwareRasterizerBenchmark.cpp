@@ -0,0 +1,282 @@
+/*
+ * Renders InputLagTimer's frames for a 3840x2160 output with the real model and OutputRenderer, drawing
+ * through SoftwareRenderBackend. Checks a frame against a golden image, then measures the time per frame
+ * with different numbers of threads.
+ * This file builds on Windows and Linux, so it only uses the parts of DirectXTK that have no D3D dependency.
+ * Usage: SoftwareRasterizerBenchmark [frames] [golden image] [font directory]
+ */
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FileMapping.h"
+#include "SpriteFontParser.h"
+#include "Clock.h"
+#include "Config.h"
+#include "FontFace.h"
+#include "OutputRenderer.h"
+#include "SoftwareRenderBackend.h"
+#include "TickConverter.h"
+#include "TimerTextRenderer.h"
+#include "TimingSession.h"
+
+#if defined(_MSC_VER)
+#pragma warning(disable : 4996)
+#endif
+
+static const int DEFAULT_FRAMES = 200;
+static const char* DEFAULT_FONT_DIRECTORY = "../InputLagTimer/res/fonts/";
+static const unsigned int OUTPUT_WIDTH = 3840;
+static const unsigned int OUTPUT_HEIGHT = 2160;
+static const unsigned int REFRESH_NUMERATOR = 60;
+static const unsigned int REFRESH_DENOMINATOR = 1;
+/* The golden image is always the output's first frame, drawn this far into the second, so that it shows 123.45 */
+static const uint32_t GOLDEN_TIMER_UNITS = 12345;
+/* InputLagTimer's default colours, as config.ini sets them: white text on black */
+static const float FONT_COLOUR[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+static const float BACKGROUND_COLOUR[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+/**
+ * A mapped and parsed font, with its texture decoded for the rasterizer. The decoded texture is the face's texture handle.
+ */
+struct Font
+{
+  std::shared_ptr<DirectX::FileMapping> data;
+  DirectX::SpriteFontView view;
+  SoftwareRasterizer::Texture texture;
+  std::unique_ptr<FontFace> face;
+};
+
+/**
+ * Maps and parses a font, the same way FontLoader does, and decodes its texture.
+ * @return NULL with a message on stderr if the file can't be loaded.
+ */
+static Font* loadFont(const std::string& path)
+{
+  std::unique_ptr<Font> font(new Font());
+  try
+  {
+#if defined(_WIN32)
+    font->data = DirectX::FileMapping::Open(std::wstring(path.begin(), path.end()));
+#else
+    font->data = DirectX::FileMapping::Open(path);
+#endif
+    DirectX::BinaryReader reader(font->data);
+    DirectX::ParseSpriteFont(&reader, &font->view);
+  }
+  catch(const std::exception& e)
+  {
+    fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+    return NULL;
+  }
+  if(!font->texture.loadSpriteFont(font->view))
+  {
+    fprintf(stderr, "%s: texture format %u is not supported\n", path.c_str(), font->view.textureFormat);
+    return NULL;
+  }
+  font->face.reset(new FontFace(font->view, &font->texture));
+  return font.release();
+}
+
+/**
+ * @return the paths of the .spritefont files in directory, sorted by name as FontLoader sorts them.
+ */
+static std::vector<std::string> listFonts(const std::string& directory)
+{
+  std::vector<std::string> names;
+#if defined(_WIN32)
+  WIN32_FIND_DATAA findData;
+  HANDLE find = FindFirstFileA((directory + "*.spritefont").c_str(), &findData);
+  if(find != INVALID_HANDLE_VALUE)
+  {
+    do
+    {
+      names.push_back(findData.cFileName);
+    }
+    while(FindNextFileA(find, &findData) != 0);
+    FindClose(find);
+  }
+#else
+  DIR* dir = opendir(directory.c_str());
+  if(dir != NULL)
+  {
+    for(dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir))
+    {
+      std::string name = entry->d_name;
+      if(name.size() > 11 && name.compare(name.size() - 11, 11, ".spritefont") == 0)
+      {
+        names.push_back(name);
+      }
+    }
+    closedir(dir);
+  }
+#endif
+
+  std::sort(names.begin(), names.end());
+  for(auto iter = names.begin(); iter != names.end(); ++iter)
+  {
+    *iter = directory + *iter;
+  }
+  return names;
+}
+
+/**
+ * Writes the frame as the golden image if there is none yet, or compares the frame with it.
+ * @return false if the frame differs from the golden image.
+ */
+static bool checkGolden(const SoftwareRasterizer& rasterizer, const std::string& path)
+{
+  int width, height;
+  std::vector<uint32_t> golden;
+  if(!SoftwareRasterizer::loadTGA(path, &width, &height, &golden))
+  {
+    if(!rasterizer.saveTGA(path))
+    {
+      fprintf(stderr, "%s: could not be written\n", path.c_str());
+      return false;
+    }
+    printf("Golden image written to %s\n", path.c_str());
+    return true;
+  }
+  if(width != rasterizer.getWidth() || height != rasterizer.getHeight())
+  {
+    printf("Golden image %s is %dx%d, not %dx%d\n", path.c_str(), width, height, rasterizer.getWidth(), rasterizer.getHeight());
+    return false;
+  }
+
+  const uint32_t* pixels = rasterizer.getPixels();
+  size_t differences = 0;
+  for(size_t i = 0; i < golden.size(); ++i)
+  {
+    if(golden[i] != pixels[i])
+    {
+      if(differences == 0)
+      {
+        printf("First difference at %d,%d: %08x, golden %08x\n", static_cast<int>(i % width), static_cast<int>(i / width), pixels[i], golden[i]);
+      }
+      ++differences;
+    }
+  }
+  printf("Golden image %s: %s (%u pixels differ)\n", path.c_str(), differences == 0 ? "matches" : "DIFFERS", static_cast<unsigned int>(differences));
+  return differences == 0;
+}
+
+int main(int argc, char* argv[])
+{
+  int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+  if(frames <= 0)
+  {
+    fprintf(stderr, "Usage: SoftwareRasterizerBenchmark [frames] [golden image] [font directory]\n");
+    return 1;
+  }
+  std::string goldenPath = argc > 2 ? argv[2] : "";
+  std::string fontDirectory = argc > 3 ? argv[3] : DEFAULT_FONT_DIRECTORY;
+  if(fontDirectory[fontDirectory.size() - 1] != '/' && fontDirectory[fontDirectory.size() - 1] != '\\')
+  {
+    fontDirectory += '/';
+  }
+
+  std::vector<Font*> timerFonts;
+  std::vector<TimerTextRenderer*> timerTexts;
+  std::vector<std::string> paths = listFonts(fontDirectory + "timer/");
+  for(auto iter = paths.begin(); iter != paths.end(); ++iter)
+  {
+    Font* font = loadFont(*iter);
+    if(font)
+    {
+      timerFonts.push_back(font);
+      timerTexts.push_back(new TimerTextRenderer(font->face.get()));
+    }
+  }
+  std::unique_ptr<Font> normalFont(loadFont(fontDirectory + "normal.spritefont"));
+  if(timerFonts.empty() || !normalFont)
+  {
+    fprintf(stderr, "No fonts in %s\n", fontDirectory.c_str());
+    return 1;
+  }
+  memcpy(Config::fontColour, FONT_COLOUR, sizeof(Config::fontColour));
+  memcpy(Config::backgroundColour, BACKGROUND_COLOUR, sizeof(Config::backgroundColour));
+
+  /* The frames are rendered with counts worked out from the session's start rather than sampled, so that every run
+     draws the same frames. The session's loop is never run, so the HUD keeps the values it starts with. */
+  Clock* clock = Clock::getSystemClock();
+  std::vector<TimingSession::OutputSetting> settings(1);
+  settings[0].refreshNumerator = REFRESH_NUMERATOR;
+  settings[0].refreshDenominator = REFRESH_DENOMINATOR;
+  settings[0].writer = 0;
+  TimingSession session(clock, clock->getCount(), settings);
+  Model* model = session.getModel(0);
+  uint64_t countsPerRefresh = clock->getFrequency() * REFRESH_DENOMINATOR / REFRESH_NUMERATOR;
+  uint64_t count = session.getStartingCount() + clock->getFrequency() * GOLDEN_TIMER_UNITS / TickConverter::UNITS_PER_SECOND;
+
+  OutputRenderer::Output output;
+  output.number = 1;
+  output.count = 1;
+  output.width = OUTPUT_WIDTH;
+  output.height = OUTPUT_HEIGHT;
+  output.refreshNumerator = REFRESH_NUMERATOR;
+  output.refreshDenominator = REFRESH_DENOMINATOR;
+  output.layoutWidth = OUTPUT_WIDTH;
+  output.layoutHeight = OUTPUT_HEIGHT;
+
+  int result = 0;
+  if(!goldenPath.empty())
+  {
+    SoftwareRenderBackend backend(OUTPUT_WIDTH, OUTPUT_HEIGHT, 1);
+    OutputRenderer renderer(&backend, timerTexts, normalFont->face.get());
+    renderer.renderFrame(model, output, count);
+    result = checkGolden(backend.getRasterizer(), goldenPath) ? 0 : 1;
+  }
+
+  /* 1, 2, 4 and so on, and every hardware thread */
+  std::vector<int> threadCounts;
+  int maxThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  for(int threads = 1; threads < maxThreads; threads *= 2)
+  {
+    threadCounts.push_back(threads);
+  }
+  threadCounts.push_back(maxThreads);
+
+  printf("%d timer fonts, %d frames of %ux%u\n", static_cast<int>(timerFonts.size()), frames, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+  printf("threads  sprites/frame   ms/frame  Mpixels/s\n");
+  for(auto iter = threadCounts.begin(); iter != threadCounts.end(); ++iter)
+  {
+    int threads = *iter;
+    SoftwareRenderBackend backend(OUTPUT_WIDTH, OUTPUT_HEIGHT, threads);
+    OutputRenderer renderer(&backend, timerTexts, normalFont->face.get());
+    /* The first frame lays out the columns and the HUD, so it is not measured */
+    count += countsPerRefresh;
+    renderer.renderFrame(model, output, count);
+
+    /* A refresh apart, as the timer is drawn on a display, so that each frame has a new timer value and column */
+    uint64_t start = clock->getCount();
+    for(int frame = 0; frame < frames; ++frame)
+    {
+      count += countsPerRefresh;
+      renderer.renderFrame(model, output, count);
+    }
+    double seconds = static_cast<double>(clock->getCount() - start) / clock->getFrequency();
+    printf("%7d %14u %10.2f %10.1f\n", threads, static_cast<unsigned int>(backend.getSpriteCount()), seconds * 1000.0 / frames,
+      static_cast<double>(OUTPUT_WIDTH) * OUTPUT_HEIGHT * frames / seconds / 1000000.0);
+  }
+
+  for(size_t i = 0; i < timerFonts.size(); ++i)
+  {
+    delete timerTexts[i];
+    delete timerFonts[i];
+  }
+  return result;
+}
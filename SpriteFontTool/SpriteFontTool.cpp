@@ -0,0 +1,374 @@
+/*
+ * Command line checks for the .spritefont files that InputLagTimer loads.
+ * This file builds on Windows and Linux, so it only uses the parts of DirectXTK
+ * that have no D3D dependency.
+ * Usage: SpriteFontTool validate|dump|bench-parse|bench-lookup path...
+ * Each path may be a .spritefont file or a directory of them, such as res/fonts/timer/.
+ */
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <d3d11.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+#include "FileMapping.h"
+#include "GlyphLookup.h"
+#include "SpriteFontParser.h"
+#include "Clock.h"
+
+typedef DirectX::SpriteFontView::Glyph FontGlyph;
+
+struct CharacterLess
+{
+  bool operator()(const FontGlyph& left, uint32_t right) const
+  {
+    return left.Character < right;
+  }
+};
+
+/* Everything Window draws: the timer value and the HUD */
+static const char* BENCHMARK_TEXT =
+  "012.34\n"
+  "output1/2\n1920x1080\n59.94Hz\n\n542FPS\n\nframe\ntime(max)\n5.23ms\np99(10s)\n4.80ms\nerror at\n10.0ms\n\n"
+  "render\nvariance\n2.45ms\np99(10s)\n1.20ms\nerror at\n2.0ms\n\nv0.8.1\n\ninputlag\n.allenwp\n.com";
+
+static const int BENCHMARK_PASSES = 20000;
+static const int PARSE_PASSES = 20000;
+
+/**
+ * Adds path to outPaths if it is a file, or every file in it if it is a directory.
+ */
+static void expandPath(const std::string& path, std::vector<std::string>* outPaths)
+{
+  std::string directory = path;
+  if(!directory.empty() && directory[directory.size() - 1] != '/' && directory[directory.size() - 1] != '\\')
+  {
+    directory += '/';
+  }
+  std::vector<std::string> names;
+
+#if defined(_WIN32)
+  DWORD attributes = GetFileAttributesA(path.c_str());
+  if(attributes == INVALID_FILE_ATTRIBUTES || (attributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+  {
+    outPaths->push_back(path);
+    return;
+  }
+  WIN32_FIND_DATAA findData;
+  HANDLE find = FindFirstFileA((directory + "*").c_str(), &findData);
+  if(find != INVALID_HANDLE_VALUE)
+  {
+    do
+    {
+      if((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0)
+      {
+        names.push_back(findData.cFileName);
+      }
+    }
+    while(FindNextFileA(find, &findData) != 0);
+    FindClose(find);
+  }
+#else
+  struct stat status;
+  if(stat(path.c_str(), &status) != 0 || !S_ISDIR(status.st_mode))
+  {
+    outPaths->push_back(path);
+    return;
+  }
+  DIR* dir = opendir(path.c_str());
+  if(dir != NULL)
+  {
+    for(dirent* entry = readdir(dir); entry != NULL; entry = readdir(dir))
+    {
+      std::string name = entry->d_name;
+      struct stat entryStatus;
+      if(stat((directory + name).c_str(), &entryStatus) == 0 && S_ISREG(entryStatus.st_mode))
+      {
+        names.push_back(name);
+      }
+    }
+    closedir(dir);
+  }
+#endif
+
+  /* Same order on every platform */
+  std::sort(names.begin(), names.end());
+  for(auto iter = names.begin(); iter != names.end(); ++iter)
+  {
+    outPaths->push_back(directory + *iter);
+  }
+}
+
+/**
+ * Maps and parses a font, the same way SpriteFont loads it. The view points into the mapping.
+ * @return false with a message on stderr if the file can't be mapped or parsed.
+ */
+static bool loadFont(const std::string& path, std::shared_ptr<DirectX::FileMapping>* outData, DirectX::SpriteFontView* outView)
+{
+  try
+  {
+#if defined(_WIN32)
+    *outData = DirectX::FileMapping::Open(std::wstring(path.begin(), path.end()));
+#else
+    *outData = DirectX::FileMapping::Open(path);
+#endif
+    DirectX::BinaryReader reader(*outData);
+    DirectX::ParseSpriteFont(&reader, outView);
+  }
+  catch(const std::exception& e)
+  {
+    fprintf(stderr, "%s: %s\n", path.c_str(), e.what());
+    return false;
+  }
+  return true;
+}
+
+static int validate(const std::vector<std::string>& paths)
+{
+  int result = 0;
+  for(auto iter = paths.begin(); iter != paths.end(); ++iter)
+  {
+    std::shared_ptr<DirectX::FileMapping> data;
+    DirectX::SpriteFontView view;
+    if(!loadFont(*iter, &data, &view))
+    {
+      result = 1;
+      continue;
+    }
+    std::vector<std::string> problems;
+    if(DirectX::ValidateSpriteFont(view, &problems))
+    {
+      printf("%s: OK\n", iter->c_str());
+      continue;
+    }
+    result = 1;
+    for(auto problem = problems.begin(); problem != problems.end(); ++problem)
+    {
+      printf("%s: %s\n", iter->c_str(), problem->c_str());
+    }
+  }
+  return result;
+}
+
+/**
+ * Lays text out the same way as SpriteFont::MeasureString.
+ */
+static void measureString(const DirectX::SpriteFontView& view, const char* text, float* outWidth, float* outHeight)
+{
+  DirectX::GlyphLookup<FontGlyph> lookup;
+  lookup.Reset(view.glyphs, view.glyphs + view.glyphCount);
+  float x = 0;
+  *outWidth = 0;
+  *outHeight = 0;
+  for(; *text; ++text)
+  {
+    const FontGlyph* glyph = lookup.Find(static_cast<unsigned char>(*text));
+    if(glyph == NULL)
+    {
+      glyph = lookup.Find(view.defaultCharacter);
+    }
+    if(glyph == NULL)
+    {
+      continue;
+    }
+    x += glyph->XOffset;
+    if(x < 0)
+    {
+      x = 0;
+    }
+    float width = static_cast<float>(glyph->Subrect.right - glyph->Subrect.left);
+    float height = static_cast<float>(glyph->Subrect.bottom - glyph->Subrect.top) + glyph->YOffset;
+    *outWidth = std::max(*outWidth, x + width);
+    *outHeight = std::max(*outHeight, std::max(height, view.lineSpacing));
+    x += width + glyph->XAdvance;
+  }
+}
+
+static int dump(const std::vector<std::string>& paths)
+{
+  int result = 0;
+  for(auto iter = paths.begin(); iter != paths.end(); ++iter)
+  {
+    std::shared_ptr<DirectX::FileMapping> data;
+    DirectX::SpriteFontView view;
+    if(!loadFont(*iter, &data, &view))
+    {
+      result = 1;
+      continue;
+    }
+
+    int tallest = 0;
+    int widest = 0;
+    for(uint32_t i = 0; i < view.glyphCount; ++i)
+    {
+      widest = std::max(widest, view.glyphs[i].Subrect.right - view.glyphs[i].Subrect.left);
+      tallest = std::max(tallest, view.glyphs[i].Subrect.bottom - view.glyphs[i].Subrect.top);
+    }
+    float timerWidth;
+    float timerHeight;
+    measureString(view, "888.88", &timerWidth, &timerHeight);
+
+    printf("%s: %u bytes\n", iter->c_str(), static_cast<unsigned int>(data->Size()));
+    if(view.glyphCount > 0)
+    {
+      printf("  glyphs         %u, U+%04X to U+%04X\n", view.glyphCount, view.glyphs[0].Character, view.glyphs[view.glyphCount - 1].Character);
+    }
+    printf("  largest glyph  %dx%d\n", widest, tallest);
+    printf("  line spacing   %.1f\n", view.lineSpacing);
+    printf("  default        U+%04X\n", view.defaultCharacter);
+    printf("  texture        %ux%u, format %u, %u bytes\n", view.textureWidth, view.textureHeight, view.textureFormat, view.textureStride * view.textureRows);
+    printf("  \"888.88\"       %.0fx%.0f\n", timerWidth, timerHeight);
+  }
+  return result;
+}
+
+static int benchParse(const std::vector<std::string>& paths)
+{
+  int result = 0;
+  Clock* clock = Clock::getSystemClock();
+  for(auto iter = paths.begin(); iter != paths.end(); ++iter)
+  {
+    std::shared_ptr<DirectX::FileMapping> data;
+    DirectX::SpriteFontView view;
+    if(!loadFont(*iter, &data, &view))
+    {
+      result = 1;
+      continue;
+    }
+
+    uint64_t startCount = clock->getCount();
+    uint32_t checksum = 0;
+    for(int pass = 0; pass < PARSE_PASSES; ++pass)
+    {
+      DirectX::ParseSpriteFont(data->Data(), data->Size(), &view);
+      checksum += view.glyphCount;
+    }
+    uint64_t parseCount = clock->getCount();
+    for(int pass = 0; pass < PARSE_PASSES; ++pass)
+    {
+      std::vector<std::string> problems;
+      checksum += DirectX::ValidateSpriteFont(view, &problems) ? 1 : 0;
+    }
+    uint64_t validateCount = clock->getCount();
+
+    double frequency = static_cast<double>(clock->getFrequency());
+    printf("%s: parse %.3fus, validate %.3fus (checksum %u)\n", iter->c_str(),
+           (parseCount - startCount) * 1.0e6 / frequency / PARSE_PASSES,
+           (validateCount - parseCount) * 1.0e6 / frequency / PARSE_PASSES, checksum);
+  }
+  return result;
+}
+
+static double benchmark(const char* name, const FontGlyph* glyphs, uint32_t glyphCount, bool useLookup)
+{
+  DirectX::GlyphLookup<FontGlyph> lookup;
+  lookup.Reset(glyphs, glyphs + glyphCount);
+  const FontGlyph* end = glyphs + glyphCount;
+  size_t textLength = strlen(BENCHMARK_TEXT);
+
+  Clock* clock = Clock::getSystemClock();
+  uint64_t startCount = clock->getCount();
+  /* Summed so that the lookups can't be optimised away */
+  float checksum = 0;
+  for(int pass = 0; pass < BENCHMARK_PASSES; ++pass)
+  {
+    for(size_t i = 0; i < textLength; ++i)
+    {
+      uint32_t character = static_cast<unsigned char>(BENCHMARK_TEXT[i]);
+      const FontGlyph* glyph;
+      if(useLookup)
+      {
+        glyph = lookup.Find(character);
+      }
+      else
+      {
+        glyph = std::lower_bound(glyphs, end, character, CharacterLess());
+        if(glyph == end || glyph->Character != character)
+        {
+          glyph = NULL;
+        }
+      }
+      if(glyph)
+      {
+        checksum += glyph->XAdvance;
+      }
+    }
+  }
+  uint64_t elapsed = clock->getCount() - startCount;
+
+  double nanoseconds = static_cast<double>(elapsed) * 1.0e9 / clock->getFrequency() / (static_cast<double>(BENCHMARK_PASSES) * textLength);
+  printf("  %-14s %8.2fns per glyph (checksum %g)\n", name, nanoseconds, checksum);
+  return nanoseconds;
+}
+
+static int benchLookup(const std::vector<std::string>& paths)
+{
+  int result = 0;
+  for(auto iter = paths.begin(); iter != paths.end(); ++iter)
+  {
+    std::shared_ptr<DirectX::FileMapping> data;
+    DirectX::SpriteFontView view;
+    if(!loadFont(*iter, &data, &view))
+    {
+      result = 1;
+      continue;
+    }
+
+    printf("%s: %u glyphs\n", iter->c_str(), view.glyphCount);
+    double binarySearch = benchmark("binary search", view.glyphs, view.glyphCount, false);
+    double directTable = benchmark("GlyphLookup", view.glyphs, view.glyphCount, true);
+    printf("  %.1fx faster\n", binarySearch / directTable);
+  }
+  return result;
+}
+
+static void printUsage()
+{
+  fprintf(stderr, "Usage: SpriteFontTool validate|dump|bench-parse|bench-lookup path...\n"
+                  "Each path may be a .spritefont file or a directory of them.\n");
+}
+
+int main(int argc, char* argv[])
+{
+  if(argc < 3)
+  {
+    printUsage();
+    return 2;
+  }
+
+  std::vector<std::string> paths;
+  for(int i = 2; i < argc; ++i)
+  {
+    expandPath(argv[i], &paths);
+  }
+
+  if(strcmp(argv[1], "validate") == 0)
+  {
+    return validate(paths);
+  }
+  if(strcmp(argv[1], "dump") == 0)
+  {
+    return dump(paths);
+  }
+  if(strcmp(argv[1], "bench-parse") == 0)
+  {
+    return benchParse(paths);
+  }
+  if(strcmp(argv[1], "bench-lookup") == 0)
+  {
+    return benchLookup(paths);
+  }
+  printUsage();
+  return 2;
+}
@@ -0,0 +1,216 @@
+/*
+ * Checks TickConverter against exact integer rounding and against the floating point conversion
+ * that Model::update used before it, and measures what each costs per frame.
+ * Usage: TickConverterBenchmark [samples per frequency]
+ * Returns 1 if the converter rounds any tick count differently from exact round-half-up division,
+ * or differs from the old conversion anywhere other than within the old conversion's rounding error
+ * of a tie between two units.
+ */
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Clock.h"
+#include "TickConverter.h"
+
+static const int DEFAULT_SAMPLES = 20000000;
+/* The counter frequencies seen on Windows machines: the usual 10MHz, the ACPI and HPET
+   timers, a TSC divided down by 1024, the platform timer of some tablets, and a raw TSC */
+static const uint64_t FREQUENCIES[] = { 10000000, 3579545, 14318180, 2148437, 3312343, 24000000, 2994000000ULL };
+/* Frequencies above this have every tick offset within a second checked a stride apart, rather than all of them */
+static const uint64_t EXHAUSTIVE_FREQUENCY = 100000000;
+static const uint64_t SPARSE_STRIDE = 997;
+static const uint64_t SECONDS_PER_DAY = 24 * 60 * 60;
+/* The old conversion's error, in ulps of the units since the start, which is a few roundings of a double */
+static const double DOUBLE_ERROR_ULPS = 4.0;
+/* The benchmark's frames are this many ticks apart, which is 2000fps at 10MHz */
+static const uint64_t FRAME_TICKS = 5003;
+static const int TIMING_ITERATIONS = 20000000;
+
+/** The timer value, split as the display shows it */
+struct Display
+{
+  unsigned int high;
+  unsigned int low;
+};
+
+/**
+ * The conversion Model::update() made before TickConverter: the whole time since the start
+ * as a double, scaled to units and rounded, then trimmed to within the second.
+ */
+static Display convertWithDouble(uint64_t countSinceStart, uint64_t frequency)
+{
+  double secondsSinceStart = ((double)countSinceStart) / frequency;
+  uint64_t fullTimerValue = static_cast<uint64_t>(secondsSinceStart * 100000.0 + 0.5);
+  uint64_t trimmedHigh = (fullTimerValue / 100000) * 100000;
+  unsigned int iTimerValue = static_cast<unsigned int>(fullTimerValue - trimmedHigh);
+  Display display;
+  display.high = iTimerValue / 100;
+  display.low = iTimerValue - (display.high * 100);
+  return display;
+}
+
+/**
+ * The conversion Model::update() makes now, from the ticks into the current second.
+ */
+static Display convertWithConverter(const TickConverter& converter, uint64_t countSinceSecond)
+{
+  uint32_t units = converter.toUnits(countSinceSecond);
+  if(units == TickConverter::UNITS_PER_SECOND)
+  {
+    units = 0;
+  }
+  Display display;
+  TickConverter::splitUnits(units, &display.high, &display.low);
+  return display;
+}
+
+/** xorshift64*, so every run checks the same samples */
+static uint64_t randomState = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t nextRandom()
+{
+  randomState ^= randomState >> 12;
+  randomState ^= randomState << 25;
+  randomState ^= randomState >> 27;
+  return randomState * 2685821657736338717ULL;
+}
+
+/**
+ * Checks every tick offset within a second, or every SPARSE_STRIDE of them for fast clocks,
+ * against exact round-half-up division and splitting.
+ * @return the offsets that the converter rounded differently.
+ */
+static uint64_t checkExact(const TickConverter& converter, uint64_t frequency)
+{
+  uint64_t stride = frequency > EXHAUSTIVE_FREQUENCY ? SPARSE_STRIDE : 1;
+  uint64_t mismatches = 0;
+  for(uint64_t ticks = 0; ticks < frequency; ticks += stride)
+  {
+    uint64_t exact = (ticks * (2 * TickConverter::UNITS_PER_SECOND) + frequency) / (2 * frequency);
+    uint32_t units = converter.toUnits(ticks);
+    unsigned int high = 0;
+    unsigned int low = 0;
+    TickConverter::splitUnits(units, &high, &low);
+    if(units != exact || high != units / 100 || low != units % 100)
+    {
+      ++mismatches;
+    }
+  }
+  return mismatches;
+}
+
+/**
+ * Compares the converter with the old double conversion at counts sampled over a day.
+ * @param outTies set to the samples that differed at an exact tie between two units.
+ * @param outNearTies set to the samples that differed at a count closer to a tie than the old conversion's error.
+ * @return the samples that differed anywhere else.
+ */
+static uint64_t checkAgainstDouble(const TickConverter& converter, uint64_t frequency, int samples,
+                                   uint64_t* outTies, uint64_t* outNearTies)
+{
+  uint64_t dayTicks = frequency * SECONDS_PER_DAY;
+  uint64_t mismatches = 0;
+  *outTies = 0;
+  *outNearTies = 0;
+  for(int i = 0; i < samples; ++i)
+  {
+    uint64_t countSinceStart = nextRandom() % dayTicks;
+    Display before = convertWithDouble(countSinceStart, frequency);
+    Display after = convertWithConverter(converter, countSinceStart % frequency);
+    if(before.high != after.high || before.low != after.low)
+    {
+      /* At a tie, a count exactly half way between two units, or at a count closer to one than the
+         error in its double, the old conversion rounded whichever way that error happened to fall */
+      uint64_t remainder = (countSinceStart % frequency) * (2 * TickConverter::UNITS_PER_SECOND) % (2 * frequency);
+      uint64_t fromTie = remainder > frequency ? remainder - frequency : frequency - remainder;
+      double unitsSinceStart = static_cast<double>(countSinceStart) * TickConverter::UNITS_PER_SECOND / frequency;
+      double doubleError = DOUBLE_ERROR_ULPS * DBL_EPSILON * unitsSinceStart;
+      if(fromTie == 0)
+      {
+        ++*outTies;
+      }
+      else if(static_cast<double>(fromTie) / (2 * frequency) <= doubleError)
+      {
+        ++*outNearTies;
+      }
+      else
+      {
+        ++mismatches;
+      }
+    }
+  }
+  return mismatches;
+}
+
+/**
+ * Times each conversion over a run of frames, the way Model::update() makes them.
+ */
+static void benchmarkConversions(Clock* clock, uint64_t frequency)
+{
+  TickConverter converter(frequency);
+  unsigned int checksum = 0;
+
+  uint64_t start = clock->getCount();
+  uint64_t count = 0;
+  for(int i = 0; i < TIMING_ITERATIONS; ++i)
+  {
+    Display display = convertWithDouble(count, frequency);
+    checksum += display.high + display.low;
+    count += FRAME_TICKS;
+  }
+  uint64_t doubleTicks = clock->getCount() - start;
+
+  start = clock->getCount();
+  uint64_t secondStartCount = 0;
+  count = 0;
+  for(int i = 0; i < TIMING_ITERATIONS; ++i)
+  {
+    uint64_t countSinceSecond = count - secondStartCount;
+    while(countSinceSecond >= frequency)
+    {
+      secondStartCount += frequency;
+      countSinceSecond -= frequency;
+    }
+    Display display = convertWithConverter(converter, countSinceSecond);
+    checksum += display.high + display.low;
+    count += FRAME_TICKS;
+  }
+  uint64_t converterTicks = clock->getCount() - start;
+
+  double nsPerTick = 1000000000.0 / clock->getFrequency();
+  printf("Per frame: double %.2fns, converter %.2fns (checksum %u)\n",
+    doubleTicks * nsPerTick / TIMING_ITERATIONS, converterTicks * nsPerTick / TIMING_ITERATIONS, checksum);
+}
+
+int main(int argc, char* argv[])
+{
+  int samples = argc > 1 ? atoi(argv[1]) : DEFAULT_SAMPLES;
+  if(samples <= 0)
+  {
+    fprintf(stderr, "Usage: TickConverterBenchmark [samples per frequency]\n");
+    return 1;
+  }
+
+  bool passed = true;
+  printf("Mismatches against exact rounding, and against the old conversion over a day\n");
+  printf("%12s %10s %10s %10s %10s\n", "frequency", "exact", "ties", "near ties", "other");
+  for(size_t i = 0; i < sizeof(FREQUENCIES) / sizeof(FREQUENCIES[0]); ++i)
+  {
+    uint64_t frequency = FREQUENCIES[i];
+    TickConverter converter(frequency);
+    uint64_t exactMismatches = checkExact(converter, frequency);
+    uint64_t ties = 0;
+    uint64_t nearTies = 0;
+    uint64_t doubleMismatches = checkAgainstDouble(converter, frequency, samples, &ties, &nearTies);
+    printf("%12llu %10llu %10llu %10llu %10llu\n", (unsigned long long)frequency, (unsigned long long)exactMismatches,
+      (unsigned long long)ties, (unsigned long long)nearTies, (unsigned long long)doubleMismatches);
+    passed = passed && exactMismatches == 0 && doubleMismatches == 0;
+  }
+
+  benchmarkConversions(Clock::getSystemClock(), FREQUENCIES[0]);
+  if(!passed)
+  {
+    printf("FAILED\n");
+  }
+  return passed ? 0 : 1;
+}
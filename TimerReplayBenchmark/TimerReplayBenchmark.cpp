@@ -0,0 +1,141 @@
+/*
+ * Measures the per-frame cost of the timer, column and error logic by replaying a synthetic counter
+ * trace through TimerReplay, with no rendering.
+ * First checks that traces which run through the counter wrapping around show the same timer values
+ * and columns as one that does not, and returns 1 if they do not.
+ * Usage: TimerReplayBenchmark [frames] [outputs]
+ * Without arguments, 1000000 frames are replayed for each of 1, 2 and 4 outputs.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "Clock.h"
+#include "TimerReplay.h"
+
+static const int DEFAULT_FRAMES = 1000000;
+static const int DEFAULT_OUTPUTS[] = { 1, 2, 4 };
+/* QueryPerformanceCounter's usual frequency */
+static const uint64_t FREQUENCY = 10000000;
+/* The trace renders at 2000fps, with every output taking a tenth of a frame, to a 60Hz output */
+static const double FRAME_SECONDS = 1.0 / 2000.0;
+static const double RENDER_SECONDS = FRAME_SECONDS / 10.0;
+static const unsigned int REFRESH_NUMERATOR = 60;
+static const unsigned int REFRESH_DENOMINATOR = 1;
+/* Replays of each trace, of which the fastest is reported */
+static const int REPLAYS = 3;
+/* The wrap check's traces run for longer than TimingSession::EPOCH_REBASE_SECONDS, so they also cross a rebase */
+static const double WRAP_TRACE_SECONDS = 4000.0;
+static const double WRAP_FRAME_SECONDS = 1.0 / 100.0;
+static const int WRAP_OUTPUTS = 2;
+/* How long after the trace starts the counter wraps around, in seconds */
+static const double WRAP_AFTER_SECONDS[] = { 0.25, 15.0, 3700.0 };
+
+/**
+ * Replays the wrap check's trace from startingCount, and records what every output showed.
+ */
+static std::vector<TimerReplay::Sample> replayFrom(uint64_t startingCount)
+{
+  uint64_t frames = static_cast<uint64_t>(WRAP_TRACE_SECONDS / WRAP_FRAME_SECONDS);
+  ReplayClock clock(FREQUENCY, TimerReplay::generateTrace(FREQUENCY, startingCount, WRAP_OUTPUTS, WRAP_FRAME_SECONDS, RENDER_SECONDS, frames));
+  std::vector<TimerReplay::Sample> samples;
+  samples.reserve(static_cast<size_t>(frames * WRAP_OUTPUTS));
+  TimerReplay::run(&clock, WRAP_OUTPUTS, REFRESH_NUMERATOR, REFRESH_DENOMINATOR, &samples);
+  return samples;
+}
+
+/**
+ * Starts the counter just before it wraps around past 2^64, and checks that every output shows
+ * the same timer value and column on every frame as when it starts from 0.
+ * @return false if any did not.
+ */
+static bool checkCounterWrap()
+{
+  std::vector<TimerReplay::Sample> expected = replayFrom(0);
+  bool passed = true;
+  for(size_t i = 0; i < sizeof(WRAP_AFTER_SECONDS) / sizeof(WRAP_AFTER_SECONDS[0]); ++i)
+  {
+    uint64_t startingCount = 0ULL - static_cast<uint64_t>(WRAP_AFTER_SECONDS[i] * FREQUENCY);
+    std::vector<TimerReplay::Sample> samples = replayFrom(startingCount);
+    size_t mismatches = 0;
+    size_t firstMismatch = 0;
+    for(size_t sample = 0; sample < expected.size() && sample < samples.size(); ++sample)
+    {
+      if(samples[sample].timerValue.high != expected[sample].timerValue.high ||
+         samples[sample].timerValue.low != expected[sample].timerValue.low ||
+         samples[sample].column != expected[sample].column)
+      {
+        firstMismatch = mismatches == 0 ? sample : firstMismatch;
+        ++mismatches;
+      }
+    }
+    if(samples.size() != expected.size())
+    {
+      printf("Counter wrap after %.2fs: FAILED, %llu samples instead of %llu\n", WRAP_AFTER_SECONDS[i],
+        (unsigned long long)samples.size(), (unsigned long long)expected.size());
+      passed = false;
+    }
+    else if(mismatches > 0)
+    {
+      printf("Counter wrap after %.2fs: FAILED, %llu of %llu samples differ, the first at frame %llu\n", WRAP_AFTER_SECONDS[i],
+        (unsigned long long)mismatches, (unsigned long long)samples.size(), (unsigned long long)(firstMismatch / WRAP_OUTPUTS));
+      passed = false;
+    }
+    else
+    {
+      printf("Counter wrap after %.2fs: %llu samples match\n", WRAP_AFTER_SECONDS[i], (unsigned long long)samples.size());
+    }
+  }
+  return passed;
+}
+
+static void benchmarkOutputs(int outputCount, int frames)
+{
+  std::vector<uint64_t> trace = TimerReplay::generateTrace(FREQUENCY, 0, outputCount, FRAME_SECONDS, RENDER_SECONDS, frames);
+  ReplayClock clock(FREQUENCY, trace);
+  TimerReplay::Result fastest;
+  for(int replay = 0; replay < REPLAYS; ++replay)
+  {
+    clock.rewind();
+    TimerReplay::Result result = TimerReplay::run(&clock, outputCount, REFRESH_NUMERATOR, REFRESH_DENOMINATOR);
+    if(replay == 0 || result.nanosecondsPerFrame < fastest.nanosecondsPerFrame)
+    {
+      fastest = result;
+    }
+  }
+  printf("%7d %10llu %10.3f %10.1f %10.1f %10.2f\n", outputCount, (unsigned long long)fastest.frames, fastest.seconds,
+    fastest.nanosecondsPerFrame, fastest.nanosecondsPerFrame / outputCount, fastest.frames / fastest.seconds / 1000000.0);
+}
+
+int main(int argc, char* argv[])
+{
+  int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+  int outputs = argc > 2 ? atoi(argv[2]) : 0;
+  if(frames <= 0 || outputs < 0)
+  {
+    fprintf(stderr, "Usage: TimerReplayBenchmark [frames] [outputs]\n");
+    return 1;
+  }
+
+  std::vector<int> outputCounts;
+  if(outputs > 0)
+  {
+    outputCounts.push_back(outputs);
+  }
+  else
+  {
+    outputCounts.assign(DEFAULT_OUTPUTS, DEFAULT_OUTPUTS + sizeof(DEFAULT_OUTPUTS) / sizeof(DEFAULT_OUTPUTS[0]));
+  }
+
+  if(!checkCounterWrap())
+  {
+    return 1;
+  }
+
+  printf("Fastest of %d replays, frames at %.0ffps\n", REPLAYS, 1.0 / FRAME_SECONDS);
+  printf("%7s %10s %10s %10s %10s %10s\n", "outputs", "frames", "seconds", "ns/frame", "ns/output", "Mframes/s");
+  for(auto iter = outputCounts.begin(); iter != outputCounts.end(); ++iter)
+  {
+    benchmarkOutputs(*iter, frames);
+  }
+  return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * Measures the CPU cost of drawing InputLagTimer's grid of timer values on a 3840x2160 output,
+ * through SpriteFont and the sprite queue as InputLagTimer used to, and through TimerTextRenderer.
+ * Usage: TimerTextBenchmark [frames] [timer font directory]
+ * The fonts default to InputLagTimer's, from the project directory.
+ */
+#include <windows.h>
+#include <d3d11.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include "SpriteBatch.h"
+#include "SpriteFont.h"
+#include "FileMapping.h"
+#include "SpriteFontParser.h"
+#include "D3D11RenderBackend.h"
+#include "FontFace.h"
+#include "TimerTextRenderer.h"
+
+static_assert(sizeof(TimerTextRenderer::Position) == sizeof(DirectX::XMFLOAT2), "A row's position must be the same to SpriteFont and TimerTextRenderer");
+
+static const int DEFAULT_FRAMES = 2000;
+static const wchar_t DEFAULT_FONT_DIRECTORY[] = L"..\\InputLagTimer\\res\\fonts\\timer\\";
+static const int OUTPUT_WIDTH = 3840;
+static const int OUTPUT_HEIGHT = 2160;
+/* The same layout as InputLagTimer's Window, with the default of 2 columns per font */
+static const int TIMER_VALUE_PADDING = 10;
+static const int COLUMN_SEPARATOR_WIDTH = 15;
+static const int COLUMNS_PER_FONT = 2;
+/* Drawn to, so that the GPU work is as small as it can be while every vertex is still submitted */
+static const int TARGET_SIZE = 64;
+
+/**
+ * A font's rows of timer values, in the column that the model has selected.
+ */
+struct TimerColumn
+{
+  DirectX::SpriteFont* font;
+  TimerTextRenderer* text;
+  std::vector<DirectX::XMFLOAT2> rows;
+};
+
+/**
+ * A timer font, created on the device twice: as a SpriteFont, and as a texture for the FontFace as InputLagTimer creates it.
+ */
+struct TimerFont
+{
+  DirectX::SpriteFont* spriteFont;
+  ID3D11ShaderResourceView* texture;
+  FontFace* face;
+  TimerTextRenderer* text;
+};
+
+/**
+ * Lays out the columns as Window::layoutColumns() does, for as many fonts as fit across the output.
+ */
+static void layoutColumns(const std::vector<TimerFont>& fonts, std::vector<TimerColumn>* outColumns)
+{
+  int x = TIMER_VALUE_PADDING;
+  for(size_t i = 0; i < fonts.size() && x < OUTPUT_WIDTH; ++i)
+  {
+    DirectX::XMFLOAT2 textSize;
+    DirectX::XMStoreFloat2(&textSize, fonts[i].spriteFont->MeasureString(L"888.88"));
+    int textWidth = static_cast<int>(ceilf(textSize.x));
+    int lineHeight = static_cast<int>(ceilf(textSize.y));
+
+    TimerColumn column;
+    column.font = fonts[i].spriteFont;
+    column.text = fonts[i].text;
+    for(int y = TIMER_VALUE_PADDING; y < OUTPUT_HEIGHT; y += lineHeight + TIMER_VALUE_PADDING)
+    {
+      column.rows.push_back(DirectX::XMFLOAT2(static_cast<float>(x), static_cast<float>(y)));
+    }
+    outColumns->push_back(column);
+
+    x += textWidth * COLUMNS_PER_FONT + COLUMN_SEPARATOR_WIDTH;
+  }
+}
+
+/**
+ * Waits for the device to finish everything submitted, so that one path's work is not left running during the other's.
+ */
+static void waitForDevice(ID3D11DeviceContext* context, ID3D11Query* query)
+{
+  context->End(query);
+  context->Flush();
+  while(context->GetData(query, NULL, 0, 0) == S_FALSE)
+  {
+    SwitchToThread();
+  }
+}
+
+/**
+ * Draws the grid every frame with a new timer string, and prints how long the CPU took to submit it.
+ * Only the time between the sprite batch's Begin and End is measured.
+ * @param backend draws through TimerTextRenderer when it is not NULL, and SpriteFont draws through spriteBatch when it is.
+ */
+static void benchmarkPath(const char* name, D3D11RenderBackend* backend, int frames, const std::vector<TimerColumn>& columns,
+                          DirectX::SpriteBatch* spriteBatch, ID3D11DeviceContext* context, ID3D11Query* query)
+{
+  size_t glyphsPerFrame = 0;
+  for(auto iter = columns.begin(); iter != columns.end(); ++iter)
+  {
+    glyphsPerFrame += iter->rows.size() * 6;
+  }
+
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  DirectX::SpriteFont::PreparedString prepared;
+  static const float colour[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+  LONGLONG totalCounts = 0;
+
+  waitForDevice(context, query);
+  for(int frame = 0; frame < frames; ++frame)
+  {
+    wchar_t timerString[7];
+    swprintf_s(timerString, L"%03d.%02d", (frame / 100) % 1000, frame % 100);
+
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    if(backend)
+    {
+      /* The backend begins the batch with the first draw, and present() ends it without a swap chain to present */
+      for(auto iter = columns.begin(); iter != columns.end(); ++iter)
+      {
+        const TimerTextRenderer::Position* positions = reinterpret_cast<const TimerTextRenderer::Position*>(iter->rows.data());
+        iter->text->draw(backend, timerString, positions, iter->rows.size(), colour);
+      }
+      backend->present();
+    }
+    else
+    {
+      spriteBatch->Begin(DirectX::SpriteSortMode_Deferred);
+      for(auto iter = columns.begin(); iter != columns.end(); ++iter)
+      {
+        iter->font->PrepareString(timerString, &prepared);
+        iter->font->DrawPreparedString(spriteBatch, prepared, iter->rows.data(), iter->rows.size(), DirectX::Colors::White);
+      }
+      spriteBatch->End();
+    }
+    LARGE_INTEGER end;
+    QueryPerformanceCounter(&end);
+    totalCounts += end.QuadPart - start.QuadPart;
+
+    waitForDevice(context, query);
+  }
+
+  double seconds = static_cast<double>(totalCounts) / frequency.QuadPart;
+  double vertices = static_cast<double>(glyphsPerFrame) * 4 * frames;
+  printf("%-14s %8u glyphs/frame %10.1fus/frame %10.1fM vertices/s\n",
+    name, static_cast<unsigned int>(glyphsPerFrame), seconds * 1000000.0 / frames, vertices / seconds / 1000000.0);
+}
+
+int main(int argc, char* argv[])
+{
+  int frames = argc > 1 ? atoi(argv[1]) : DEFAULT_FRAMES;
+  if(frames <= 0)
+  {
+    fprintf(stderr, "Usage: TimerTextBenchmark [frames] [timer font directory]\n");
+    return 1;
+  }
+  std::wstring fontDirectory = DEFAULT_FONT_DIRECTORY;
+  if(argc > 2)
+  {
+    wchar_t path[MAX_PATH];
+    MultiByteToWideChar(CP_ACP, 0, argv[2], -1, path, MAX_PATH);
+    fontDirectory = path;
+    if(fontDirectory.back() != L'\\' && fontDirectory.back() != L'/')
+    {
+      fontDirectory += L'\\';
+    }
+  }
+
+  /* WARP keeps the measurement about the CPU work of building and submitting vertices, on any machine */
+  ID3D11Device* device = NULL;
+  ID3D11DeviceContext* context = NULL;
+  if(FAILED(D3D11CreateDevice(NULL, D3D_DRIVER_TYPE_WARP, NULL, 0, NULL, 0, D3D11_SDK_VERSION, &device, NULL, &context)))
+  {
+    fprintf(stderr, "Could not create a WARP device\n");
+    return 1;
+  }
+
+  ID3D11Texture2D* target = NULL;
+  ID3D11RenderTargetView* targetView = NULL;
+  CD3D11_TEXTURE2D_DESC targetDesc(DXGI_FORMAT_R8G8B8A8_UNORM, TARGET_SIZE, TARGET_SIZE, 1, 1, D3D11_BIND_RENDER_TARGET);
+  device->CreateTexture2D(&targetDesc, NULL, &target);
+  device->CreateRenderTargetView(target, NULL, &targetView);
+  context->OMSetRenderTargets(1, &targetView, NULL);
+  /* The viewport is the output's size, so the batch transforms to it; everything outside the small target is clipped */
+  CD3D11_VIEWPORT viewport(0.0f, 0.0f, static_cast<float>(OUTPUT_WIDTH), static_cast<float>(OUTPUT_HEIGHT));
+  context->RSSetViewports(1, &viewport);
+
+  ID3D11Query* query = NULL;
+  CD3D11_QUERY_DESC queryDesc(D3D11_QUERY_EVENT);
+  device->CreateQuery(&queryDesc, &query);
+
+  std::vector<TimerFont> fonts;
+  WIN32_FIND_DATAW findData;
+  HANDLE find = FindFirstFileW((fontDirectory + L"*.spritefont").c_str(), &findData);
+  if(find != INVALID_HANDLE_VALUE)
+  {
+    do
+    {
+      DirectX::BinaryReader reader(DirectX::FileMapping::Open(fontDirectory + findData.cFileName));
+      DirectX::SpriteFontView view;
+      DirectX::ParseSpriteFont(&reader, &view);
+
+      TimerFont font;
+      font.spriteFont = new DirectX::SpriteFont(device, view);
+      font.texture = NULL;
+      DirectX::CreateSpriteFontTexture(device, view, &font.texture);
+      font.face = new FontFace(view, font.texture);
+      font.text = new TimerTextRenderer(font.face);
+      fonts.push_back(font);
+    } while(FindNextFileW(find, &findData));
+    FindClose(find);
+  }
+  if(fonts.empty())
+  {
+    fwprintf(stderr, L"No .spritefont files in %s\n", fontDirectory.c_str());
+    return 1;
+  }
+
+  std::vector<TimerColumn> columns;
+  layoutColumns(fonts, &columns);
+  printf("%d fonts, %d frames of a %dx%d output\n", static_cast<int>(columns.size()), frames, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+
+  {
+    DirectX::SpriteBatch spriteBatch(context);
+    D3D11RenderBackend backend(context, &spriteBatch, NULL, NULL, NULL);
+    backend.setTarget(targetView, NULL, OUTPUT_WIDTH, OUTPUT_HEIGHT);
+    benchmarkPath("SpriteFont", NULL, frames, columns, &spriteBatch, context, query);
+    benchmarkPath("TimerText", &backend, frames, columns, &spriteBatch, context, query);
+  }
+
+  for(auto iter = fonts.begin(); iter != fonts.end(); ++iter)
+  {
+    delete iter->text;
+    delete iter->face;
+    if(iter->texture)
+    {
+      iter->texture->Release();
+    }
+    delete iter->spriteFont;
+  }
+  query->Release();
+  targetView->Release();
+  target->Release();
+  context->Release();
+  device->Release();
+  return 0;
+}